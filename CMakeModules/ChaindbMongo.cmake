@@ -39,6 +39,7 @@ if (BUILD_CYBERWAY_CHAINDB_MONGO)
         set(CHAINDB_SRCS ${CHAINDB_SRCS}
             chaindb/mongo_driver.cpp
             chaindb/mongo_driver_utils.cpp
+            chaindb/mongo_resident_table.cpp
             chaindb/mongo_bigint_converter.cpp
             chaindb/mongo_asset_converter.cpp)
 
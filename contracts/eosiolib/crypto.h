@@ -190,6 +190,80 @@ void sha512( const char* data, uint32_t length, checksum512* hash );
  */
 void ripemd160( const char* data, uint32_t length, checksum160* hash );
 
+/**
+ *  @brief Part of the data buffer hashed by the batch hashing functions.
+ */
+struct hash_segment {
+   uint32_t offset; ///< offset from the beginning of the data buffer
+   uint32_t length; ///< length of the part
+};
+
+/**
+ *  Hashes several parts of `data` using `sha256` in one call and stores results in the array pointed to by hashes.
+ *  Results are the same as those of `sha256` called for each part, but without the overhead of a call per part.
+ *  @brief Hashes several parts of `data` using `sha256`.
+ *
+ *  @param data - Data buffer which contains all parts
+ *  @param length - Data buffer length
+ *  @param segments - Parts of the data buffer to hash
+ *  @param count - Number of parts
+ *  @param hashes - Array of hashes, i-th hash is calculated for i-th part
+ *  @param hashes_count - Number of hashes, should be equal to the number of parts
+ *
+ *  Example:
+*
+ *  @code
+ *  char data[] = "firstsecond";
+ *  hash_segment segments[] = { {0, 5}, {5, 6} };
+ *  checksum256 hashes[2];
+ *  sha256_batch( data, sizeof(data) - 1, segments, 2, hashes, 2 );
+ *  @endcode
+ */
+void sha256_batch( const char* data, uint32_t length, const struct hash_segment* segments, uint32_t count,
+                   checksum256* hashes, uint32_t hashes_count );
+
+/**
+ *  Hashes several parts of `data` using `sha1` in one call and stores results in the array pointed to by hashes.
+ *  @brief Hashes several parts of `data` using `sha1`.
+ *
+ *  @param data - Data buffer which contains all parts
+ *  @param length - Data buffer length
+ *  @param segments - Parts of the data buffer to hash
+ *  @param count - Number of parts
+ *  @param hashes - Array of hashes, i-th hash is calculated for i-th part
+ *  @param hashes_count - Number of hashes, should be equal to the number of parts
+ */
+void sha1_batch( const char* data, uint32_t length, const struct hash_segment* segments, uint32_t count,
+                 checksum160* hashes, uint32_t hashes_count );
+
+/**
+ *  Hashes several parts of `data` using `sha512` in one call and stores results in the array pointed to by hashes.
+ *  @brief Hashes several parts of `data` using `sha512`.
+ *
+ *  @param data - Data buffer which contains all parts
+ *  @param length - Data buffer length
+ *  @param segments - Parts of the data buffer to hash
+ *  @param count - Number of parts
+ *  @param hashes - Array of hashes, i-th hash is calculated for i-th part
+ *  @param hashes_count - Number of hashes, should be equal to the number of parts
+ */
+void sha512_batch( const char* data, uint32_t length, const struct hash_segment* segments, uint32_t count,
+                   checksum512* hashes, uint32_t hashes_count );
+
+/**
+ *  Hashes several parts of `data` using `ripemod160` in one call and stores results in the array pointed to by hashes.
+ *  @brief Hashes several parts of `data` using `ripemod160`.
+ *
+ *  @param data - Data buffer which contains all parts
+ *  @param length - Data buffer length
+ *  @param segments - Parts of the data buffer to hash
+ *  @param count - Number of parts
+ *  @param hashes - Array of hashes, i-th hash is calculated for i-th part
+ *  @param hashes_count - Number of hashes, should be equal to the number of parts
+ */
+void ripemd160_batch( const char* data, uint32_t length, const struct hash_segment* segments, uint32_t count,
+                      checksum160* hashes, uint32_t hashes_count );
+
 /**
  *  Calculates the public key used for a given signature and hash used to create a message.
  *  @brief Calculates the public key used for a given signature and hash used to create a message.
@@ -121,6 +121,8 @@ extern "C" {
       WASM_TEST_HANDLER(test_crypto, assert_sha512_true);
       WASM_TEST_HANDLER(test_crypto, assert_ripemd160_false);
       WASM_TEST_HANDLER(test_crypto, assert_ripemd160_true);
+      WASM_TEST_HANDLER(test_crypto, test_hash_batch);
+      WASM_TEST_HANDLER(test_crypto, hash_batch_out_of_data);
 
       //test transaction
       WASM_TEST_HANDLER(test_transaction, test_tapos_block_num);
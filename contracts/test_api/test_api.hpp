@@ -150,6 +150,8 @@ struct test_crypto {
    static void assert_sha1_true();
    static void assert_sha512_true();
    static void assert_ripemd160_true();
+   static void test_hash_batch();
+   static void hash_batch_out_of_data();
 };
 
 struct test_transaction {
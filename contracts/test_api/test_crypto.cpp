@@ -434,3 +434,41 @@ void test_crypto::assert_ripemd160_true() {
   ripemd160( (char *)test5, my_strlen(test5), &tmp );
   assert_ripemd160( (char *)test5, my_strlen(test5), &tmp);
 }
+
+void test_crypto::test_hash_batch() {
+
+  // test4 starts with test1, and an empty segment hashes as test2
+  const hash_segment segments[] = { {0, my_strlen(test1)}, {5, 0}, {0, my_strlen(test4)} };
+  const uint32_t count = sizeof(segments) / sizeof(segments[0]);
+
+  checksum160 tmp1[count];
+  sha1_batch( (char *)test4, my_strlen(test4), segments, count, tmp1, count );
+  eosio_assert( my_memcmp((void *)test1_ok_1, &tmp1[0], sizeof(checksum160)), "sha1_batch test1" );
+  eosio_assert( my_memcmp((void *)test2_ok_1, &tmp1[1], sizeof(checksum160)), "sha1_batch test2" );
+  eosio_assert( my_memcmp((void *)test4_ok_1, &tmp1[2], sizeof(checksum160)), "sha1_batch test4" );
+
+  checksum256 tmp256[count];
+  sha256_batch( (char *)test4, my_strlen(test4), segments, count, tmp256, count );
+  eosio_assert( my_memcmp((void *)test1_ok_256, &tmp256[0], sizeof(checksum256)), "sha256_batch test1" );
+  eosio_assert( my_memcmp((void *)test2_ok_256, &tmp256[1], sizeof(checksum256)), "sha256_batch test2" );
+  eosio_assert( my_memcmp((void *)test4_ok_256, &tmp256[2], sizeof(checksum256)), "sha256_batch test4" );
+
+  checksum512 tmp512[count];
+  sha512_batch( (char *)test4, my_strlen(test4), segments, count, tmp512, count );
+  eosio_assert( my_memcmp((void *)test1_ok_512, &tmp512[0], sizeof(checksum512)), "sha512_batch test1" );
+  eosio_assert( my_memcmp((void *)test2_ok_512, &tmp512[1], sizeof(checksum512)), "sha512_batch test2" );
+  eosio_assert( my_memcmp((void *)test4_ok_512, &tmp512[2], sizeof(checksum512)), "sha512_batch test4" );
+
+  checksum160 tmp_ripe[count];
+  ripemd160_batch( (char *)test4, my_strlen(test4), segments, count, tmp_ripe, count );
+  eosio_assert( my_memcmp((void *)test1_ok_ripe, &tmp_ripe[0], sizeof(checksum160)), "ripemd160_batch test1" );
+  eosio_assert( my_memcmp((void *)test2_ok_ripe, &tmp_ripe[1], sizeof(checksum160)), "ripemd160_batch test2" );
+  eosio_assert( my_memcmp((void *)test4_ok_ripe, &tmp_ripe[2], sizeof(checksum160)), "ripemd160_batch test4" );
+}
+
+void test_crypto::hash_batch_out_of_data() {
+  const hash_segment segments[] = { {0, my_strlen(test1) + 1} };
+  checksum256 tmp;
+  sha256_batch( (char *)test1, my_strlen(test1), segments, 1, &tmp, 1 );
+  eosio_assert(false, "should have failed");
+}
@@ -5,6 +5,7 @@
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/wasm_interface.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/account_object.hpp>
@@ -415,6 +416,8 @@ void apply_context::schedule_deferred_transaction( const uint128_t& sender_id, a
 //      // TODO: The logic of the next line needs to be incorporated into the next hard fork.
 //      // add_ram_usage( ptr->payer, -(config::billable_size_v<generated_transaction_object> + ptr->packed_trx.size()) );
 
+      auto& scheduler = control.get_mutable_deferred_scheduler();
+      scheduler.remove( ptr->trx_id );
       chaindb.modify( *ptr, get_storage_payer(owner), [&]( auto& gtx ) {
             gtx.trx_id      = trx.id();
             gtx.sender      = receiver;
@@ -425,9 +428,10 @@ void apply_context::schedule_deferred_transaction( const uint128_t& sender_id, a
 
             trx_size = gtx.set( trx );
             push_event({name(), name("senddeferred"), fc::raw::pack(generated_transaction(gtx))});
+            scheduler.add( gtx, trx );
          });
    } else {
-      chaindb.emplace<generated_transaction_object>( get_storage_payer(owner), [&]( auto& gtx ) {
+      const auto& gto = chaindb.emplace<generated_transaction_object>( get_storage_payer(owner), [&]( auto& gtx ) {
             gtx.trx_id      = trx.id();
             gtx.sender      = receiver;
             gtx.sender_id   = sender_id;
@@ -438,6 +442,7 @@ void apply_context::schedule_deferred_transaction( const uint128_t& sender_id, a
             trx_size = gtx.set( trx );
             push_event({name(), name("senddeferred"), fc::raw::pack(generated_transaction(gtx))});
          });
+      control.get_mutable_deferred_scheduler().add( gto, trx );
    }
 
 // TODO: Removed by CyberWay
@@ -470,6 +475,7 @@ bool apply_context::cancel_deferred_transaction( const uint128_t& sender_id, acc
    if ( gto ) {
 // TODO: Removed by CyberWay
 //      add_ram_usage( gto->payer, -(config::billable_size_v<generated_transaction_object> + gto->packed_trx.size()) );
+      control.get_mutable_deferred_scheduler().remove( gto->trx_id );
       trx_table.erase(*gto, get_storage_payer());
       push_event({name(), name("canceldefer"), fc::raw::pack(std::make_pair(sender, sender_id))});
    }
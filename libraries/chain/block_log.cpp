@@ -4,9 +4,17 @@
  */
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fstream>
+#include <atomic>
+#include <mutex>
+#include <cctype>
+#include <cstdio>
 #include <fc/io/raw.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
 #include <boost/filesystem.hpp>
 // #include <boost/thread/shared_mutex.hpp>
 
@@ -20,6 +28,16 @@ namespace eosio { namespace chain {
     * Version 1: complete block log from genesis
     * Version 2: adds optional partial block log, cannot be used for replay without snapshot
     *            this is in the form of an first_block_num that is written immediately after the version
+    *            (CyberWay uses it for the active file and the segments of a segmented block log)
+    *
+    * Compressed segment (blocks-<first_block_num>.zlog):
+    * +---------+-----------------+------------------+---------+---------+-----+---------+
+    * | Version | First block num | Blocks per chunk | Chunk 1 | Chunk 2 | ... | Chunk N |
+    * +---------+-----------------+------------------+---------+---------+-----+---------+
+    *
+    * Each chunk is a header (block count, raw size, packed size) followed by zlib compressed data:
+    * offsets of the blocks inside of the chunk and packed blocks. The chunk index (blocks-<first_block_num>.zindex)
+    * contains positions of the chunks in the compressed file.
     */
 
    namespace detail {
@@ -30,7 +48,30 @@ namespace eosio { namespace chain {
       using boost::iostreams::mapped_file;
       static constexpr boost::iostreams::stream_offset min_valid_file_size = sizeof(uint32_t);
       static constexpr uint32_t min_supported_version = 1;
-      static constexpr uint32_t max_supported_version = 1;
+      static constexpr uint32_t max_supported_version = 2;
+      static constexpr uint32_t compressed_log_version = 1;
+
+      static fc::path segment_path(const fc::path& data_dir, const uint32_t first_block_num, const char* ext) {
+          char name[32];
+          std::snprintf(name, sizeof(name), "blocks-%010u.%s", first_block_num, ext);
+          return data_dir / name;
+      }
+
+      static bool parse_segment_path(const boost::filesystem::path& path, uint32_t& first_block_num, std::string& ext) {
+          auto name = path.filename().string();
+          auto dot = name.find('.');
+          if (name.size() < 18 || name.compare(0, 7, "blocks-") || dot != 17) {
+              return false;
+          }
+          for (auto i = 7; i < 17; ++i) {
+              if (!std::isdigit(name[i])) {
+                  return false;
+              }
+          }
+          first_block_num = std::stoul(name.substr(7, 10));
+          ext = name.substr(dot + 1);
+          return true;
+      }
 
       class block_log_impl {
          public:
@@ -44,10 +85,10 @@ namespace eosio { namespace chain {
             // read_write_mutex         mutex;
 
             uint32_t                 version = 0;
+            uint32_t                 first_block_num = 1;
 
             // TODO: removed by CyberWay
             //bool                     genesis_written_to_block_log = false;
-            //uint32_t                 first_block_num = 0;
 
             bool has_block_records() const {
                 auto size = block_mapped_file.size();
@@ -106,16 +147,48 @@ namespace eosio { namespace chain {
                 return value;
             }
 
+            std::size_t header_size() const {
+                return version > 1 ? sizeof(version) + sizeof(first_block_num) : sizeof(version);
+            }
+
+            void read_header() {
+                version = get_uint32(block_mapped_file, 0);
+                EOS_ASSERT(version >= min_supported_version && version <= max_supported_version, block_log_unsupported_version,
+                        "Unsupported version of block log. Block log version is ${version} while code supports version(s) [${min},${max}]",
+                        ("version", version)("min", min_supported_version)("max", max_supported_version) );
+
+                first_block_num = 1;
+                if (version > 1) {
+                    first_block_num = get_uint32(block_mapped_file, sizeof(version));
+                }
+            }
+
             uint64_t get_block_pos(uint32_t block_num) const {
                 if (head.get() != nullptr &&
                     block_num <= block_header::num_from_id(head_id) &&
-                    block_num > 0
+                    block_num >= first_block_num
                 ) {
-                    return get_uint64(index_mapped_file, sizeof(uint64_t) * (block_num - 1));
+                    return get_uint64(index_mapped_file, sizeof(uint64_t) * (block_num - first_block_num));
                 }
                 return block_log::npos;
             }
 
+            // returns the packed block without reading of it
+            std::pair<const char*, std::size_t> get_block_data(uint32_t block_num) const {
+                auto pos = get_block_pos(block_num);
+                EOS_ASSERT(pos != block_log::npos, block_log_exception,
+                        "Block ${block_num} doesn't exist in block log", ("block_num", block_num));
+
+                uint64_t end_pos = get_mapped_size(block_mapped_file);
+                if (block_num < block_header::num_from_id(head_id)) {
+                    end_pos = get_block_pos(block_num + 1);
+                }
+                EOS_ASSERT(end_pos > pos + sizeof(uint64_t), block_log_exception,
+                        "Wrong position of block ${block_num}", ("block_num", block_num)("pos", pos)("end_pos", end_pos));
+
+                return {block_mapped_file.const_data() + pos, end_pos - pos - sizeof(uint64_t)};
+            }
+
             uint64_t read_block(uint64_t pos, signed_block& block) const {
                 const auto file_size = get_mapped_size(block_mapped_file);
                 EOS_ASSERT(pos < file_size,
@@ -141,7 +214,7 @@ namespace eosio { namespace chain {
             }
 
             signed_block_ptr read_head() const {
-                if (get_mapped_size(block_mapped_file) == 0) {
+                if (!has_block_records()) {
                     return {};
                 }
                 auto pos = get_last_uint64(block_mapped_file);
@@ -173,9 +246,9 @@ namespace eosio { namespace chain {
                 index_mapped_file.close();
                 boost::filesystem::remove_all(index_path);
                 open_index_mapped_file();
-                index_mapped_file.resize(head->block_num() * sizeof(uint64_t));
+                index_mapped_file.resize((head->block_num() - first_block_num + 1) * sizeof(uint64_t));
 
-                uint64_t pos = sizeof(uint32_t); // version
+                uint64_t pos = header_size();
                 uint64_t end_pos = get_last_uint64(block_mapped_file);
                 auto* idx_ptr = index_mapped_file.data();
                 signed_block tmp_block;
@@ -183,18 +256,25 @@ namespace eosio { namespace chain {
                 while (pos <= end_pos) {
                     *reinterpret_cast<uint64_t*>(idx_ptr) = pos;
                     pos = read_block(pos, tmp_block);
-                    ilog("Read block: ${block_id} ${previous}", ("block_id",tmp_block.id())("previous",tmp_block.previous));
+                    if (tmp_block.block_num() % 100000 == 0) {
+                        ilog("Read block ${n} of ${head}", ("n", tmp_block.block_num())("head", head->block_num()));
+                    }
                     idx_ptr += sizeof(pos);
                 }
             }
 
-            void open(const fc::path& data_dir) { try {
+            void open(const fc::path& data_dir) {
+                open(data_dir / "blocks.log", data_dir / "blocks.index");
+            }
+
+            void open(const fc::path& block_file, const fc::path& index_file) { try {
                 block_mapped_file.close();
                 index_mapped_file.close();
 
-                block_path = (data_dir / "blocks.log").string();
-                index_path = (data_dir / "blocks.index").string();
- 
+                block_path = block_file.string();
+                index_path = index_file.string();
+                first_block_num = 1;
+
                 open_block_mapped_file();
                 open_index_mapped_file();
 
@@ -220,11 +300,7 @@ namespace eosio { namespace chain {
                 if (has_block_records()) {
                     ilog("Log is nonempty");
 
-                    version = get_uint32(block_mapped_file, 0);
-                    EOS_ASSERT(version >= min_supported_version && version <= max_supported_version, block_log_unsupported_version,
-                            "Unsupported version of block log. Block log version is ${version} while code supports version(s) [${min},${max}]",
-                            ("version", version)("min", min_supported_version)("max", max_supported_version) );
-
+                    read_header();
                     head = read_head();
                     head_id = head->id();
 
@@ -252,10 +328,13 @@ namespace eosio { namespace chain {
 
                     open_block_mapped_file();
                     open_index_mapped_file();
+                } else if (get_mapped_size(block_mapped_file) > 0) {
+                    ilog("Log has only header");
+                    read_header();
                 }
             } FC_LOG_AND_RETHROW() }
 
-            void reset(const signed_block_ptr& first_block, const std::vector<char>& first_block_data) try {
+            void reset(const uint32_t first_num, const signed_block_ptr& first_block, const std::vector<char>& first_block_data) try {
                 block_mapped_file.close();
                 index_mapped_file.close();
 
@@ -265,9 +344,18 @@ namespace eosio { namespace chain {
                 open_block_mapped_file();
                 open_index_mapped_file();
 
-                block_mapped_file.resize(sizeof(uint32_t));
+                // version 1 is kept for a full block log to be readable by older versions
+                version = (first_num == 1) ? 1 : 2;
+                first_block_num = first_num;
+                head.reset();
+                head_id = block_id_type();
+
+                block_mapped_file.resize(header_size());
                 auto* ptr = block_mapped_file.data();
-                *reinterpret_cast<uint32_t*>(ptr) = max_supported_version;
+                *reinterpret_cast<uint32_t*>(ptr) = version;
+                if (version > 1) {
+                    *reinterpret_cast<uint32_t*>(ptr + sizeof(version)) = first_block_num;
+                }
 
                 if (first_block) {
                     append(first_block, first_block_data);
@@ -289,11 +377,12 @@ namespace eosio { namespace chain {
                     "Block size to large (current ${size}, maximum ${max})",
                     ("size", data.size())("max", eosio::chain::config::maximum_block_size));
 
-                EOS_ASSERT(index_pos == sizeof(uint64_t) * (block->block_num() - 1),
+                EOS_ASSERT(block->block_num() >= first_block_num &&
+                    index_pos == sizeof(uint64_t) * (block->block_num() - first_block_num),
                     block_log_exception,
                     "Append to index file occuring at wrong position.",
                     ("position", index_pos)
-                    ("expected", (block->block_num() - 1) * sizeof(uint64_t)));
+                    ("expected", (block->block_num() - first_block_num) * sizeof(uint64_t)));
 
                 uint64_t block_pos = get_mapped_size(block_mapped_file);
 
@@ -366,7 +455,10 @@ namespace eosio { namespace chain {
                 new_block_stream.write((char*)&version, sizeof(version));
 
                 uint32_t first_block_num = 1;
-                EOS_ASSERT(version == 1, block_log_exception, "Block log other versions than 1 isn't supported");
+                if (version != 1) {
+                    old_block_stream.read((char*)&first_block_num, sizeof(first_block_num));
+                    new_block_stream.write((char*)&first_block_num, sizeof(first_block_num));
+                }
 
 // TODO: removed in CyberWay
 //                if (version != 1) {
@@ -413,13 +505,16 @@ namespace eosio { namespace chain {
                     }
 
                     auto id = tmp.id();
-                    if (block_header::num_from_id(previous) + 1 != block_header::num_from_id(id)) {
+                    if (previous == block_id_type() && block_header::num_from_id(id) != first_block_num) {
+                        elog("Block ${num} (${id}) isn't the first block ${first} of block log",
+                            ("num", block_header::num_from_id(id))("id", id)("first", first_block_num));
+                    } else if (previous != block_id_type() && block_header::num_from_id(previous) + 1 != block_header::num_from_id(id)) {
                         elog("Block ${num} (${id}) skips blocks. "
                             "Previous block in block log is block ${prev_num} (${previous}).",
                             ("num", block_header::num_from_id(id))("id", id)
                             ("prev_num", block_header::num_from_id(previous))("previous", previous));
                     }
-                    if (previous != tmp.previous) {
+                    if (previous != block_id_type() && previous != tmp.previous) {
                         elog("Block ${num} (${id}) does not link back to previous block. "
                             "Expected previous: ${expected}. Actual previous: ${actual}.",
                             ("num", block_header::num_from_id(id))("id", id)("expected", previous)
@@ -495,23 +590,591 @@ namespace eosio { namespace chain {
                         ("num", block_num));
                 }
 
+                // closed segments aren't changed by repair
+                for (boost::filesystem::directory_iterator itr(backup_dir.string()), end; itr != end; ++itr) {
+                    uint32_t segment_num = 0;
+                    std::string ext;
+                    if (parse_segment_path(itr->path(), segment_num, ext)) {
+                        fc::copy(fc::path(itr->path().string()), blocks_dir / itr->path().filename().string());
+                    }
+                }
+
                 return backup_dir;
             }
       };
+
+      /**
+       * Closed part of block log, which contains the fixed range of irreversible blocks
+       */
+      class block_log_segment {
+         public:
+            virtual ~block_log_segment() = default;
+
+            virtual uint32_t first_block_num() const = 0;
+            virtual uint32_t last_block_num() const = 0;
+            virtual void read_block_by_num(uint32_t block_num, signed_block& block) const = 0;
+            virtual fc::path block_file() const = 0;
+            virtual fc::path index_file() const = 0;
+            virtual void remove() = 0;
+      };
+
+      using block_log_segment_ptr = std::shared_ptr<block_log_segment>;
+
+      class raw_block_segment final: public block_log_segment {
+         public:
+            raw_block_segment(const fc::path& block_path, const fc::path& index_path) {
+                impl.open(block_path, index_path);
+                EOS_ASSERT(impl.head, block_log_exception, "Block log segment '${path}' is empty", ("path", block_path));
+            }
+
+            uint32_t first_block_num() const override {
+                return impl.first_block_num;
+            }
+
+            uint32_t last_block_num() const override {
+                return impl.head->block_num();
+            }
+
+            void read_block_by_num(uint32_t block_num, signed_block& block) const override {
+                impl.read_block(impl.get_block_pos(block_num), block);
+            }
+
+            std::pair<const char*, std::size_t> get_block_data(uint32_t block_num) const {
+                return impl.get_block_data(block_num);
+            }
+
+            fc::path block_file() const override {
+                return impl.block_path;
+            }
+
+            fc::path index_file() const override {
+                return impl.index_path;
+            }
+
+            void remove() override {
+                impl.close();
+                fc::remove_all(impl.block_path);
+                fc::remove_all(impl.index_path);
+            }
+
+         private:
+            block_log_impl impl;
+      };
+
+      class compressed_block_segment final: public block_log_segment {
+         public:
+            compressed_block_segment(const fc::path& block_file, const fc::path& index_file)
+            : block_path(block_file.string()),
+              index_path(index_file.string()) {
+                block_mapped_file.open(block_path);
+
+                uint32_t version = get_uint32(0);
+                EOS_ASSERT(version == compressed_log_version, block_log_unsupported_version,
+                    "Unsupported version of compressed block log segment '${path}' (${version})",
+                    ("path", block_path)("version", version));
+                first_num = get_uint32(sizeof(uint32_t));
+                blocks_per_chunk = get_uint32(sizeof(uint32_t) * 2);
+                EOS_ASSERT(blocks_per_chunk > 0, block_log_exception,
+                    "Wrong number of blocks per chunk in '${path}'", ("path", block_path));
+
+                read_index();
+                EOS_ASSERT(!chunk_pos.empty(), block_log_exception,
+                    "Compressed block log segment '${path}' is empty", ("path", block_path));
+
+                auto last_chunk = read_chunk_header(chunk_pos.back());
+                last_num = first_num + (chunk_pos.size() - 1) * blocks_per_chunk + last_chunk.block_count - 1;
+            }
+
+            uint32_t first_block_num() const override {
+                return first_num;
+            }
+
+            uint32_t last_block_num() const override {
+                return last_num;
+            }
+
+            void read_block_by_num(uint32_t block_num, signed_block& block) const override {
+                EOS_ASSERT(block_num >= first_num && block_num <= last_num, block_log_exception,
+                    "Block ${block_num} doesn't exist in '${path}'", ("block_num", block_num)("path", block_path));
+
+                auto chunk_num = (block_num - first_num) / blocks_per_chunk;
+                auto num_in_chunk = (block_num - first_num) % blocks_per_chunk;
+
+                // the cache is shared by readers of the main thread and of the archive thread
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                auto& data = read_chunk(chunk_num);
+
+                auto* offsets = reinterpret_cast<const uint32_t*>(data.data());
+                EOS_ASSERT(num_in_chunk < cached_block_count && offsets[num_in_chunk] < data.size(), block_log_exception,
+                    "Block ${block_num} doesn't exist in chunk ${chunk}", ("block_num", block_num)("chunk", chunk_num));
+
+                fc::datastream<const char*> ds(data.data() + offsets[num_in_chunk], data.size() - offsets[num_in_chunk]);
+                fc::raw::unpack(ds, block);
+            }
+
+            fc::path block_file() const override {
+                return block_path;
+            }
+
+            fc::path index_file() const override {
+                return index_path;
+            }
+
+            void remove() override {
+                block_mapped_file.close();
+                fc::remove_all(block_path);
+                fc::remove_all(index_path);
+            }
+
+            static block_log_segment_ptr write(
+                const raw_block_segment& src, const fc::path& path, const fc::path& index_path,
+                const uint32_t blocks_per_chunk, const std::atomic<bool>& stopping
+            ) {
+                auto tmp_path = fc::path(path.string() + ".tmp");
+                auto tmp_index_path = fc::path(index_path.string() + ".tmp");
+
+                std::ofstream block_stream(tmp_path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+                std::ofstream index_stream(tmp_index_path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+                uint32_t header[] = {compressed_log_version, src.first_block_num(), blocks_per_chunk};
+                block_stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+                std::vector<char> raw_data;
+                std::vector<char> packed_data;
+                for (auto num = src.first_block_num(); num <= src.last_block_num(); num += blocks_per_chunk) {
+                    if (stopping) {
+                        block_stream.close();
+                        index_stream.close();
+                        fc::remove_all(tmp_path);
+                        fc::remove_all(tmp_index_path);
+                        return {};
+                    }
+
+                    chunk_header hdr;
+                    hdr.block_count = std::min(blocks_per_chunk, src.last_block_num() - num + 1);
+
+                    raw_data.resize(hdr.block_count * sizeof(uint32_t));
+                    for (uint32_t i = 0; i < hdr.block_count; ++i) {
+                        auto block = src.get_block_data(num + i);
+                        reinterpret_cast<uint32_t*>(raw_data.data())[i] = raw_data.size();
+                        raw_data.insert(raw_data.end(), block.first, block.first + block.second);
+                    }
+
+                    packed_data.clear();
+                    namespace bio = boost::iostreams;
+                    bio::filtering_ostream comp;
+                    comp.push(bio::zlib_compressor(bio::zlib::best_compression));
+                    comp.push(bio::back_inserter(packed_data));
+                    bio::write(comp, raw_data.data(), raw_data.size());
+                    bio::close(comp);
+
+                    hdr.raw_size = raw_data.size();
+                    hdr.packed_size = packed_data.size();
+
+                    uint64_t pos = block_stream.tellp();
+                    index_stream.write(reinterpret_cast<const char*>(&pos), sizeof(pos));
+                    block_stream.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+                    block_stream.write(packed_data.data(), packed_data.size());
+                }
+
+                block_stream.close();
+                index_stream.close();
+                EOS_ASSERT(!block_stream.fail() && !index_stream.fail(), block_log_append_fail,
+                    "Fail to write compressed block log segment '${path}'", ("path", tmp_path));
+
+                fc::rename(tmp_index_path, index_path);
+                fc::rename(tmp_path, path);
+                return std::make_shared<compressed_block_segment>(path, index_path);
+            }
+
+         private:
+            struct chunk_header {
+                uint32_t block_count = 0;
+                uint32_t raw_size    = 0;
+                uint32_t packed_size = 0;
+            };
+
+            uint32_t get_uint32(const std::size_t pos) const {
+                EOS_ASSERT(pos + sizeof(uint32_t) <= block_mapped_file.size(), block_log_exception,
+                    "Reading data beyond end of file", ("pos", pos)("file_size", block_mapped_file.size()));
+                return *reinterpret_cast<const uint32_t*>(block_mapped_file.data() + pos);
+            }
+
+            chunk_header read_chunk_header(const uint64_t pos) const {
+                chunk_header hdr;
+                EOS_ASSERT(pos + sizeof(hdr) <= block_mapped_file.size(), block_log_exception,
+                    "Reading data beyond end of file", ("pos", pos)("file_size", block_mapped_file.size()));
+                std::memcpy(&hdr, block_mapped_file.data() + pos, sizeof(hdr));
+                EOS_ASSERT(pos + sizeof(hdr) + hdr.packed_size <= block_mapped_file.size(), block_log_exception,
+                    "Reading data beyond end of file", ("pos", pos)("size", hdr.packed_size)("file_size", block_mapped_file.size()));
+                return hdr;
+            }
+
+            void read_index() {
+                const uint64_t header_size = sizeof(uint32_t) * 3;
+                const uint64_t file_size = block_mapped_file.size();
+
+                if (boost::filesystem::is_regular_file(index_path)) {
+                    auto index_size = boost::filesystem::file_size(index_path);
+                    chunk_pos.resize(index_size / sizeof(uint64_t));
+                    std::ifstream index_stream(index_path, LOG_READ);
+                    index_stream.read(reinterpret_cast<char*>(chunk_pos.data()), chunk_pos.size() * sizeof(uint64_t));
+
+                    if (!index_stream.fail() && !chunk_pos.empty() && chunk_pos.front() == header_size) {
+                        auto last = read_chunk_header(chunk_pos.back());
+                        if (chunk_pos.back() + sizeof(last) + last.packed_size == file_size) {
+                            return;
+                        }
+                    }
+                }
+
+                ilog("Reconstructing index of compressed block log segment '${path}'...", ("path", block_path));
+                chunk_pos.clear();
+                for (uint64_t pos = header_size; pos < file_size; ) {
+                    chunk_pos.push_back(pos);
+                    auto hdr = read_chunk_header(pos);
+                    pos += sizeof(hdr) + hdr.packed_size;
+                }
+
+                std::ofstream index_stream(index_path, std::ios::out | std::ios::binary | std::ios::trunc);
+                index_stream.write(reinterpret_cast<const char*>(chunk_pos.data()), chunk_pos.size() * sizeof(uint64_t));
+            }
+
+            const std::vector<char>& read_chunk(const uint32_t chunk_num) const {
+                if (cached_chunk == chunk_num) {
+                    return cached_data;
+                }
+
+                auto pos = chunk_pos[chunk_num];
+                auto hdr = read_chunk_header(pos);
+
+                cached_chunk = std::numeric_limits<uint32_t>::max();
+                cached_data.clear();
+                cached_data.reserve(hdr.raw_size);
+
+                namespace bio = boost::iostreams;
+                bio::filtering_ostream decomp;
+                decomp.push(bio::zlib_decompressor());
+                decomp.push(bio::back_inserter(cached_data));
+                bio::write(decomp, block_mapped_file.data() + pos + sizeof(hdr), hdr.packed_size);
+                bio::close(decomp);
+
+                EOS_ASSERT(cached_data.size() == hdr.raw_size && hdr.raw_size >= hdr.block_count * sizeof(uint32_t),
+                    block_log_exception, "Wrong size of chunk ${chunk} in '${path}'",
+                    ("chunk", chunk_num)("path", block_path)("size", cached_data.size())("expected", hdr.raw_size));
+
+                cached_block_count = hdr.block_count;
+                cached_chunk = chunk_num;
+                return cached_data;
+            }
+
+            std::string         block_path;
+            std::string         index_path;
+            boost::iostreams::mapped_file_source block_mapped_file;
+
+            uint32_t            first_num = 0;
+            uint32_t            last_num  = 0;
+            uint32_t            blocks_per_chunk = 0;
+            std::vector<uint64_t> chunk_pos;
+
+            mutable std::mutex        cache_mutex;
+            mutable uint32_t          cached_chunk = std::numeric_limits<uint32_t>::max();
+            mutable uint32_t          cached_block_count = 0;
+            mutable std::vector<char> cached_data;
+      };
+
+      /**
+       * Closed segments of block log with the background compression, archiving and pruning of them
+       */
+      class block_log_archive {
+         public:
+            block_log_archive(const fc::path& dir, const block_log_config& cfg)
+            : data_dir(dir), config(cfg) {
+                EOS_ASSERT(!config.compression || (config.segment_size > 0 && config.blocks_per_chunk > 0),
+                    block_log_exception, "Compression of block log requires segments and chunks");
+                EOS_ASSERT(config.segment_size > 0 || config.retained_blocks == 0,
+                    block_log_exception, "Pruning of block log requires segments");
+
+                std::vector<fc::path> dirs;
+                if (!config.archive_dir.empty()) {
+                    if (!fc::is_directory(config.archive_dir)) {
+                        fc::create_directories(config.archive_dir);
+                    }
+                    dirs.push_back(config.archive_dir);
+                }
+                dirs.push_back(data_dir);
+
+                // if a segment exists in several forms (the node was stopped before removing of the source one),
+                //   the compressed one and the one from the archive directory are used
+                for (auto& ext: {"zlog", "log"}) {
+                    for (auto& dir: dirs) {
+                        scan_dir(dir, ext);
+                    }
+                }
+            }
+
+            ~block_log_archive() {
+                // the segment will be processed on the next start
+                stopping = true;
+                thread_pool.join();
+            }
+
+            bool empty() const {
+                return segments.empty();
+            }
+
+            uint32_t first_block_num() const {
+                return segments.begin()->second->first_block_num();
+            }
+
+            uint32_t last_block_num() const {
+                return segments.rbegin()->second->last_block_num();
+            }
+
+            bool has_block(const uint32_t block_num) const {
+                return !empty() && block_num >= first_block_num() && block_num <= last_block_num();
+            }
+
+            signed_block_ptr read_block_by_num(const uint32_t block_num) const {
+                auto itr = segments.upper_bound(block_num);
+                if (itr == segments.begin()) {
+                    return {};
+                }
+                --itr;
+                if (block_num > itr->second->last_block_num()) {
+                    return {};
+                }
+
+                auto block = std::make_shared<signed_block>();
+                itr->second->read_block_by_num(block_num, *block);
+                return block;
+            }
+
+            void add_segment(const fc::path& block_path, const fc::path& index_path) {
+                add_segment(std::make_shared<raw_block_segment>(block_path, index_path));
+            }
+
+            void clear() {
+                cancel_maintenance();
+                for (auto& seg: segments) {
+                    seg.second->remove();
+                }
+                segments.clear();
+            }
+
+            // applies results of the background processing, prunes old segments and starts the next processing
+            void process(const uint32_t head_block_num) {
+                if (maintenance.valid() &&
+                    maintenance.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    complete_maintenance();
+                }
+                prune(head_block_num);
+                start_maintenance();
+            }
+
+            void wait() {
+                while (maintenance.valid()) {
+                    complete_maintenance();
+                    start_maintenance();
+                }
+            }
+
+         private:
+            // stops the background processing without waiting for it, its result is removed
+            void cancel_maintenance() {
+                if (!maintenance.valid()) {
+                    return;
+                }
+
+                stopping = true;
+                block_log_segment_ptr seg;
+                try {
+                    seg = maintenance.get();
+                } catch (const fc::exception& e) {
+                    wlog("Cancelled processing of block log segment ${num} failed: ${e}", ("num", maintenance_num)("e", e.to_detail_string()));
+                } catch (const std::exception& e) {
+                    wlog("Cancelled processing of block log segment ${num} failed: ${e}", ("num", maintenance_num)("e", e.what()));
+                }
+                stopping = false;
+
+                if (seg) {
+                    seg->remove();
+                }
+            }
+
+            void scan_dir(const fc::path& dir, const std::string& segment_ext) {
+                std::set<uint32_t> found_segments;
+                for (boost::filesystem::directory_iterator itr(dir.string()), end; itr != end; ++itr) {
+                    uint32_t first_block_num = 0;
+                    std::string ext;
+                    if (!parse_segment_path(itr->path(), first_block_num, ext)) {
+                        continue;
+                    }
+
+                    if (ext.size() > 4 && !ext.compare(ext.size() - 4, 4, ".tmp")) {
+                        ilog("Remove incomplete file '${path}'", ("path", itr->path().string()));
+                        boost::filesystem::remove(itr->path());
+                    } else if (ext == segment_ext) {
+                        found_segments.insert(first_block_num);
+                    }
+                }
+
+                bool is_compressed = (segment_ext == "zlog");
+                auto index_ext = is_compressed ? "zindex" : "index";
+                for (auto num: found_segments) {
+                    auto block_path = segment_path(dir, num, segment_ext.c_str());
+                    auto index_path = segment_path(dir, num, index_ext);
+                    if (segments.count(num)) {
+                        ilog("Remove block log segment '${path}', which is already processed", ("path", block_path));
+                        fc::remove_all(block_path);
+                        fc::remove_all(index_path);
+                    } else if (is_compressed) {
+                        add_segment(std::make_shared<compressed_block_segment>(block_path, index_path));
+                    } else {
+                        add_segment(std::make_shared<raw_block_segment>(block_path, index_path));
+                    }
+                }
+            }
+
+            void add_segment(block_log_segment_ptr seg) {
+                auto itr = segments.emplace(seg->first_block_num(), std::move(seg)).first;
+                auto next = std::next(itr);
+                if (itr != segments.begin()) {
+                    auto prev = std::prev(itr);
+                    EOS_ASSERT(itr->first == prev->second->last_block_num() + 1, block_log_exception,
+                        "Block log segment starts from ${first} instead of ${expected}",
+                        ("first", itr->first)("expected", prev->second->last_block_num() + 1));
+                }
+                if (next != segments.end()) {
+                    EOS_ASSERT(itr->second->last_block_num() + 1 == next->first, block_log_exception,
+                        "Block log segment ends at ${last} instead of ${expected}",
+                        ("last", itr->second->last_block_num())("expected", next->first - 1));
+                }
+            }
+
+            void prune(const uint32_t head_block_num) {
+                if (!config.retained_blocks) {
+                    return;
+                }
+
+                while (!segments.empty()) {
+                    auto itr = segments.begin();
+                    auto& seg = itr->second;
+                    if (uint64_t(seg->last_block_num()) + config.retained_blocks > head_block_num ||
+                        (maintenance.valid() && maintenance_num == itr->first)) {
+                        break;
+                    }
+
+                    ilog("Prune block log segment ${first}-${last}",
+                        ("first", seg->first_block_num())("last", seg->last_block_num()));
+                    seg->remove();
+                    segments.erase(itr);
+                }
+            }
+
+            static fc::path move_file(const fc::path& src, const fc::path& dst) {
+                auto tmp = fc::path(dst.string() + ".tmp");
+                fc::copy(src, tmp);
+                fc::rename(tmp, dst);
+                return dst;
+            }
+
+            void start_maintenance() {
+                if (maintenance_failed || maintenance.valid()) {
+                    return;
+                }
+
+                const auto& dst_dir = config.archive_dir.empty() ? data_dir : config.archive_dir;
+                for (auto& seg: segments) {
+                    auto num = seg.first;
+                    auto raw = std::dynamic_pointer_cast<raw_block_segment>(seg.second);
+
+                    if (config.compression && raw) {
+                        ilog("Compress block log segment ${first}-${last}",
+                            ("first", raw->first_block_num())("last", raw->last_block_num()));
+                        auto block_path = segment_path(dst_dir, num, "zlog");
+                        auto index_path = segment_path(dst_dir, num, "zindex");
+                        auto blocks_per_chunk = config.blocks_per_chunk;
+                        maintenance = async_thread_pool(thread_pool, [this, raw, block_path, index_path, blocks_per_chunk]() {
+                            return compressed_block_segment::write(*raw, block_path, index_path, blocks_per_chunk, stopping);
+                        });
+                    } else if (!config.archive_dir.empty()) {
+                        auto block_path = segment_path(dst_dir, num, raw ? "log" : "zlog");
+                        auto index_path = segment_path(dst_dir, num, raw ? "index" : "zindex");
+                        if (seg.second->block_file().string() == block_path.string()) {
+                            continue;
+                        }
+
+                        ilog("Move block log segment ${first}-${last} to '${dir}'",
+                            ("first", seg.second->first_block_num())("last", seg.second->last_block_num())("dir", dst_dir));
+                        auto src = seg.second;
+                        maintenance = async_thread_pool(thread_pool, [src, raw, block_path, index_path]() -> block_log_segment_ptr {
+                            move_file(src->index_file(), index_path);
+                            move_file(src->block_file(), block_path);
+                            if (raw) {
+                                return std::make_shared<raw_block_segment>(block_path, index_path);
+                            }
+                            return std::make_shared<compressed_block_segment>(block_path, index_path);
+                        });
+                    } else {
+                        continue;
+                    }
+
+                    maintenance_num = num;
+                    return;
+                }
+            }
+
+            void complete_maintenance() {
+                block_log_segment_ptr seg;
+                try {
+                    seg = maintenance.get();
+                } catch (const fc::exception& e) {
+                    elog("Fail to process block log segment ${num}: ${e}", ("num", maintenance_num)("e", e.to_detail_string()));
+                    maintenance_failed = true;
+                } catch (const std::exception& e) {
+                    elog("Fail to process block log segment ${num}: ${e}", ("num", maintenance_num)("e", e.what()));
+                    maintenance_failed = true;
+                }
+                if (!seg) {
+                    return;
+                }
+
+                auto& dst = segments.at(seg->first_block_num());
+                dst->remove();
+                dst = std::move(seg);
+                ilog("Block log segment ${first}-${last} is stored to '${path}'",
+                    ("first", dst->first_block_num())("last", dst->last_block_num())("path", dst->block_file()));
+            }
+
+            fc::path                                   data_dir;
+            block_log_config                           config;
+            std::map<uint32_t, block_log_segment_ptr>  segments;
+            boost::asio::thread_pool                   thread_pool{1};
+            std::future<block_log_segment_ptr>         maintenance;
+            uint32_t                                   maintenance_num = 0;
+            std::atomic<bool>                          stopping{false};
+            bool                                       maintenance_failed = false;
+      };
    }
 
-   block_log::block_log(const fc::path& data_dir)
-   : my(std::make_unique<detail::block_log_impl>()) {
+   block_log::block_log(const fc::path& data_dir, const block_log_config& cfg)
+   : my(std::make_unique<detail::block_log_impl>()),
+     config(cfg),
+     data_dir(data_dir) {
        open(data_dir);
    }
 
-   block_log::block_log(block_log&& other) {
+   block_log::block_log(block_log&& other)
+   : config(other.config),
+     data_dir(other.data_dir) {
       my = std::move(other.my);
+      archive = std::move(other.archive);
    }
 
    block_log::~block_log() {
       if (my) {
-         flush();
+         archive.reset();
          my.reset();
       }
    }
@@ -519,21 +1182,66 @@ namespace eosio { namespace chain {
    void block_log::open(const fc::path& data_dir) {
         // detail::write_lock lock(my->mutex);
         my->open(data_dir);
+        archive = std::make_unique<detail::block_log_archive>(data_dir, config);
+
+        if (archive->empty()) {
+            return;
+        }
+
+        auto next_block_num = archive->last_block_num() + 1;
+        if (!my->head) {
+            if (my->first_block_num != next_block_num) {
+                my->reset(next_block_num, {}, {});
+            }
+            my->head = archive->read_block_by_num(next_block_num - 1);
+            my->head_id = my->head->id();
+        } else {
+            EOS_ASSERT(my->first_block_num == next_block_num, block_log_exception,
+                "Block log starts from ${first} instead of ${expected}",
+                ("first", my->first_block_num)("expected", next_block_num));
+        }
+   }
+
+   void block_log::rotate() {
+        auto head = my->head;
+        auto first_block_num = my->first_block_num;
+        auto block_path = detail::segment_path(data_dir, first_block_num, "log");
+        auto index_path = detail::segment_path(data_dir, first_block_num, "index");
+
+        ilog("Close block log segment ${first}-${last}", ("first", first_block_num)("last", head->block_num()));
+        my->close();
+        fc::rename(my->block_path, block_path);
+        fc::rename(my->index_path, index_path);
+        archive->add_segment(block_path, index_path);
+
+        my->open(data_dir);
+        my->reset(head->block_num() + 1, {}, {});
+        my->head = head;
+        my->head_id = head->id();
    }
 
    uint64_t block_log::append(const signed_block_ptr& block) try {
         auto data = fc::raw::pack(*block);
         // detail::write_lock lock(my->mutex);
-        return my->append(block, data);
+        auto pos = my->append(block, data);
+        if (config.segment_size > 0 && block->block_num() % config.segment_size == 0) {
+            rotate();
+        }
+        archive->process(block->block_num());
+        return pos;
    } FC_LOG_AND_RETHROW()
 
    void block_log::flush() {
-       // it isn't needed, because all data is already in page cache
+       // it isn't needed for the active file, because all data is already in page cache,
+       //   but closed segments can wait for the compression
+       archive->wait();
    }
 
    void block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, uint32_t first_block_num) {
-       EOS_ASSERT(first_block_num == 1, block_log_exception,
-            "Unsupported first_block_num (can be only 1)");
+       EOS_ASSERT(first_block_num > 0, block_log_exception, "Unsupported first_block_num 0");
+       EOS_ASSERT(!first_block || first_block->block_num() == first_block_num, block_log_exception,
+            "First block ${num} doesn't match first_block_num ${first}",
+            ("num", first_block->block_num())("first", first_block_num));
 
        std::vector<char> data;
        if (first_block) {
@@ -541,7 +1249,8 @@ namespace eosio { namespace chain {
        }
 
     //    detail::write_lock lock(my->mutex);
-       my->reset(first_block, data);
+       archive->clear();
+       my->reset(first_block_num, first_block, data);
 
 // TODO: removed by CyberWay
 //      auto data = fc::raw::pack(gs);
@@ -586,6 +1295,10 @@ namespace eosio { namespace chain {
 
    signed_block_ptr block_log::read_block_by_num(uint32_t block_num) const try {
     //    detail::read_lock lock(my->mutex);
+       if (archive->has_block(block_num)) {
+           return archive->read_block_by_num(block_num);
+       }
+
        signed_block_ptr block;
        uint64_t pos = my->get_block_pos(block_num);
        if (pos != npos) {
@@ -606,7 +1319,11 @@ namespace eosio { namespace chain {
 
    signed_block_ptr block_log::read_head()const {
     //    detail::read_lock lock(my->mutex);
-       return my->read_head();
+       auto head = my->read_head();
+       if (!head && !archive->empty()) {
+           head = archive->read_block_by_num(archive->last_block_num());
+       }
+       return head;
    }
 
    const signed_block_ptr& block_log::head()const {
@@ -614,11 +1331,14 @@ namespace eosio { namespace chain {
       return my->head;
    }
 
+   uint32_t block_log::first_block_num() const {
+      if (!archive->empty()) {
+         return archive->first_block_num();
+      }
+      return my->first_block_num;
+   }
+
 // TODO: removed by CyberWay
-//   uint32_t block_log::first_block_num() const {
-//      return my->first_block_num;
-//   }
-//
 //   void block_log::construct_index() {
 //      ilog("Reconstructing Block Log Index...");
 //      my->index_stream.close();
@@ -257,6 +257,13 @@ namespace cyberway { namespace chaindb {
         init(std::move(def));
     }
 
+    abi_info::abi_info(const abi_info& src)
+    : code_(src.code_),
+      serializer_(src.serializer_),
+      table_map_(src.table_map_) {
+        init_index_map();
+    }
+
     void abi_info::init(abi_def def) {
         if (!is_system_code(code_)) {
             serializer_.set_check_field_name(true);
@@ -279,6 +286,29 @@ namespace cyberway { namespace chaindb {
 
         index_builder builder(code_, table_map_, serializer_, max_abi_time_);
         builder.build_indexes();
+
+        init_index_map();
+    }
+
+    void abi_info::init_index_map() {
+        index_info info(code_, code_);
+
+        index_map_.reserve(table_map_.size() * MaxIndexCnt);
+        for (auto& t: table_map_) {
+            info.table = &t.second;
+            for (auto& index: t.second.indexes) {
+                info.index = &index;
+                index_map_.emplace(std::make_pair(t.first, index.name.value), index_descriptor{&index, get_full_index_name(info)});
+            }
+        }
+        index_map_.shrink_to_fit();
+    }
+
+    const string& abi_info::get_index_type(const index_info& info) const {
+        auto itr = index_map_.find(std::make_pair(info.table->name.value, info.index->name.value));
+        CYBERWAY_ASSERT(index_map_.end() != itr, unknown_index_exception,
+            "ABI index ${index} doesn't exists", ("index", get_full_index_name(info)));
+        return itr->second.type;
     }
 
     template<typename Type>
@@ -326,7 +356,7 @@ namespace cyberway { namespace chaindb {
 
     variant abi_info::to_object(const index_info& info, const void* data, const size_t size) const {
         assert(info.index);
-        auto type = get_full_index_name(info);
+        auto& type = get_index_type(info);
         auto db_type = [&](){return type;};
         return to_object_(abi_serializer::DBMode, "index", std::move(db_type), type, data, size);
     }
@@ -344,7 +374,7 @@ namespace cyberway { namespace chaindb {
 
     bytes abi_info::to_bytes(const index_info& info, const variant& value) const {
         assert(info.index);
-        auto type = get_full_index_name(info);
+        auto& type = get_index_type(info);
         auto db_type = [&]{return type;};
         return to_bytes_("index", std::move(db_type), type, value);
     }
@@ -0,0 +1,71 @@
+#include <cyberway/chaindb/abi_registry.hpp>
+
+namespace cyberway { namespace chaindb {
+
+    abi_registry& abi_registry::instance() {
+        static abi_registry registry;
+        return registry;
+    }
+
+    abi_info_ptr abi_registry::get(const account_name& code, const bytes& abi) {
+        key_type key(code.value, fc::sha256::hash(abi.data(), abi.size()));
+
+        auto info = find(key);
+        if (info) {
+            return info;
+        }
+
+        abi_def def;
+        fc::datastream<const char*> ds(abi.data(), abi.size());
+        fc::raw::unpack(ds, def);
+
+        return insert(std::move(key), code, std::move(def), abi.size());
+    }
+
+    abi_info_ptr abi_registry::find(const key_type& key) {
+        auto itr = entries_.find(key);
+        if (entries_.end() == itr) {
+            return {};
+        }
+
+        lru_.splice(lru_.end(), lru_, itr->second.lru);
+        return itr->second.info;
+    }
+
+    abi_info_ptr abi_registry::insert(key_type key, const account_name& code, abi_def def, const size_t size) {
+        abi_info_ptr info(new abi_info(code, std::move(def)));
+        if (size > max_size_) {
+            return info;
+        }
+
+        used_size_ += size;
+        while (used_size_ > max_size_) {
+            release_lru();
+        }
+
+        auto lru = lru_.insert(lru_.end(), key);
+        entries_.emplace(std::move(key), entry{info, size, lru});
+        return info;
+    }
+
+    void abi_registry::set_max_size(const size_t size) {
+        max_size_ = size;
+        while (used_size_ > max_size_) {
+            release_lru();
+        }
+    }
+
+    void abi_registry::clear() {
+        entries_.clear();
+        lru_.clear();
+        used_size_ = 0;
+    }
+
+    void abi_registry::release_lru() {
+        auto itr = entries_.find(lru_.front());
+        used_size_ -= itr->second.size;
+        entries_.erase(itr);
+        lru_.pop_front();
+    }
+
+} } // namespace cyberway::chaindb
@@ -1,4 +1,5 @@
 #include <cyberway/chaindb/account_abi_info.hpp>
+#include <cyberway/chaindb/abi_registry.hpp>
 #include <cyberway/chaindb/table_info.hpp>
 #include <cyberway/chaindb/driver_interface.hpp>
 
@@ -7,7 +8,8 @@ namespace eosio { namespace chain {
 
     cyberway::chaindb::abi_info_ptr account_object::generate_abi_info() {
         if (!abi_info_ptr_) {
-            abi_info_ptr_.reset(new cyberway::chaindb::abi_info(name, get_abi()));
+            EOS_ASSERT(abi.size() != 0, abi_not_found_exception, "No ABI set on account ${n}", ("n", name));
+            abi_info_ptr_ = chaindb::abi_registry::instance().get(name, abi);
         }
         return abi_info_ptr_;
     }
@@ -7,6 +7,8 @@
 
 #include <eosio/chain/int_arithmetic.hpp>
 #include <eosio/chain/global_property_object.hpp>
+#include <eosio/chain/stake_object.hpp>
+#include <eosio/chain/resource_limits_private.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
@@ -59,20 +61,34 @@ namespace cyberway { namespace chaindb {
         struct by_key;
         struct by_object;
 
-        const index_name_t  index = 0;
-        const bytes         blob;
+        const index_name_t  index  = 0;
+        const bytes         blob;       // own key, only for the cache of missing objects
+        const uint32_t      offset = 0; // position of the key in the keys of the object
+        const uint32_t      length = 0;
         cache_object_ptr    object_ptr;
 
+        // the key is stored in cache_object::index_keys_, all unique keys of a row share one allocation
+        cache_index_value(const index_name i, const uint32_t off, const uint32_t len, cache_object_ptr o)
+        : index(i), offset(off), length(len), object_ptr(std::move(o)) {
+        }
+
         cache_index_value(const index_name i, bytes b, cache_object_ptr o)
-        : index(i), blob(std::move(b)), object_ptr(std::move(o)) {
+        : index(i), blob(std::move(b)), length(blob.size()), object_ptr(std::move(o)) {
         }
 
         cache_index_value(cache_index_value&&) = default;
 
         ~cache_index_value() = default;
 
+        const char* key_data() const {
+            if (!blob.empty()) {
+                return blob.data();
+            }
+            return object_ptr->index_keys_.data() + offset;
+        }
+
         cache_index_key value_key() const {
-            return {index, object_ptr->service().scope, blob.data(), blob.size()};
+            return {index, object_ptr->service().scope, key_data(), length};
         }
 
         static const void* object_key(const cache_object& cache_obj) {
@@ -83,6 +99,7 @@ namespace cyberway { namespace chaindb {
             return object_key(*object_ptr);
         }
 
+        // charged only for the cache of missing objects, the shared keys are a part of the object
         uint64_t size() const {
             return blob.size() + 64;
         }
@@ -232,6 +249,23 @@ namespace cyberway { namespace chaindb {
 
     //-----------------------------------------------------------------------------------------------
 
+    struct cache_evicted_key final {
+        account_name_t code  = 0;
+        table_name_t   table = 0;
+        scope_name_t   scope = 0;
+        primary_key_t  pk    = primary_key::Unset;
+
+        cache_evicted_key(const cache_object& v)
+        : code(v.service().code), table(v.service().table), scope(v.service().scope), pk(v.pk()) {
+        }
+
+        friend bool operator < (const cache_evicted_key& l, const cache_evicted_key& r) {
+            return std::tie(l.code, l.table, l.scope, l.pk) < std::tie(r.code, r.table, r.scope, r.pk);
+        }
+    }; // struct cache_evicted_key
+
+    //-----------------------------------------------------------------------------------------------
+
     struct lru_cache_object_state final: public cache_object_state {
         using cache_object_state::cache_object_state;
 
@@ -259,11 +293,14 @@ namespace cyberway { namespace chaindb {
         void reset();
 
         lru_cache_object_state* prev_state = nullptr;
+        uint64_t accounted_size = 0; // size of the object in the size of the cell and in the budget
     }; // struct lru_cache_object_state
 
     struct lru_cache_cell final: public cache_cell {
-        lru_cache_cell(cache_map_impl& m, const uint64_t p, const revision_t r, const uint64_t d, const uint32_t rlm)
-        : cache_cell(m, p, cache_cell::Pending),
+        lru_cache_cell(
+            cache_map_impl& m, const uint64_t p, const uint64_t s, const revision_t r, const uint64_t d, const uint32_t rlm
+        ) : cache_cell(m, p, cache_cell::Pending),
+          serial_(s),
           revision_(r),
           max_distance_(d),
           ram_load_multiplier_(rlm) {
@@ -305,6 +342,10 @@ namespace cyberway { namespace chaindb {
             return revision_;
         }
 
+        uint64_t serial() const {
+            return serial_;
+        }
+
         uint64_t ram_bytes() const {
             return ram_bytes_;
         }
@@ -315,6 +356,7 @@ namespace cyberway { namespace chaindb {
         }
 
         std::deque<lru_cache_object_state> state_list; // Expansion of a std::deque is cheaper than the expansion of a std::vector
+        std::vector<cache_evicted_key>     evicted_keys; // rows evicted by budgets from this cell
 
     private:
         lru_cache_object_state* emplace_impl(cache_object_ptr obj_ptr) {
@@ -328,14 +370,10 @@ namespace cyberway { namespace chaindb {
             return lru_prev_state;
         }
 
-        void add_ram_bytes(const lru_cache_object_state& state) {
-            assert(cache_cell::Pending == kind());
+        void add_ram_bytes(const lru_cache_object_state& state);
 
+        void add_ram_bytes(const lru_cache_object_state& state, const uint64_t pos_diff) {
             auto object_size = state.object_ptr->service().size;
-            if (!object_size) {
-                return;
-            }
-            auto pos_diff = state.prev_state ? pos() - state.prev_state->cell->pos() : max_distance_;
             bool in_ram = pos_diff < max_distance_;
             auto delta =  in_ram ?
                std::max(
@@ -348,6 +386,7 @@ namespace cyberway { namespace chaindb {
         }
 
         uint64_t ram_bytes_ = 0;
+        const uint64_t serial_ = 0; // cells are ordered by serial numbers in the LRU list
         revision_t revision_ = impossible_revision;
         const uint64_t max_distance_ = 0;
         const uint32_t ram_load_multiplier_ = config::default_ram_load_multiplier;
@@ -408,6 +447,20 @@ namespace cyberway { namespace chaindb {
 
     //-----------------------------------------------------------------------------------------------
 
+    struct cache_budget final {
+        uint64_t limit = 0; // 0 - the budget isn't limited
+        uint64_t used  = 0;
+        uint64_t evicted_rows = 0;
+
+        // position of the eviction in the LRU list, the rows before it are already checked
+        uint64_t scan_serial = 0;
+        size_t   scan_state  = 0;
+
+        bool     overused = false; // the budget is in the list of overused budgets
+    }; // struct cache_budget
+
+    //-----------------------------------------------------------------------------------------------
+
     class cache_map_impl final {
     public:
         cache_map_impl()
@@ -638,6 +691,149 @@ namespace cyberway { namespace chaindb {
             }
         }
 
+        const cache_stats& stats() const {
+            return stats_;
+        }
+
+        void count_lookup(const bool hit) {
+            if (hit) {
+                ++stats_.hits;
+            } else {
+                ++stats_.misses;
+            }
+        }
+
+        void set_budgets(cache_budget_config config) {
+            budget_config_ = std::move(config);
+
+            for (auto budget_ptr: overused_budgets_) {
+                budget_ptr->overused = false;
+            }
+            overused_budgets_.clear();
+
+            system_budget_.limit = budget_config_.system_size;
+            stake_budget_.limit  = budget_config_.stake_size;
+            mark_overused_budget(system_budget_);
+            mark_overused_budget(stake_budget_);
+            for (auto& budget: contract_budgets_) {
+                budget.second.limit = get_contract_limit(budget.first);
+                mark_overused_budget(budget.second);
+            }
+        }
+
+        cache_usage usage() const {
+            cache_usage result;
+            result.limit = ram_limit_;
+            result.used  = ram_used_;
+
+            auto& budgets = result.budgets;
+            budgets.reserve(contract_budgets_.size() + 2);
+
+            auto add_usage = [&](string name, const account_name_t code, const cache_budget& budget) {
+                budgets.push_back({std::move(name), code, budget.limit, budget.used, budget.evicted_rows});
+            };
+
+            add_usage("system", 0, system_budget_);
+            add_usage("stake",  0, stake_budget_);
+
+            auto first = budgets.size();
+            for (auto& budget: contract_budgets_) {
+                add_usage("contract", budget.first, budget.second);
+            }
+            std::sort(budgets.begin() + first, budgets.end(), [](auto& l, auto& r) { return l.code < r.code; });
+
+            return result;
+        }
+
+        std::vector<cache_hot_key> hot_keys(const size_t max_count) const {
+            std::vector<cache_hot_key> result;
+
+            // committed cells hold only the newest state of each object, so keys don't repeat
+            for (auto itr = lru_cell_list_.rbegin(), etr = lru_cell_list_.rend(); itr != etr; ++itr) {
+                if (itr->kind() != cache_cell::LRU) {
+                    continue;
+                }
+
+                for (auto& state: itr->state_list) {
+                    if (result.size() >= max_count) {
+                        return result;
+                    }
+                    if (!state.object_ptr || state.object_ptr->is_deleted()) {
+                        continue;
+                    }
+
+                    auto& service = state.object_ptr->service();
+                    if (is_fake_code(service.code) || !primary_key::is_good(service.pk)) {
+                        continue;
+                    }
+                    result.push_back({service.code, service.scope, service.table, service.pk});
+                }
+            }
+
+            return result;
+        }
+
+        bool start_warm_up() {
+            if (has_pending_cell()) {
+                return false;
+            }
+
+            start_session(start_revision);
+            return true;
+        }
+
+        void push_warm_up() {
+            CYBERWAY_CACHE_ASSERT(pending_cell_list_.size() == 1, "Wrong state of pending caches on warm-up");
+
+            // same as push_session(), but the revision of LRU isn't changed
+            auto& pending = *pending_cell_list_.back();
+            auto  size = pending.commit_revision();
+            add_ram_usage(pending, size);
+            pending_cell_list_.pop_back();
+
+            if (!lru_cell_list_.back().size) {
+                lru_cell_list_.pop_back();
+            }
+
+            clear_overused_ram();
+            clear_overused_budgets();
+        }
+
+        void add_budget_usage(const cache_object& cache_obj, const int64_t delta) {
+            if (!delta) {
+                return;
+            }
+
+            auto& budget = get_budget(cache_obj.service());
+            budget.used = add_ram_usage(budget.used, delta);
+            mark_overused_budget(budget);
+        }
+
+        // the cell of the row evicted by its budget, it replaces the previous state for the RAM billing
+        const lru_cache_cell* find_evicted_cell(const cache_object& cache_obj) const {
+            if (evicted_rows_.empty()) {
+                return nullptr;
+            }
+
+            auto itr = evicted_rows_.find(cache_evicted_key(cache_obj));
+            if (evicted_rows_.end() == itr) {
+                return nullptr;
+            }
+
+            auto cell_itr = std::lower_bound(lru_cell_list_.begin(), lru_cell_list_.end(), itr->second,
+                [](const lru_cache_cell& cell, const uint64_t serial) { return cell.serial() < serial; });
+            if (lru_cell_list_.end() == cell_itr || cell_itr->serial() != itr->second) {
+                return nullptr;
+            }
+            return &*cell_itr;
+        }
+
+        void forget_evicted_row(const cache_object& cache_obj) {
+            if (!evicted_rows_.empty()) {
+                evicted_rows_.erase(cache_evicted_key(cache_obj));
+            }
+        }
+
         primary_key_t get_next_pk(const table_info& table) {
             auto service_ptr = find_cache_service(table);
             if (service_ptr && primary_key::Unset != service_ptr->next_pk) {
@@ -667,6 +863,14 @@ namespace cyberway { namespace chaindb {
             pending_cell_list_.clear();
             lru_cell_list_.clear();
 
+            reset_budget(system_budget_);
+            reset_budget(stake_budget_);
+            for (auto& budget: contract_budgets_) {
+                reset_budget(budget.second);
+            }
+            overused_budgets_.clear();
+            evicted_rows_.clear();
+
             for (auto& service: service_tree_) {
                 service.second.next_pk = primary_key::Unset;
             }
@@ -706,7 +910,7 @@ namespace cyberway { namespace chaindb {
                 }
             }
 
-            lru_cell_list_.emplace_back(*this, pos, revision, ram_limit_, ram_load_multiplier);
+            lru_cell_list_.emplace_back(*this, pos, next_cell_serial_++, revision, ram_limit_, ram_load_multiplier);
             pending_cell_list_.emplace_back(&lru_cell_list_.back());
         }
 
@@ -725,6 +929,7 @@ namespace cyberway { namespace chaindb {
             }
 
             clear_overused_ram();
+            clear_overused_budgets();
             lru_revision_ = revision - 1;
         }
 
@@ -779,6 +984,16 @@ namespace cyberway { namespace chaindb {
         uint64_t subjective_reserved_ram_size = 0;
         uint32_t ram_load_multiplier = config::default_ram_load_multiplier;
 
+        cache_stats            stats_;
+
+        uint64_t               next_cell_serial_ = 0;
+        cache_budget_config    budget_config_;
+        cache_budget           system_budget_;
+        cache_budget           stake_budget_;
+        std::unordered_map<account_name_t, cache_budget> contract_budgets_;
+        std::vector<cache_budget*> overused_budgets_; // elements of unordered_map keep their addresses
+        std::map<cache_evicted_key, uint64_t /* serial of the cell */> evicted_rows_;
+
         static uint64_t get_ram_limit(
             const uint64_t limit   = config::default_ram_size,
             const uint64_t reserve = config::default_reserved_ram_size
@@ -794,10 +1009,135 @@ namespace cyberway { namespace chaindb {
                 auto& lru = lru_cell_list_.front();
                 assert(lru.kind() == cache_cell::LRU);
                 add_ram_usage(lru, -lru.size);
+
+                for (auto& state: lru.state_list) if (state.object_ptr && state.accounted_size) {
+                    add_budget_usage(*state.object_ptr, -int64_t(state.accounted_size));
+                    state.accounted_size = 0;
+                }
+                for (auto& key: lru.evicted_keys) {
+                    auto itr = evicted_rows_.find(key);
+                    if (evicted_rows_.end() != itr && itr->second == lru.serial()) {
+                        evicted_rows_.erase(itr);
+                    }
+                }
                 lru_cell_list_.pop_front();
             }
         }
 
+        static bool is_stake_table(const table_name_t table) {
+            using namespace eosio::chain;
+            using namespace eosio::chain::resource_limits;
+
+            static const table_name_t tables[] = {
+                tag<stake_agent_object>::get_code(),
+                tag<stake_candidate_object>::get_code(),
+                tag<stake_auto_recall_object>::get_code(),
+                tag<stake_grant_object>::get_code(),
+                tag<stake_param_object>::get_code(),
+                tag<stake_stat_object>::get_code(),
+                tag<resource_usage_object>::get_code(),
+                tag<resource_limits_config_object>::get_code(),
+                tag<resource_limits_state_object>::get_code(),
+            };
+            return std::end(tables) != std::find(std::begin(tables), std::end(tables), table);
+        }
+
+        uint64_t get_contract_limit(const account_name_t code) const {
+            auto itr = budget_config_.contract_sizes.find(code);
+            if (budget_config_.contract_sizes.end() != itr) {
+                return itr->second;
+            }
+            return budget_config_.contract_size;
+        }
+
+        cache_budget* find_budget(const service_state& service) {
+            if (is_system_code(service.code)) {
+                return is_stake_table(service.table) ? &stake_budget_ : &system_budget_;
+            }
+
+            auto itr = contract_budgets_.find(service.code);
+            if (contract_budgets_.end() != itr) {
+                return &itr->second;
+            }
+            return nullptr;
+        }
+
+        cache_budget& get_budget(const service_state& service) {
+            auto budget_ptr = find_budget(service);
+            if (budget_ptr) {
+                return *budget_ptr;
+            }
+
+            auto& budget = contract_budgets_[service.code];
+            budget.limit = get_contract_limit(service.code);
+            return budget;
+        }
+
+        void reset_budget(cache_budget& budget) {
+            budget.used = 0;
+            budget.scan_serial = 0;
+            budget.scan_state  = 0;
+            budget.overused    = false;
+        }
+
+        void mark_overused_budget(cache_budget& budget) {
+            if (!budget.overused && budget.limit && budget.used > budget.limit) {
+                budget.overused = true;
+                overused_budgets_.push_back(&budget);
+            }
+        }
+
+        // it is called only without pending cells, so evicted states aren't referenced by pending states
+        void clear_overused_budgets() {
+            assert(!has_pending_cell());
+
+            for (auto budget_ptr: overused_budgets_) {
+                budget_ptr->overused = false;
+                clear_overused_budget(*budget_ptr);
+            }
+            overused_budgets_.clear();
+        }
+
+        void clear_overused_budget(cache_budget& budget) {
+            if (!budget.limit || budget.used <= budget.limit) {
+                return;
+            }
+
+            auto itr = std::lower_bound(lru_cell_list_.begin(), lru_cell_list_.end(), budget.scan_serial,
+                [](const lru_cache_cell& cell, const uint64_t serial) { return cell.serial() < serial; });
+            auto etr = lru_cell_list_.end();
+
+            size_t pos = (etr != itr && itr->serial() == budget.scan_serial) ? budget.scan_state : 0;
+            for (; etr != itr && budget.used > budget.limit; ++itr, pos = 0) {
+                auto& cell = *itr;
+                assert(cell.kind() == cache_cell::LRU);
+
+                for (; pos < cell.state_list.size() && budget.used > budget.limit; ++pos) {
+                    auto& state = cell.state_list[pos];
+                    if (!state.object_ptr || !state.accounted_size || find_budget(state.object_ptr->service()) != &budget) {
+                        continue;
+                    }
+
+                    auto size = state.accounted_size;
+                    state.accounted_size = 0;
+                    budget.used = add_ram_usage(budget.used, -int64_t(size));
+                    ++budget.evicted_rows;
+
+                    // the size of the cell isn't changed and the cell of the row is remembered,
+                    //   so the RAM billing and the eviction by the RAM limit don't depend on budgets
+                    cache_evicted_key key(*state.object_ptr);
+                    evicted_rows_[key] = cell.serial();
+                    cell.evicted_keys.push_back(key);
+
+                    // the state was committed, so the object is released if it isn't used in newer cells
+                    state.reset();
+                }
+
+                budget.scan_serial = cell.serial();
+                budget.scan_state  = pos;
+            }
+        }
+
         bool add_system_object(cache_object_ptr obj_ptr) {
             assert(obj_ptr && is_system_object(*obj_ptr));
             system_cell_.emplace(std::move(obj_ptr));
@@ -853,12 +1193,17 @@ namespace cyberway { namespace chaindb {
             }
 
             std::vector<cache_index_value> indicies;
-            indicies.reserve(table.table->indexes.size() + 10);
+            indicies.reserve(table.table->indexes.size());
 
             auto  index = index_info(cache_obj.service().code, cache_obj.service().scope);
             index.table = table.table;
 
-            auto& key_idx = service.index_tree.get<cache_index_value::by_key>();
+            // the keys are collected before the creation of index values,
+            //   because values point to the storage of keys and it can be reallocated
+            bytes keys;
+            std::vector<std::pair<const index_def*, uint32_t>> positions;
+            positions.reserve(table.table->indexes.size());
+
             for (auto& idx: table.table->indexes) if (idx.unique && idx.name != names::primary_index) {
                 index.index = &idx;
 
@@ -867,7 +1212,24 @@ namespace cyberway { namespace chaindb {
                     continue;
                 }
 
-                indicies.emplace_back(idx.name, std::move(blob), cache_object_ptr(&cache_obj));
+                positions.emplace_back(&idx, keys.size());
+                keys.insert(keys.end(), blob.begin(), blob.end());
+            }
+
+            if (positions.empty()) {
+                return;
+            }
+
+            keys.shrink_to_fit();
+            cache_obj.index_keys_ = std::move(keys);
+
+            auto& key_idx = service.index_tree.get<cache_index_value::by_key>();
+            for (size_t i = 0, end = positions.size(); i < end; ++i) {
+                auto offset = positions[i].second;
+                auto next   = (i + 1 < end) ? positions[i + 1].second : cache_obj.index_keys_.size();
+
+                index.index = positions[i].first;
+                indicies.emplace_back(index.index->name, offset, next - offset, cache_object_ptr(&cache_obj));
                 CYBERWAY_ASSERT(key_idx.end() == key_idx.find(indicies.back()),
                     driver_duplicate_exception, "Cache duplicate unique records in the index ${index}",
                     ("index", get_full_index_name(index)));
@@ -886,6 +1248,9 @@ namespace cyberway { namespace chaindb {
             for (; idx.end() != itr && itr->object_key() == key; ) {
                 itr = idx.erase(itr);
             }
+
+            cache_obj.index_keys_.clear();
+            cache_obj.index_keys_.shrink_to_fit();
         }
 
         void delete_unsuccess_pk(cache_service_info& service, cache_object& cache_obj) {
@@ -921,7 +1286,7 @@ namespace cyberway { namespace chaindb {
                 return;
             }
 
-            add_ram_usage(cache_obj.cell(), delta);
+            add_object_ram_usage(cache_obj, delta);
 
             if (is_system_code(cache_obj.service().code)) {
                 using global_property_object = eosio::chain::global_property_object;
@@ -957,7 +1322,7 @@ namespace cyberway { namespace chaindb {
                     delete_unsuccess_index(service, cache_obj);
 
                     if (cache_obj.has_cell()) {
-                        add_ram_usage(cache_obj.cell(), -cache_obj.service().size);
+                        add_object_ram_usage(cache_obj, -cache_obj.service().size);
                     }
                     break;
                 }
@@ -1080,6 +1445,17 @@ namespace cyberway { namespace chaindb {
             }
         }
 
+        void add_object_ram_usage(cache_object& cache_obj, const int64_t delta) {
+            if (!delta || cache_obj.kind() != cache_cell::LRU) {
+                return;
+            }
+
+            auto& state = lru_cache_object_state::cast(cache_obj.state());
+            state.accounted_size = add_ram_usage(state.accounted_size, delta);
+            add_budget_usage(cache_obj, delta);
+            add_ram_usage(cache_obj.cell(), delta);
+        }
+
         void add_ram_usage(cache_cell& cell, const int64_t delta) {
             if (!delta || cell.kind() != cache_cell::LRU) {
                 return;
@@ -1107,6 +1483,11 @@ namespace cyberway { namespace chaindb {
         }
 
         if (prev_state) {
+            // the object is accounted in the budget only by its newest state
+            if (prev_state->accounted_size) {
+                cell->map->add_budget_usage(*object_ptr, -int64_t(prev_state->accounted_size));
+                prev_state->accounted_size = 0;
+            }
             prev_state->object_ptr.reset();
         }
         prev_state = nullptr;
@@ -1141,6 +1522,17 @@ namespace cyberway { namespace chaindb {
 
     //-----------------------------------------------------------------------------------------------
 
+    void lru_cache_cell::add_ram_bytes(const lru_cache_object_state& state) {
+        assert(cache_cell::Pending == kind());
+
+        if (!state.object_ptr->service().size) {
+            return;
+        }
+
+        const cache_cell* prev_cell = state.prev_state ? state.prev_state->cell : map->find_evicted_cell(*state.object_ptr);
+        add_ram_bytes(state, prev_cell ? pos() - prev_cell->pos() : max_distance_);
+    }
+
     int64_t lru_cache_cell::commit_revision() {
         int64_t commited_size = 0;
 
@@ -1152,6 +1544,7 @@ namespace cyberway { namespace chaindb {
                 map->remove_cache_object(*state.object_ptr);
             }
 
+            map->forget_evicted_row(*state.object_ptr);
             state.commit();
             if (!state.object_ptr) {
                 continue;
@@ -1160,6 +1553,9 @@ namespace cyberway { namespace chaindb {
             auto delta = state.object_ptr->service().size;
             CYBERWAY_CACHE_ASSERT(!delta || UINT64_MAX - commited_size >= delta, "Commiting delta would overflow UINT64_MAX");
             commited_size += delta;
+
+            state.accounted_size = delta;
+            map->add_budget_usage(*state.object_ptr, delta);
         }
 
         kind_ = cache_cell::LRU;
@@ -1425,4 +1821,32 @@ namespace cyberway { namespace chaindb {
         impl_->push(revision);
     }
 
+    const cache_stats& cache_map::stats() const {
+        return impl_->stats();
+    }
+
+    void cache_map::count_lookup(const bool hit) const {
+        impl_->count_lookup(hit);
+    }
+
+    void cache_map::set_budgets(cache_budget_config config) const {
+        impl_->set_budgets(std::move(config));
+    }
+
+    cache_usage cache_map::usage() const {
+        return impl_->usage();
+    }
+
+    std::vector<cache_hot_key> cache_map::hot_keys(const size_t max_count) const {
+        return impl_->hot_keys(max_count);
+    }
+
+    bool cache_map::start_warm_up() const {
+        return impl_->start_warm_up();
+    }
+
+    void cache_map::push_warm_up() const {
+        impl_->push_warm_up();
+    }
+
 } } // namespace cyberway::chaindb
@@ -210,6 +210,7 @@ namespace cyberway { namespace chaindb {
                 if (!cache_ptr) {
                     cache_ptr = cache_.find_unsuccess(key, request.index, value, size);
                 }
+                cache_.count_lookup(!!cache_ptr);
             }
 
             switch (kind) {
@@ -263,6 +264,7 @@ namespace cyberway { namespace chaindb {
             if (!cache_ptr) {
                 cache_ptr = cache_.find_unsuccess(key);
             }
+            cache_.count_lookup(!!cache_ptr);
 
             switch (kind) {
                 case cursor_kind::ManyRecords:
@@ -376,6 +378,7 @@ namespace cyberway { namespace chaindb {
 
         cache_object_ptr get_cache_object(const cursor_info& cursor, const bool with_blob) {
             auto cache_ptr = cache_.find(cursor.index.to_service(cursor.pk));
+            cache_.count_lookup(!!cache_ptr);
 
             if (BOOST_UNLIKELY(!cache_ptr)) {
                 auto obj = object_at_cursor(cursor, false);
@@ -412,6 +415,7 @@ namespace cyberway { namespace chaindb {
             }
 
             auto cache_ptr = cache_.find(system_abi_info_.to_service(code));
+            cache_.count_lookup(!!cache_ptr);
             if (cache_ptr) {
                 return account_abi_info(std::move(cache_ptr));
             }
@@ -570,6 +574,7 @@ namespace cyberway { namespace chaindb {
 
         object_value object_by_pk(const table_request& request, const primary_key_t pk) {
             auto cache_ptr = cache_.find(request.to_service(pk));
+            cache_.count_lookup(!!cache_ptr);
             if (cache_ptr) {
                 return cache_ptr->object();
             }
@@ -585,6 +590,51 @@ namespace cyberway { namespace chaindb {
             return obj;
         }
 
+        size_t prefetch(const table_request& request, std::vector<primary_key_t> pks) {
+            auto table = find_table<table_info>(request);
+            if (!table.is_valid()) {
+                return 0;
+            }
+            return prefetch(table, std::move(pks), false);
+        }
+
+        size_t warm_up_cache(const std::vector<cache_hot_key>& keys) {
+            if (!cache_.start_warm_up()) {
+                return 0;
+            }
+
+            size_t count = 0;
+            try {
+                for (auto itr = keys.begin(), etr = keys.end(); itr != etr;) {
+                    auto& key = *itr;
+                    std::vector<primary_key_t> pks;
+                    for (; itr != etr && itr->code == key.code && itr->scope == key.scope && itr->table == key.table; ++itr) {
+                        pks.push_back(itr->pk);
+                    }
+
+                    // the table can be changed since the manifest was saved, the rows are loaded on demand
+                    try {
+                        auto table = find_table<table_info>(table_request{key.code, key.scope, key.table});
+                        if (table.is_valid()) {
+                            count += prefetch(table, std::move(pks), true);
+                        }
+                    } catch (const fc::exception& e) {
+                        wlog("Skip warm-up of the table ${table}: ${details}",
+                            ("table", get_full_table_name(key.code, key.table))("details", e.to_detail_string()));
+                    } catch (const std::exception& e) {
+                        wlog("Skip warm-up of the table ${table}: ${details}",
+                            ("table", get_full_table_name(key.code, key.table))("details", e.what()));
+                    }
+                }
+            } catch (...) {
+                cache_.push_warm_up();
+                throw;
+            }
+
+            cache_.push_warm_up();
+            return count;
+        }
+
         eosio::chain::bytes serialize(const abi_info& abi, const object_value& object) {
             return abi.to_bytes(find_table<table_info>(table_request{object.service.code, object.service.scope, object.service.table}), object.value);
         }
@@ -671,6 +721,7 @@ namespace cyberway { namespace chaindb {
 
         cache_object_ptr get_cache_object(const table_info& table, const primary_key_t pk, const bool with_blob) {
             auto cache_ptr = cache_.find(table.to_service(pk));
+            cache_.count_lookup(!!cache_ptr);
 
             if (BOOST_UNLIKELY(!cache_ptr)) {
                 auto obj = driver_.object_by_pk(table, pk);
@@ -688,6 +739,37 @@ namespace cyberway { namespace chaindb {
             return cache_ptr;
         }
 
+        // loads missed rows by batch requests to the driver instead of one request per row
+        size_t prefetch(const table_info& table, std::vector<primary_key_t> pks, const bool in_ram_only) {
+            std::sort(pks.begin(), pks.end());
+            pks.erase(std::unique(pks.begin(), pks.end()), pks.end());
+            pks.erase(std::remove_if(pks.begin(), pks.end(), [&](const primary_key_t pk) {
+                if (!primary_key::is_good(pk)) {
+                    return true;
+                }
+                bool hit = !!cache_.find(table.to_service(pk));
+                cache_.count_lookup(hit);
+                return hit;
+            }), pks.end());
+
+            if (pks.empty()) {
+                return 0;
+            }
+
+            size_t count = 0;
+            for (auto& obj: driver_.objects_by_pk(table, pks)) {
+                if (in_ram_only && !obj.service.in_ram) {
+                    continue;
+                }
+
+                auto pk = obj.pk();
+                validate_object(table, obj, pk);
+                cache_.emplace(table, std::move(obj));
+                ++count;
+            }
+            return count;
+        }
+
         void validate_object(const table_info& table, const object_value& obj, const primary_key_t pk) const {
             if (!primary_key::is_good(obj.pk())) {
                 CYBERWAY_ASSERT(obj.is_null(), driver_wrong_object_exception,
@@ -804,6 +886,14 @@ namespace cyberway { namespace chaindb {
         return impl_->undo_;
     }
 
+    size_t chaindb_controller::prefetch(const table_request& request, std::vector<primary_key_t> pks) const {
+        return impl_->prefetch(request, std::move(pks));
+    }
+
+    size_t chaindb_controller::warm_up_cache(const std::vector<cache_hot_key>& keys) const {
+        return impl_->warm_up_cache(keys);
+    }
+
     void chaindb_controller::restore_db() const {
         impl_->restore_db();
     }
@@ -830,6 +920,15 @@ namespace cyberway { namespace chaindb {
         impl_->driver_.disable_rev_bad_update();
     }
 
+    void chaindb_controller::enable_deferred_indexes() const {
+        impl_->driver_.enable_deferred_indexes();
+    }
+
+    void chaindb_controller::disable_deferred_indexes() const {
+        impl_->driver_.apply_all_changes();
+        impl_->driver_.disable_deferred_indexes();
+    }
+
     void chaindb_controller::close(const cursor_request& request) const {
         impl_->driver_.close(request);
     }
@@ -3,11 +3,13 @@
 #include <cyberway/chaindb/exception.hpp>
 #include <cyberway/chaindb/names.hpp>
 #include <cyberway/chaindb/mongo_driver_utils.hpp>
+#include <cyberway/chaindb/mongo_resident_table.hpp>
 #include <cyberway/chaindb/journal.hpp>
 #include <cyberway/chaindb/abi_info.hpp>
 #include <cyberway/chaindb/noscope_tables.hpp>
 
 #include <bsoncxx/builder/basic/kvp.hpp>
+#include <bsoncxx/builder/basic/array.hpp>
 #include <bsoncxx/builder/basic/document.hpp>
 #include <bsoncxx/exception/exception.hpp>
 
@@ -24,6 +26,7 @@ namespace cyberway { namespace chaindb {
     using bsoncxx::builder::basic::make_document;
     using bsoncxx::builder::basic::document;
     using bsoncxx::builder::basic::sub_document;
+    using bsoncxx::builder::basic::sub_array;
     using bsoncxx::builder::basic::kvp;
 
     using mongocxx::database;
@@ -51,6 +54,9 @@ namespace cyberway { namespace chaindb {
         static const string mongodb_id_index = "_id_";
         static const string mongodb_system   = "system.";
 
+        // limit of keys in one $in request, so the size of the request is far from the limit of BSON document
+        static constexpr size_t max_pk_batch_size = 1000;
+
         template <typename Exception>
         mongo_code get_mongo_code(const Exception& e) {
             auto value = static_cast<mongo_code>(e.code().value());
@@ -140,10 +146,89 @@ namespace cyberway { namespace chaindb {
             CYBERWAY_THROW(driver_open_exception, "Fail to connect to MongoDB server");
         }
 
+        // the same pattern as of the MongoDB index, see create_db_index()
+        mongo_resident_table::key_pattern get_key_pattern(const index_info& info) {
+            mongo_resident_table::key_pattern pattern;
+            auto& index = *info.index;
+
+            if (!is_noscope_table(info)) {
+                pattern.push_back({names::scope_path, 1});
+            }
+            for (auto& order: index.orders) {
+                pattern.push_back({get_order_field(order), is_asc_order(order.order) ? 1 : -1});
+            }
+            if (!index.unique) {
+                pattern.push_back({info.pk_order->field, 1});
+            }
+            return pattern;
+        }
+
+        // types which are stored as one scalar BSON type, so the resident ordering is the same as of MongoDB;
+        //   optional fields (null or value), variants, structs, arrays and binaries aren't supported
+        bool is_resident_key_type(const string& type) {
+            static const std::set<string> types = {
+                "bool",
+                "int8", "int16", "int32", "int64", "varint32",
+                "uint8", "uint16", "uint32", "uint64", "varuint32",
+                "name", "symbol_code", "symbol", "string",
+                "time_point", "time_point_sec", "block_timestamp_type",
+            };
+            return types.count(type);
+        }
+
+        void validate_resident_table(const table_info& info) {
+            index_info index(info);
+            for (auto& def: info.table->indexes) for (auto& order: def.orders) {
+                index.index = &def;
+                CYBERWAY_ASSERT(is_resident_key_type(order.type), driver_unsupported_operation_exception,
+                    "The field ${field} of type ${type} in the index ${index} can't be used in a resident table",
+                    ("field", order.field)("type", order.type)("index", get_full_index_name(index)));
+            }
+        }
+
         collection get_db_table(const mongodb_driver_impl&, const table_info&);
+        mongo_resident_table_ptr get_resident_table(mongodb_driver_impl&, const table_info&);
 
     } } // namespace _detail
 
+    // source of rows for the cursor: a cursor of MongoDB or a cursor of the resident table
+    class mongodb_cursor_source final {
+    public:
+        explicit mongodb_cursor_source(mongocxx::cursor src)
+        : db_source_(std::move(src)) {
+        }
+
+        explicit mongodb_cursor_source(mongo_resident_table::cursor src)
+        : resident_source_(std::move(src)) {
+        }
+
+        bool is_end() {
+            if (resident_source_) {
+                return resident_source_->is_end();
+            }
+            return db_source_->begin() == db_source_->end();
+        }
+
+        document_view current() {
+            if (resident_source_) {
+                return resident_source_->current();
+            }
+            return *db_source_->begin();
+        }
+
+        void next() {
+            if (resident_source_) {
+                resident_source_->next();
+            } else {
+                ++db_source_->begin();
+            }
+        }
+
+    private:
+        std::optional<mongocxx::cursor> db_source_;
+        std::optional<mongo_resident_table::cursor> resident_source_;
+    }; // class mongodb_cursor_source
+
     class mongodb_cursor_info: public cursor_info {
     public:
         mongodb_cursor_info(cursor_t id, index_info index, mongodb_driver_impl& driver)
@@ -241,8 +326,7 @@ namespace cyberway { namespace chaindb {
                 object.service.scope = index.scope;
                 object.service.table = index.table_name();
             } else {
-                auto& view = *source_.value().begin();
-                object = build_object(index, view, with_decors);
+                object = build_object(index, source_->current(), with_decors);
                 pk     = object.service.pk;
             }
 
@@ -269,7 +353,7 @@ namespace cyberway { namespace chaindb {
         primary_key_t find_pk_   = primary_key::Unset;
         variant       find_key_;
 
-        std::optional<mongocxx::cursor> source_;
+        std::optional<mongodb_cursor_source> source_;
         account_name_t scope_ = 0;
         fc::flat_set<primary_key_t> skipped_pk_tree_;
 
@@ -367,14 +451,20 @@ namespace cyberway { namespace chaindb {
 
             _detail::auto_reconnect([&]() {
                 skipped_pk_tree_.clear();
-                source_.emplace(_detail::get_db_table(driver_, index).find({}, opts));
+                auto resident = _detail::get_resident_table(driver_, index);
+                if (resident) {
+                    source_.emplace(mongo_resident_table::open(
+                        std::move(resident), _detail::get_key_pattern(index),
+                        direction_ == direction::Forward, bound.view()));
+                } else {
+                    source_.emplace(_detail::get_db_table(driver_, index).find({}, opts));
+                }
                 try_to_init_pk_value();
             });
         }
 
         bool is_end() {
-            auto& src = source_.value();
-            if (src.begin() == src.end()) {
+            if (source_->is_end()) {
                 return true;
             } else if (!is_noscope_table(index)) {
                 return !ignore_scope(index) && scope_ != index.scope ;
@@ -387,7 +477,7 @@ namespace cyberway { namespace chaindb {
 
             while (!is_end()) {
                 try {
-                    ++source_.value().begin();
+                    source_->next();
                 } catch (const mongocxx::exception& e) {
                     elog("MongoDB error on iterate to next object: ${code}, ${what}",
                         ("code", e.code().value())("what", e.what()));
@@ -418,9 +508,8 @@ namespace cyberway { namespace chaindb {
         }
 
         void init_scope_value() {
-            auto itr = source_.value().begin();
-            if (source_.value().end() != itr) {
-                scope_ = chaindb::get_scope_value(index, *itr);
+            if (!source_->is_end()) {
+                scope_ = chaindb::get_scope_value(index, source_->current());
             }
         }
 
@@ -428,7 +517,7 @@ namespace cyberway { namespace chaindb {
             if (is_end()) {
                 pk = primary_key::End;
             } else {
-                pk = chaindb::get_pk_value(index, *source_.value().begin());
+                pk = chaindb::get_pk_value(index, source_->current());
             }
         }
 
@@ -462,6 +551,20 @@ namespace cyberway { namespace chaindb {
         // https://github.com/cyberway/cyberway/issues/1094
         bool update_pk_with_revision_ = false;
 
+        struct deferred_index final {
+            account_name_t code;
+            table_def      table;
+            index_name_t   index;
+        }; // struct deferred_index
+
+        bool defer_indexes_ = false;
+        std::vector<deferred_index> deferred_indexes_;
+
+        using resident_table_key = std::pair<account_name_t, table_name_t>;
+
+        resident_table_set resident_tables_;
+        std::map<resident_table_key, mongo_resident_table_ptr> resident_table_map_;
+
         mongodb_driver_impl(journal& jrnl, string address, string sys_name)
         : journal_(jrnl),
           sys_code_name_(std::move(sys_name)) {
@@ -614,11 +717,37 @@ namespace cyberway { namespace chaindb {
             get_db_table(info).indexes().drop_one(get_index_name(info));
         }
 
-        void drop_table(const table_info& info) const {
+        void drop_table(const table_info& info) {
+            drop_resident_table(info.code, info.table_name());
             get_db_table(info).drop();
         }
 
-        void create_index(const index_info& info) const {
+        void create_index(const index_info& info) {
+            // system tables are updated during the bulk loading, so they need indexes
+            if (defer_indexes_ && !is_system_code(info.code)) {
+                deferred_indexes_.push_back({info.code, *info.table, info.index->name.value});
+                return;
+            }
+            create_db_index(info);
+        }
+
+        void create_deferred_indexes() {
+            defer_indexes_ = false;
+
+            auto indexes = std::move(deferred_indexes_);
+            deferred_indexes_.clear();
+            for (auto& def: indexes) {
+                index_info info(def.code, def.code);
+                info.table    = &def.table;
+                info.pk_order = &def.table.indexes.front().orders.front();
+                for (auto& index: def.table.indexes) if (index.name.value == def.index) {
+                    info.index = &index;
+                }
+                create_db_index(info);
+            }
+        }
+
+        void create_db_index(const index_info& info) const {
             document idx_doc;
             auto& index = *info.index;
 
@@ -681,6 +810,7 @@ namespace cyberway { namespace chaindb {
             CYBERWAY_ASSERT(code_cursor_map_.empty(), driver_opened_cursors_exception, "ChainDB has opened cursors");
 
             code_cursor_map_.clear(); // close all opened cursors
+            resident_table_map_.clear();
 
             auto db_list = mongo_conn_.list_databases();
             for (auto& db: db_list) {
@@ -701,6 +831,15 @@ namespace cyberway { namespace chaindb {
 
             apply_table_changes(table);
 
+            auto resident = get_resident_table(table);
+            if (resident) {
+                auto row = resident->last({{pk_order->field, 1}});
+                if (row) {
+                    pk = chaindb::get_pk_value(table, row->view()) + 1;
+                }
+                return pk;
+            }
+
             build_bound_document(bound, pk_order->field, -1);
 
             sort.append(kvp(table.pk_order->field, -1));
@@ -735,6 +874,20 @@ namespace cyberway { namespace chaindb {
 
             apply_table_changes(table);
 
+            auto resident = get_resident_table(table);
+            if (resident && !ignore_scope(table)) {
+                auto row = resident->find(table.scope, pk);
+                if (row) {
+                    return build_object(table, row->view(), false);
+                }
+
+                obj.service.pk    = primary_key::End;
+                obj.service.code  = table.code;
+                obj.service.scope = table.scope;
+                obj.service.table = table.table_name();
+                return obj;
+            }
+
             if (!is_noscope_table(table)) {
                 append_scope_value(bound, table);
                 sort.append(kvp(names::scope_path, 1));
@@ -773,10 +926,108 @@ namespace cyberway { namespace chaindb {
             return obj;
         }
 
+        std::vector<object_value> objects_by_pk(const table_info& table, const std::vector<primary_key_t>& pks) {
+            std::vector<object_value> objs;
+            auto& pk_index = table.table->indexes.front();
+            auto& pk_field = table.pk_order->field;
+
+            apply_table_changes(table);
+
+            auto resident = get_resident_table(table);
+            if (resident && !ignore_scope(table)) {
+                for (auto pk: pks) {
+                    auto row = resident->find(table.scope, pk);
+                    if (row) {
+                        objs.push_back(build_object(table, row->view(), false));
+                    }
+                }
+                return objs;
+            }
+
+            auto opts = options::find()
+                .hint(mongocxx::hint(db_name_to_string(pk_index.name)));
+
+            for (size_t first = 0; first < pks.size(); first += _detail::max_pk_batch_size) {
+                auto last = std::min(pks.size(), first + _detail::max_pk_batch_size);
+                document filter;
+
+                if (!is_noscope_table(table)) {
+                    append_scope_value(filter, table);
+                }
+
+                filter.append(kvp(pk_field, [&](sub_document in_doc) {
+                    in_doc.append(kvp("$in", [&](sub_array values) {
+                        for (auto i = first; i < last; ++i) {
+                            // the typed value of the key is built in the same way as for a single row
+                            document pk_doc;
+                            append_pk_value(pk_doc, table, pks[i]);
+                            values.append(pk_doc.view()[pk_field].get_value());
+                        }
+                    }));
+                }));
+
+                auto size = objs.size();
+                _detail::auto_reconnect([&] {
+                    objs.resize(size); // the request can be repeated after reconnecting
+                    for (auto& doc: get_db_table(table).find(filter.view(), opts)) {
+                        if (chaindb::get_scope_value(table, doc) == table.scope) {
+                            objs.push_back(build_object(table, doc, false));
+                        }
+                    }
+                });
+            }
+
+            return objs;
+        }
+
         collection get_db_table(const table_info& table) const {
             return get_db_table(table.code, table.table_name());
         }
 
+        // loads the designated table on the first request
+        mongo_resident_table_ptr get_resident_table(const table_info& table) {
+            resident_table_key key(table.code, table.table_name());
+            if (!resident_tables_.count(key)) {
+                return {};
+            }
+
+            auto itr = resident_table_map_.find(key);
+            if (resident_table_map_.end() != itr) {
+                return itr->second;
+            }
+
+            _detail::validate_resident_table(table);
+
+            mongo_resident_table_ptr resident;
+            _detail::auto_reconnect([&] {
+                resident = std::make_shared<mongo_resident_table>(key.first, key.second);
+                for (auto& doc: get_db_table(table).find({})) {
+                    resident->insert(
+                        chaindb::get_scope_value(table, doc), chaindb::get_pk_value(table, doc),
+                        bsoncxx::document::value(doc));
+                }
+            });
+
+            ilog("The table ${table} is loaded to RAM with ${rows} rows",
+                ("table", get_full_table_name(table))("rows", resident->size()));
+
+            resident_table_map_.emplace(key, resident);
+            return resident;
+        }
+
+        // only loaded tables are changed, other tables will be loaded from the database
+        mongo_resident_table_ptr find_resident_table(const account_name_t code, const table_name_t table) const {
+            auto itr = resident_table_map_.find({code, table});
+            if (resident_table_map_.end() == itr) {
+                return {};
+            }
+            return itr->second;
+        }
+
+        void drop_resident_table(const account_name_t code, const table_name_t table) {
+            resident_table_map_.erase({code, table});
+        }
+
     private:
         static mongocxx::instance& init_instance() {
             static mongocxx::instance instance;
@@ -832,6 +1083,11 @@ namespace cyberway { namespace chaindb {
             struct bulk_info_t_ final {
                 document pk;
                 document data;
+
+                // for the resident table
+                scope_name_t  scope = 0;
+                primary_key_t pk_value = primary_key::Unset;
+                revision_t    find_revision = impossible_revision;
             }; // struct bulk_info_t_
 
             struct bulk_group_t_ final {
@@ -843,6 +1099,8 @@ namespace cyberway { namespace chaindb {
                 std::deque<bulk_info_t_> revision;
                 std::deque<bulk_info_t_> insert;
 
+                mongo_resident_table_ptr resident;
+
                 bulk_group_t_() = default;
 
                 bulk_group_t_(const table_info& info)
@@ -871,6 +1129,7 @@ namespace cyberway { namespace chaindb {
                     table.table_name() != old_table->table_name()
                 ) {
                     bulk_list_.emplace_back(table);
+                    bulk_list_.back().resident = impl_.find_resident_table(table.code, table.table_name());
                 }
             }
 
@@ -905,6 +1164,7 @@ namespace cyberway { namespace chaindb {
             bulk_group_t_ prepare_undo_bulk_;
 
             std::string error_;
+            int error_cnt_ = 0;
             const table_info* table_ = nullptr;
 
             template <typename BuildFindDocument, typename BuildServiceDocument>
@@ -929,6 +1189,9 @@ namespace cyberway { namespace chaindb {
                     }
                 }();
 
+                dst.scope    = table_->scope;
+                dst.pk_value = op.object.service.pk;
+
                 switch (op.operation) {
                     case write_operation::Insert:
                     case write_operation::Update:
@@ -943,6 +1206,7 @@ namespace cyberway { namespace chaindb {
                         // https://github.com/cyberway/cyberway/issues/1094
                         if (impl_.update_pk_with_revision_ && op.find_revision >= start_revision) {
                             dst.pk.append(kvp(names::revision_path, op.find_revision));
+                            dst.find_revision = op.find_revision;
                         }
                         break;
 
@@ -985,8 +1249,73 @@ namespace cyberway { namespace chaindb {
                     ++update_cnt;
                 }
 
-                execute_bulk(group, remove_cnt, remove_bulk);
-                execute_bulk(group, update_cnt, update_bulk);
+                auto error_cnt = error_cnt_;
+                try {
+                    execute_bulk(group, remove_cnt, remove_bulk);
+                    execute_bulk(group, update_cnt, update_bulk);
+                } catch (...) {
+                    if (group.resident) impl_.drop_resident_table(group.code, group.table);
+                    throw;
+                }
+
+                if (!group.resident) {
+                    return;
+                } else if (error_cnt != error_cnt_) {
+                    // it is unknown which operations were done, the table will be loaded again
+                    impl_.drop_resident_table(group.code, group.table);
+                } else {
+                    apply_resident(group);
+                }
+            }
+
+            // repeats the operations of the group in the same order as MongoDB does
+            void apply_resident(bulk_group_t_& group) {
+                auto& resident = *group.resident;
+
+                auto find_row = [&](const bulk_info_t_& src) -> mongo_resident_table::row_ptr {
+                    auto row = resident.find(src.scope, src.pk_value);
+                    if (row && src.find_revision != impossible_revision) {
+                        auto service = row->view()[names::service_field].get_document().value;
+                        auto rev = service[names::revision_field];
+                        if (!rev || rev.get_int64().value != src.find_revision) {
+                            return {};
+                        }
+                    }
+                    return row;
+                };
+
+                for (auto& src: group.remove) {
+                    if (find_row(src)) {
+                        resident.erase(src.scope, src.pk_value);
+                    }
+                }
+
+                for (auto& src: group.update) {
+                    if (find_row(src)) {
+                        resident.insert(src.scope, src.pk_value, bsoncxx::document::value(src.data.view()));
+                    }
+                }
+
+                for (auto& src: group.revision) {
+                    auto row = find_row(src);
+                    if (!row) continue;
+
+                    // $set of the service field keeps the order of fields
+                    document doc;
+                    auto service = src.data.view()[names::service_field];
+                    for (auto& elem: row->view()) {
+                        if (!elem.key().compare(names::service_field)) {
+                            doc.append(kvp(names::service_field, service.get_value()));
+                        } else {
+                            doc.append(kvp(elem.key(), elem.get_value()));
+                        }
+                    }
+                    resident.insert(src.scope, src.pk_value, doc.extract());
+                }
+
+                for (auto& src: group.insert) {
+                    resident.insert(src.scope, src.pk_value, bsoncxx::document::value(src.data.view()));
+                }
             }
 
             void execute_bulk(bulk_group_t_& group, const int op_cnt, mongocxx::bulk_write& bulk) {
@@ -1019,6 +1348,7 @@ namespace cyberway { namespace chaindb {
                         ("code", e.code().value())("what", e.what()));
 
                     error_ = e.what();
+                    ++error_cnt_;
                 }
             }
         }; // class write_ctx_t_
@@ -1029,6 +1359,10 @@ namespace cyberway { namespace chaindb {
         collection get_db_table(const mongodb_driver_impl& driver, const table_info& info) {
             return driver.get_db_table(info);
         }
+
+        mongo_resident_table_ptr get_resident_table(mongodb_driver_impl& driver, const table_info& info) {
+            return driver.get_resident_table(info);
+        }
     } } // namespace _detail
 
     ///----
@@ -1059,6 +1393,19 @@ namespace cyberway { namespace chaindb {
         impl_->skip_op_cnt_checking_ = false;
     }
 
+    void mongodb_driver::set_resident_tables(resident_table_set tables) const {
+        impl_->resident_tables_ = std::move(tables);
+        impl_->resident_table_map_.clear();
+    }
+
+    void mongodb_driver::enable_deferred_indexes() const {
+        impl_->defer_indexes_ = true;
+    }
+
+    void mongodb_driver::disable_deferred_indexes() const {
+        impl_->create_deferred_indexes();
+    }
+
     std::vector<table_def> mongodb_driver::db_tables(const account_name& code) const {
         return impl_->db_tables(code);
     }
@@ -1170,6 +1517,12 @@ namespace cyberway { namespace chaindb {
         return impl_->object_by_pk(table, pk);
     }
 
+    std::vector<object_value> mongodb_driver::objects_by_pk(
+        const table_info& table, const std::vector<primary_key_t>& pks
+    ) const {
+        return impl_->objects_by_pk(table, pks);
+    }
+
     const object_value& mongodb_driver::object_at_cursor(const cursor_info& info, bool with_decors) const {
         return impl_->get_applied_cursor(info)
             .get_object_value(with_decors);
@@ -31,6 +31,18 @@ namespace cyberway { namespace chaindb {
         NOT_SUPPORTED;
     }
 
+    void mongodb_driver::enable_deferred_indexes() const {
+        NOT_SUPPORTED;
+    }
+
+    void mongodb_driver::disable_deferred_indexes() const {
+        NOT_SUPPORTED;
+    }
+
+    void mongodb_driver::set_resident_tables(resident_table_set) const {
+        NOT_SUPPORTED;
+    }
+
     std::vector<table_def> mongodb_driver::db_tables(const account_name&) const {
         NOT_SUPPORTED;
     }
@@ -119,6 +131,10 @@ namespace cyberway { namespace chaindb {
         NOT_SUPPORTED;
     }
 
+    std::vector<object_value> mongodb_driver::objects_by_pk(const table_info&, const std::vector<primary_key_t>&) const {
+        NOT_SUPPORTED;
+    }
+
     const object_value& mongodb_driver::object_at_cursor(const cursor_info&, bool ) const {
         NOT_SUPPORTED;
     }
@@ -0,0 +1,400 @@
+#include <cyberway/chaindb/mongo_resident_table.hpp>
+
+#include <cmath>
+#include <cstring>
+
+#include <bsoncxx/array/view.hpp>
+#include <bsoncxx/types.hpp>
+
+namespace cyberway { namespace chaindb {
+
+    using bsoncxx::document::element;
+    using document_view = bsoncxx::document::view;
+
+    namespace { namespace _detail {
+
+        // canonical types of MongoDB define the order of values of different types
+        int get_type_rank(const element& elem) {
+            if (!elem) return 1; // missing field is indexed as null
+
+            switch (elem.type()) {
+                case bsoncxx::type::k_minkey:      return 0;
+                case bsoncxx::type::k_undefined:
+                case bsoncxx::type::k_null:        return 1;
+                case bsoncxx::type::k_int32:
+                case bsoncxx::type::k_int64:
+                case bsoncxx::type::k_double:
+                case bsoncxx::type::k_decimal128:  return 2;
+                case bsoncxx::type::k_utf8:
+                case bsoncxx::type::k_symbol:      return 3;
+                case bsoncxx::type::k_document:    return 4;
+                case bsoncxx::type::k_array:       return 5;
+                case bsoncxx::type::k_binary:      return 6;
+                case bsoncxx::type::k_oid:         return 7;
+                case bsoncxx::type::k_bool:        return 8;
+                case bsoncxx::type::k_date:        return 9;
+                case bsoncxx::type::k_timestamp:   return 10;
+                case bsoncxx::type::k_regex:       return 11;
+                case bsoncxx::type::k_dbpointer:   return 12;
+                case bsoncxx::type::k_code:        return 13;
+                case bsoncxx::type::k_codewscope:  return 14;
+                case bsoncxx::type::k_maxkey:      return 15;
+                default:                           return 15;
+            }
+        }
+
+        template <typename T>
+        int compare_values(const T& l, const T& r) {
+            if (l < r) return -1;
+            if (r < l) return  1;
+            return 0;
+        }
+
+        struct number_value final {
+            bool        is_nan   = false;
+            bool        is_exact = true; // integer value without loss of precision
+            __int128    exact    = 0;
+            long double approx   = 0;
+        }; // struct number_value
+
+        number_value get_number(const element& elem) {
+            number_value num;
+
+            switch (elem.type()) {
+                case bsoncxx::type::k_int32:
+                    num.exact = elem.get_int32().value;
+                    break;
+
+                case bsoncxx::type::k_int64:
+                    num.exact = elem.get_int64().value;
+                    break;
+
+                case bsoncxx::type::k_double:
+                    num.is_exact = false;
+                    num.approx   = elem.get_double().value;
+                    num.is_nan   = std::isnan(num.approx);
+                    break;
+
+                case bsoncxx::type::k_decimal128: {
+                    // the BID encoding of IEEE 754-2008
+                    auto value = elem.get_decimal128().value;
+                    uint64_t high = value.high();
+                    uint64_t low  = value.low();
+                    bool     neg  = high >> 63;
+
+                    if (((high >> 61) & 3) == 3) {
+                        // infinity, NaN or non-canonical large coefficient which is equal to zero
+                        if (((high >> 58) & 0x1f) == 0x1f) {
+                            num.is_nan = true;
+                        } else if (((high >> 58) & 0x1f) == 0x1e) {
+                            num.is_exact = false;
+                            num.approx   = neg ? -HUGE_VALL : HUGE_VALL;
+                        }
+                        break;
+                    }
+
+                    int  exp   = int((high >> 49) & 0x3fff) - 6176;
+                    auto coeff = (static_cast<unsigned __int128>(high & 0x1ffffffffffffULL) << 64) | low;
+                    if (0 == exp) {
+                        num.exact = neg ? -static_cast<__int128>(coeff) : static_cast<__int128>(coeff);
+                    } else {
+                        num.is_exact = false;
+                        // division by the exact power keeps values like 1.5 equal to the same doubles
+                        num.approx   = exp > 0
+                            ? static_cast<long double>(coeff) * std::pow(10.0L, exp)
+                            : static_cast<long double>(coeff) / std::pow(10.0L, -exp);
+                        if (neg) num.approx = -num.approx;
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+
+            return num;
+        }
+
+        int compare_numbers(const element& l, const element& r) {
+            auto lnum = get_number(l);
+            auto rnum = get_number(r);
+
+            // NaN is less than any other number
+            if (lnum.is_nan || rnum.is_nan) {
+                return compare_values(!lnum.is_nan, !rnum.is_nan);
+            }
+
+            if (lnum.is_exact && rnum.is_exact) {
+                return compare_values(lnum.exact, rnum.exact);
+            }
+
+            auto lvalue = lnum.is_exact ? static_cast<long double>(lnum.exact) : lnum.approx;
+            auto rvalue = rnum.is_exact ? static_cast<long double>(rnum.exact) : rnum.approx;
+            return compare_values(lvalue, rvalue);
+        }
+
+        template <typename String>
+        int compare_strings(const String& l, const String& r) {
+            auto res = l.compare(r);
+            return res < 0 ? -1 : (res > 0 ? 1 : 0);
+        }
+
+        int compare_documents(const document_view& l, const document_view& r) {
+            auto litr = l.begin();
+            auto ritr = r.begin();
+
+            for (; l.end() != litr && r.end() != ritr; ++litr, ++ritr) {
+                auto res = compare_values(get_type_rank(*litr), get_type_rank(*ritr));
+                if (!res) res = compare_strings(litr->key(), ritr->key());
+                if (!res) res = compare_bson_values(*litr, *ritr);
+                if (res) return res;
+            }
+
+            return compare_values(l.end() != litr, r.end() != ritr);
+        }
+
+        document_view get_array_document(const element& elem) {
+            // BSON array is a document with the keys "0", "1", ...
+            auto array = elem.get_array().value;
+            return document_view(array.data(), array.length());
+        }
+
+        int compare_binaries(const bsoncxx::types::b_binary& l, const bsoncxx::types::b_binary& r) {
+            auto res = compare_values(l.size, r.size);
+            if (!res) res = compare_values(static_cast<int>(l.sub_type), static_cast<int>(r.sub_type));
+            if (!res && l.size) res = std::memcmp(l.bytes, r.bytes, l.size);
+            return res < 0 ? -1 : (res > 0 ? 1 : 0);
+        }
+
+        element find_field(document_view view, const string& path) {
+            string::size_type pos = 0;
+            while (true) {
+                auto end  = path.find('.', pos);
+                auto size = (string::npos == end ? path.size() : end) - pos;
+                auto elem = view[bsoncxx::stdx::string_view(path.data() + pos, size)];
+
+                if (string::npos == end || !elem) {
+                    return elem;
+                } else if (elem.type() != bsoncxx::type::k_document) {
+                    return element();
+                }
+
+                view = elem.get_document().value;
+                pos  = end + 1;
+            }
+        }
+
+    } } // namespace _detail
+
+    int compare_bson_values(const element& l, const element& r) {
+        auto lrank = _detail::get_type_rank(l);
+        auto rrank = _detail::get_type_rank(r);
+
+        if (lrank != rrank) {
+            return _detail::compare_values(lrank, rrank);
+        }
+
+        switch (lrank) {
+            case 2:
+                return _detail::compare_numbers(l, r);
+
+            case 3: {
+                auto lvalue = l.type() == bsoncxx::type::k_utf8 ? l.get_utf8().value : l.get_symbol().symbol;
+                auto rvalue = r.type() == bsoncxx::type::k_utf8 ? r.get_utf8().value : r.get_symbol().symbol;
+                return _detail::compare_strings(lvalue, rvalue);
+            }
+
+            case 4:
+                return _detail::compare_documents(l.get_document().value, r.get_document().value);
+
+            case 5:
+                return _detail::compare_documents(_detail::get_array_document(l), _detail::get_array_document(r));
+
+            case 6:
+                return _detail::compare_binaries(l.get_binary(), r.get_binary());
+
+            case 7: {
+                auto res = std::memcmp(l.get_oid().value.bytes(), r.get_oid().value.bytes(), l.get_oid().value.size());
+                return res < 0 ? -1 : (res > 0 ? 1 : 0);
+            }
+
+            case 8:
+                return _detail::compare_values(l.get_bool().value, r.get_bool().value);
+
+            case 9:
+                return _detail::compare_values(l.get_date().value.count(), r.get_date().value.count());
+
+            case 10: {
+                auto lvalue = l.get_timestamp();
+                auto rvalue = r.get_timestamp();
+                auto res = _detail::compare_values(lvalue.timestamp, rvalue.timestamp);
+                return res ? res : _detail::compare_values(lvalue.increment, rvalue.increment);
+            }
+
+            default:
+                // MinKey, null, MaxKey and types which aren't used by chaindb
+                return 0;
+        }
+    }
+
+    ///----
+
+    int mongo_resident_table::key_compare::compare(const key_type& l, const key_type& r) const {
+        auto size = std::min(std::min(l.size(), r.size()), pattern->size());
+        for (size_t i = 0; i < size; ++i) {
+            auto res = compare_bson_values(l[i], r[i]);
+            if (res) return res * (*pattern)[i].order;
+        }
+        return 0;
+    }
+
+    ///----
+
+    mongo_resident_table::cursor::cursor(
+        std::shared_ptr<const mongo_resident_table> table, const index& idx, const bool forward, const key_type& bound
+    ) : table_(std::move(table)),
+        index_(idx),
+        forward_(forward),
+        version_(table_->version_) {
+
+        auto itr = index_.tree.lower_bound(bound);
+        if (forward_) {
+            set_position(itr);
+        } else if (index_.tree.begin() != itr) {
+            set_position(std::prev(itr));
+        }
+    }
+
+    void mongo_resident_table::cursor::set_position(const index::tree_type::const_iterator itr) {
+        if (index_.tree.end() == itr) {
+            is_end_  = true;
+            current_ = entry();
+        } else {
+            is_end_  = false;
+            itr_     = itr;
+            current_ = *itr;
+        }
+    }
+
+    void mongo_resident_table::cursor::next() {
+        if (is_end_) {
+            return;
+        }
+
+        auto& tree = index_.tree;
+        if (version_ != table_->version_) {
+            // the table was changed, so the iterator can be invalid - locate the position from the last key
+            version_ = table_->version_;
+            if (forward_) {
+                itr_ = tree.upper_bound(current_);
+            } else {
+                itr_ = tree.lower_bound(current_);
+            }
+        } else if (forward_) {
+            ++itr_;
+        }
+
+        if (forward_) {
+            set_position(itr_);
+        } else if (tree.begin() != itr_) {
+            set_position(std::prev(itr_));
+        } else {
+            set_position(tree.end());
+        }
+    }
+
+    ///----
+
+    mongo_resident_table::mongo_resident_table(const account_name_t code, const table_name_t table)
+    : code_(code),
+      table_(table) {
+    }
+
+    mongo_resident_table::row_ptr mongo_resident_table::find(const scope_name_t scope, const primary_key_t pk) const {
+        auto itr = rows_.find({scope, pk});
+        if (rows_.end() == itr) {
+            return {};
+        }
+        return itr->second;
+    }
+
+    mongo_resident_table::row_ptr mongo_resident_table::last(const key_pattern& pattern) const {
+        auto& tree = get_index(pattern).tree;
+        if (tree.empty()) {
+            return {};
+        }
+        return tree.rbegin()->row;
+    }
+
+    mongo_resident_table::cursor mongo_resident_table::open(
+        std::shared_ptr<const mongo_resident_table> table, const key_pattern& pattern, const bool forward,
+        const document_view& bound
+    ) {
+        auto& idx = table->get_index(pattern);
+
+        key_type key;
+        key.reserve(pattern.size());
+        for (auto& elem: bound) {
+            key.push_back(elem);
+        }
+
+        return cursor(std::move(table), idx, forward, key);
+    }
+
+    void mongo_resident_table::insert(
+        const scope_name_t scope, const primary_key_t pk, bsoncxx::document::value row
+    ) {
+        row_key id(scope, pk);
+        erase(scope, pk);
+
+        auto ptr = std::make_shared<const bsoncxx::document::value>(std::move(row));
+        for (auto& idx: indexes_) {
+            idx.second->tree.insert(make_entry(idx.first, id, ptr));
+        }
+        rows_.emplace(id, std::move(ptr));
+        ++version_;
+    }
+
+    bool mongo_resident_table::erase(const scope_name_t scope, const primary_key_t pk) {
+        auto itr = rows_.find({scope, pk});
+        if (rows_.end() == itr) {
+            return false;
+        }
+
+        for (auto& idx: indexes_) {
+            idx.second->tree.erase(make_entry(idx.first, itr->first, itr->second));
+        }
+        rows_.erase(itr);
+        ++version_;
+        return true;
+    }
+
+    const mongo_resident_table::index& mongo_resident_table::get_index(const key_pattern& pattern) const {
+        auto itr = indexes_.find(pattern);
+        if (indexes_.end() != itr) {
+            return *itr->second;
+        }
+
+        auto idx = std::make_unique<index>(pattern);
+        for (auto& row: rows_) {
+            idx->tree.insert(make_entry(pattern, row.first, row.second));
+        }
+        return *indexes_.emplace(pattern, std::move(idx)).first->second;
+    }
+
+    mongo_resident_table::entry mongo_resident_table::make_entry(
+        const key_pattern& pattern, const row_key& id, const row_ptr& row
+    ) const {
+        entry dst;
+        dst.id  = id;
+        dst.row = row;
+
+        dst.key.reserve(pattern.size());
+        auto view = row->view();
+        for (auto& field: pattern) {
+            dst.key.push_back(_detail::find_field(view, field.path));
+        }
+        return dst;
+    }
+
+} } // namespace cyberway::chaindb
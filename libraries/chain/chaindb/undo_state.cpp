@@ -284,6 +284,57 @@ namespace cyberway { namespace chaindb {
         return obj;
     }
 
+    // Undo states are created and discarded for each transaction and block.
+    // Nodes of their maps are recycled, so a changed row doesn't cost a pair of allocations,
+    //   and rows are moved between states by splicing of nodes.
+    struct undo_node_pool final {
+        using map_type  = undo_state::pk_value_map_t_;
+        using node_type = map_type::node_type;
+
+        void emplace(map_type& map, const primary_key_t pk, object_value obj) {
+            if (nodes_.empty()) {
+                map.emplace(pk, std::move(obj));
+                return;
+            }
+
+            auto node = std::move(nodes_.back());
+            nodes_.pop_back();
+
+            node.key()    = pk;
+            node.mapped() = std::move(obj);
+            map.insert(std::move(node));
+        }
+
+        void recycle(node_type node) {
+            if (nodes_.size() < max_size) {
+                node.mapped() = object_value();
+                nodes_.push_back(std::move(node));
+            }
+        }
+
+        void release(map_type& map) {
+            while (!map.empty() && nodes_.size() < max_size) {
+                recycle(map.extract(map.begin()));
+            }
+            map.clear();
+        }
+
+        void release(undo_state& state) {
+            release(state.new_values_);
+            release(state.old_values_);
+            release(state.removed_values_);
+        }
+
+        static void splice(map_type& dst, map_type& src, map_type::iterator itr) {
+            dst.insert(src.extract(itr));
+        }
+
+    private:
+        static constexpr size_t max_size = 16 * 1024;
+
+        std::vector<node_type> nodes_;
+    }; // struct undo_node_pool
+
     struct undo_stack_impl final {
         undo_stack_impl(revision_t& revision, chaindb_controller& controller, journal& jrnl)
         : revision_(revision),
@@ -638,6 +689,7 @@ namespace cyberway { namespace chaindb {
 
             remove_next_pk(ctx, table, head);
 
+            pool_.release(head);
             table.undo();
         }
 
@@ -677,7 +729,7 @@ namespace cyberway { namespace chaindb {
             table.squash();
         }
 
-        void remove_state(table_undo_stack& table, undo_state& state) const {
+        void remove_state(table_undo_stack& table, undo_state& state) {
             auto ctx = journal_.create_ctx(table.info());
 
             process_state(state, [&](bool has_data, auto& obj, auto& rev) {
@@ -690,6 +742,7 @@ namespace cyberway { namespace chaindb {
 
             remove_next_pk(ctx, table, state);
 
+            pool_.release(state);
             table.undo();
         }
 
@@ -767,7 +820,8 @@ namespace cyberway { namespace chaindb {
 
             auto ctx = journal_.create_ctx(table.info());
 
-            for (auto& obj: state.old_values_) {
+            for (auto itr = state.old_values_.begin(), etr = state.old_values_.end(); etr != itr; ) {
+                auto& obj = *itr;
                 const auto pk = obj.second.pk();
                 bool  exists = false;
 
@@ -790,6 +844,7 @@ namespace cyberway { namespace chaindb {
                     journal_.write(ctx,
                         write_operation::revision(state.revision(), obj.second.clone_service()),
                         write_operation::remove(  state.revision(), obj.second.clone_service()));
+                    ++itr;
                     continue;
                 }
 
@@ -805,11 +860,12 @@ namespace cyberway { namespace chaindb {
                     write_operation::revision(state.revision(), obj.second.clone_service()));
 
                 obj.second.service.revision = prev_state.revision();
-                
-                prev_state.old_values_.emplace(pk, std::move(obj.second));
+
+                undo_node_pool::splice(prev_state.old_values_, state.old_values_, itr++);
             }
 
-            for (auto& obj: state.new_values_) {
+            for (auto itr = state.new_values_.begin(), etr = state.new_values_.end(); etr != itr; ) {
+                auto& obj = *itr;
                 const auto pk = obj.second.pk();
 
                 cache_.set_revision(obj.second, prev_state.revision());
@@ -823,8 +879,8 @@ namespace cyberway { namespace chaindb {
                     ritr->second.service.undo_rec = undo_record::OldValue;
                     journal_.write_undo(ctx, write_operation::update(ritr->second));
 
-                    prev_state.old_values_.emplace(std::move(*ritr));
-                    prev_state.removed_values_.erase(ritr);
+                    undo_node_pool::splice(prev_state.old_values_, prev_state.removed_values_, ritr);
+                    ++itr;
                 } else {
                     // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
 
@@ -834,30 +890,32 @@ namespace cyberway { namespace chaindb {
 
                     obj.second.service.revision = prev_state.revision();
 
-                    prev_state.new_values_.emplace(pk, std::move(obj.second));
+                    undo_node_pool::splice(prev_state.new_values_, state.new_values_, itr++);
                 }
             }
 
             // *+del
-            for (auto& obj: state.removed_values_) {
+            for (auto itr = state.removed_values_.begin(), etr = state.removed_values_.end(); etr != itr; ) {
+                auto& obj = *itr;
                 const auto pk = obj.second.pk();
 
                 // new + del -> nop (type C)
                 auto nitr = prev_state.new_values_.find(pk);
                 if (nitr != prev_state.new_values_.end()) {
-                    prev_state.new_values_.erase(nitr);
+                    pool_.recycle(prev_state.new_values_.extract(nitr));
 
                     journal_.write_undo(ctx, write_operation::remove(state.revision(), obj.second.clone_service()));
+                    ++itr;
                     continue;
                 }
 
                 // upd(was=X) + del(was=Y) -> del(was=X)
                 auto oitr = prev_state.old_values_.find(pk);
                 if (oitr != prev_state.old_values_.end()) {
-                    prev_state.removed_values_.emplace(std::move(*oitr));
-                    prev_state.old_values_.erase(oitr);
+                    undo_node_pool::splice(prev_state.removed_values_, prev_state.old_values_, oitr);
 
                     journal_.write_undo(ctx, write_operation::remove(state.revision(), obj.second.clone_service()));
+                    ++itr;
                     continue;
                 }
 
@@ -870,8 +928,8 @@ namespace cyberway { namespace chaindb {
                 journal_.write_undo(ctx, write_operation::revision(state.revision(), obj.second.clone_service()));
                 
                 obj.second.service.revision = prev_state.revision();
-                
-                prev_state.removed_values_.emplace(std::move(obj));
+
+                undo_node_pool::splice(prev_state.removed_values_, state.removed_values_, itr++);
             }
 
             if (state.has_next_pk()) {
@@ -883,6 +941,7 @@ namespace cyberway { namespace chaindb {
                 }
             }
 
+            pool_.release(state);
             table.undo();
         }
 
@@ -902,6 +961,7 @@ namespace cyberway { namespace chaindb {
                 });
                 remove_next_pk(ctx, table, state);
 
+                pool_.release(state);
                 table.commit();
             }
         }
@@ -940,14 +1000,13 @@ namespace cyberway { namespace chaindb {
                 copy_undo_object(ritr->second, obj, undo_record::OldValue);
                 journal_.write_undo(ctx, write_operation::update(ritr->second.clone_service()));
 
-                head.old_values_.emplace(std::move(*ritr));
-                head.removed_values_.erase(ritr);
+                undo_node_pool::splice(head.old_values_, head.removed_values_, ritr);
                 return;
             }
 
             init_undo_object(obj, undo_record::NewValue);
             journal_.write_undo(ctx, write_operation::insert(obj.clone_service()));
-            head.new_values_.emplace(pk, std::move(obj));
+            pool_.emplace(head.new_values_, pk, std::move(obj));
 
             if (!head.has_next_pk()) {
                 head.set_next_pk(pk, generate_undo_pk());
@@ -981,7 +1040,7 @@ namespace cyberway { namespace chaindb {
             init_undo_object(orig_obj, undo_record::OldValue);
             copy_undo_object(orig_obj, obj);
             journal_.write_undo(ctx, write_operation::insert(orig_obj));
-            head.old_values_.emplace(pk, std::move(orig_obj));
+            pool_.emplace(head.old_values_, pk, std::move(orig_obj));
         }
 
         void remove(table_undo_stack& table, object_value orig_obj) {
@@ -993,8 +1052,9 @@ namespace cyberway { namespace chaindb {
 
             auto nitr = head.new_values_.find(pk);
             if (head.new_values_.end() != nitr) {
-                journal_.write_undo(ctx, write_operation::remove(std::move(nitr->second)));
-                head.new_values_.erase(nitr);
+                auto node = head.new_values_.extract(nitr);
+                journal_.write_undo(ctx, write_operation::remove(std::move(node.mapped())));
+                pool_.recycle(std::move(node));
                 return;
             }
 
@@ -1003,14 +1063,13 @@ namespace cyberway { namespace chaindb {
                 oitr->second.service.undo_rec = undo_record::RemovedValue;
                 journal_.write_undo(ctx, write_operation::update(oitr->second));
 
-                head.removed_values_.emplace(std::move(*oitr));
-                head.old_values_.erase(oitr);
+                undo_node_pool::splice(head.removed_values_, head.old_values_, oitr);
                 return;
             }
 
             init_undo_object(orig_obj, undo_record::RemovedValue);
             journal_.write_undo(ctx, write_operation::insert(orig_obj));
-            head.removed_values_.emplace(pk, std::move(orig_obj));
+            pool_.emplace(head.removed_values_, pk, std::move(orig_obj));
         }
 
         table_undo_stack& get_table(const table_info& table) {
@@ -1050,6 +1109,7 @@ namespace cyberway { namespace chaindb {
         revision_t    tail_revision_ = 0;
         primary_key_t undo_pk_ = 1;
         index_t_      tables_;
+        undo_node_pool pool_;
 
         const chaindb_controller& controller_;
         const driver_interface&   driver_;
@@ -15,11 +15,15 @@
 
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/resource_limits_private.hpp>
 #include <eosio/chain/stake.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/snapshot_controller.hpp>
+#include <eosio/chain/replay_profiler.hpp>
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
 
 #include <chainbase/chainbase.hpp>
+#include <fc/io/fstream.hpp>
 #include <fc/io/json.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
@@ -30,12 +34,16 @@
 #include <cyberway/chain/cyberway_contract_types.hpp>
 #include <cyberway/chain/cyberway_contract.hpp>
 
+#include <fstream>
+
 namespace eosio { namespace chain {
 
 
 using resource_limits::resource_limits_manager;
 using cyberway::chaindb::cursor_kind;
 
+static constexpr uint32_t cache_manifest_version = 1;
+
 using controller_index_set = table_set<
    account_table,
    account_sequence_table,
@@ -163,6 +171,7 @@ struct controller_impl {
    controller::config             conf;
    chain_id_type                  chain_id;
    bool                           replaying= false;
+   bool                           replay_stopped = false;
    optional<fc::time_point>       replay_head_time;
    db_read_mode                   read_mode = db_read_mode::SPECULATIVE;
    bool                           in_trx_requiring_checks = false; ///< if true, checks that are normally skipped on replay (e.g. auth checks) cannot be skipped
@@ -170,7 +179,11 @@ struct controller_impl {
    bool                           trusted_producer_light_validation = false;
    uint32_t                       snapshot_head_block = 0;
    boost::asio::thread_pool       thread_pool;
+   std::future<void>              cache_manifest_future;
    bool                           skip_bad_blocks_check = false;
+   transaction_dedupe_index       dedupe_index;
+   deferred_transaction_scheduler deferred_scheduler;
+   std::unique_ptr<replay_profiler> profiler;
 
    typedef pair<scope_name,action_name>                   handler_key;
    map< account_name, map<handler_key, apply_handler> >   apply_handlers;
@@ -205,6 +218,7 @@ struct controller_impl {
 // TODO: removed by CyberWay
 //      db.undo();
       chaindb.undo_last_revision();
+      deferred_scheduler.reset();
    }
 
 
@@ -222,7 +236,7 @@ struct controller_impl {
     reversible_blocks( cfg.blocks_dir/config::reversible_blocks_dir_name,
         cfg.read_only ? database::read_only : database::read_write,
         cfg.reversible_cache_size ),
-    blog( cfg.blocks_dir ),
+    blog( cfg.blocks_dir, cfg.blocks_log ),
     fork_db( cfg.state_dir ),
     wasmif( cfg.wasm_runtime ),
     resource_limits( chaindb ),
@@ -230,8 +244,13 @@ struct controller_impl {
     conf( cfg ),
     chain_id( cfg.genesis.compute_chain_id() ),
     read_mode( cfg.read_mode ),
-    thread_pool( cfg.thread_pool_size )
+    thread_pool( cfg.thread_pool_size ),
+    deferred_scheduler( chaindb )
    {
+   if( !cfg.replay_profile_file.empty() ) {
+      profiler = std::make_unique<replay_profiler>( cfg.replay_profile_first_block, cfg.replay_profile_last_block,
+                                                    cfg.replay_profile_file );
+   }
 
 #define SET_APP_HANDLER( receiver, contract, action) \
    set_apply_handler( #receiver, #contract, #action, &BOOST_PP_CAT(apply_, BOOST_PP_CAT(contract, BOOST_PP_CAT(_,action) ) ) )
@@ -287,6 +306,7 @@ struct controller_impl {
     */
    template<typename Signal, typename Arg>
    void emit( const Signal& s, Arg&& a ) {
+      replay_profiler::scoped_timer timer( profiler.get(), replay_profiler::events );
       try {
         s(std::forward<Arg>(a));
       } catch (boost::interprocess::bad_alloc& e) {
@@ -328,6 +348,8 @@ struct controller_impl {
 // TODO: removed by CyberWay
 //      db.commit( s->block_num );
       chaindb.commit_revision( s->block_num );
+      // rows which expired before an irreversible block can't be restored by undo anymore
+      dedupe_index.remove_expired( s->header.timestamp.to_time_point() );
 
       if( append_to_blog ) {
          blog.append(s->block);
@@ -375,6 +397,9 @@ struct controller_impl {
       replaying = true;
       replay_head_time = blog_head_time;
       auto start_block_num = head->block_num + 1;
+      EOS_ASSERT( blog.first_block_num() <= start_block_num, block_log_exception,
+                  "block log starts from ${first}, but replay requires block ${s}, start from a snapshot",
+                  ("first", blog.first_block_num())("s", start_block_num) );
       ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
             ("s", start_block_num)("n", blog_head->block_num()) );
 
@@ -384,17 +409,39 @@ struct controller_impl {
          if( skip_session ) {
             set_revision( next->block_num() );
          }
+         if( profiler ) {
+            profiler->start_block( next->block_num(), chaindb.get_cache_map().stats() );
+         }
          replay_push_block( next, controller::block_status::irreversible );
          if( next->block_num() % 500 == 0 ) {
             if( (next->block_num() % 10000) == 0 && skip_session ) {
+               replay_profiler::scoped_timer timer( profiler.get(), replay_profiler::flush );
                chaindb.apply_all_changes();
             }
             ilog( "${n} of ${head}", ("n", next->block_num())("head", blog_head->block_num()) );
             if( shutdown() ) break;
          }
+         if( profiler ) {
+            profiler->end_block( chaindb.get_cache_map().stats() );
+            if( profiler->is_last_block( next->block_num() ) ) break;
+         }
       }
       ilog( "${n} blocks replayed", ("n", head->block_num - start_block_num) );
 
+      if( profiler ) {
+         if( skip_session ) {
+            chaindb.apply_all_changes();
+         }
+         profiler->write_report();
+         if( head->block_num < blog_head->block_num() ) {
+            // the state doesn't match the block log anymore, so the node can't go on
+            wlog( "replay is stopped at block ${n} for profiling, replay the blockchain to use this state",
+                  ("n", head->block_num) );
+            replay_stopped = true;
+            return;
+         }
+      }
+
       // if the irreversible log is played without undo sessions enabled, we need to sync the
       // revision ordinal to the appropriate expected value here.
       if( skip_session ) {
@@ -430,7 +477,8 @@ struct controller_impl {
 
          chaindb.drop_db();
 
-         snapshot_head_block = snapshot_controller(chaindb, resource_limits, fork_db, reversible_blocks, head, conf.genesis).read_snapshot(std::move(snapshot));
+         snapshot_head_block = snapshot_controller(chaindb, resource_limits, fork_db, reversible_blocks, head, conf.genesis, thread_pool).read_snapshot(std::move(snapshot));
+         rebuild_dedupe_index();
 
          auto end = blog.read_head();
          if( !end ) {
@@ -446,6 +494,7 @@ struct controller_impl {
             initialize_fork_db(); // set head to genesis state
             initialized = true;
          }
+         rebuild_dedupe_index();
 
          auto end = blog.read_head();
          if( !end ) {
@@ -458,7 +507,7 @@ struct controller_impl {
 
       chain_id = conf.genesis.compute_chain_id();
 
-      if( shutdown() ) return;
+      if( shutdown() || replay_stopped ) return;
 
       const auto& ubi = reversible_blocks.get_index<reversible_block_index,by_num>();
       auto objitr = ubi.rbegin();
@@ -491,7 +540,11 @@ struct controller_impl {
 
       if( !initialized ) {
          initialize_caches();
+         load_cache_manifest();
       }
+      // undo could both remove and restore rows of the transaction table
+      rebuild_dedupe_index();
+      fork_db.flush();
 
       if( report_integrity_hash ) {
 // TODO: removed by CyberWay
@@ -503,6 +556,13 @@ struct controller_impl {
 
    ~controller_impl() {
       pending.reset();
+      try {
+         // the periodic manifest uses the same file, it mustn't replace the final one
+         if( cache_manifest_future.valid() ) cache_manifest_future.wait();
+         save_cache_manifest();
+      } catch( ... ) {
+         // exceptions mustn't leave the destructor
+      }
 
 // TODO: removed by CyberWay
 //      db.flush();
@@ -535,7 +595,7 @@ struct controller_impl {
       sha256::encoder enc;
       auto hash_writer = std::make_unique<integrity_hash_snapshot_writer>(enc);
 
-      snapshot_controller(chaindb, resource_limits, fork_db, reversible_blocks, head, conf.genesis).write_snapshot(std::move(hash_writer));
+      snapshot_controller(chaindb, resource_limits, fork_db, reversible_blocks, head, conf.genesis, thread_pool).write_snapshot(std::move(hash_writer));
 
       return enc.result();
    }
@@ -581,11 +641,98 @@ struct controller_impl {
        for (auto& value: block_summary_table) {
            // only load to RAM
        }
+   }
+
+   /**
+    * The manifest is the list of keys of the most recently used rows of the chaindb cache.
+    * It is saved periodically and on shutdown, on startup the rows are loaded to the cache before
+    * processing of blocks, so the first blocks after restart don't read the hot set row by row.
+    */
+   static void write_cache_manifest( const fc::path& state_dir, const vector<cyberway::chaindb::cache_hot_key>& keys,
+                                     const char* tmp_suffix ) {
+      // the manifest is only an optimization of startup
+      try {
+         auto data = fc::raw::pack( cache_manifest_version );
+         auto packed_keys = fc::raw::pack( keys );
+         data.insert( data.end(), packed_keys.begin(), packed_keys.end() );
+
+         auto tmp_path = state_dir / (string(config::cache_manifest_filename) + tmp_suffix);
+         {
+            std::ofstream out( tmp_path.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
+            out.write( data.data(), data.size() );
+            out.flush();
+            EOS_ASSERT( out.good(), chain_exception, "unable to write cache manifest" );
+         }
+         fc::rename( tmp_path, state_dir / config::cache_manifest_filename );
+      } catch( const fc::exception& e ) {
+         wlog( "unable to save cache manifest: ${details}", ("details", e.to_detail_string()) );
+      } catch( const std::exception& e ) {
+         wlog( "unable to save cache manifest: ${details}", ("details", e.what()) );
+      }
+   }
+
+   void save_cache_manifest() {
+      if( !conf.cache_manifest_rows ) return;
+
+      write_cache_manifest( conf.state_dir, chaindb.get_cache_map().hot_keys( conf.cache_manifest_rows ), ".tmp" );
+   }
+
+   /// only the keys are collected on the calling thread, the file is written by the thread pool
+   void save_cache_manifest_async() {
+      if( !conf.cache_manifest_rows ) return;
+
+      if( cache_manifest_future.valid() &&
+          cache_manifest_future.wait_for( std::chrono::seconds(0) ) != std::future_status::ready ) {
+         // the previous manifest is still being written
+         return;
+      }
+
+      auto keys = chaindb.get_cache_map().hot_keys( conf.cache_manifest_rows );
+      cache_manifest_future = async_thread_pool( thread_pool, [state_dir = conf.state_dir, keys = std::move( keys )]() {
+         write_cache_manifest( state_dir, keys, ".async.tmp" );
+      });
+   }
+
+   void load_cache_manifest() {
+      const auto path = conf.state_dir / config::cache_manifest_filename;
+      if( !conf.cache_manifest_rows || !fc::exists( path ) ) return;
+
+      try {
+         string content;
+         fc::read_file_contents( path, content );
+
+         fc::datastream<const char*> ds( content.data(), content.size() );
+         uint32_t version = 0;
+         fc::raw::unpack( ds, version );
+         EOS_ASSERT( version == cache_manifest_version, chain_exception,
+                     "unsupported version of cache manifest: ${v}", ("v", version) );
+
+         vector<cyberway::chaindb::cache_hot_key> keys;
+         fc::raw::unpack( ds, keys );
+         if( keys.size() > conf.cache_manifest_rows ) keys.resize( conf.cache_manifest_rows );
+
+         // rows of one table are read in the order of the primary key
+         std::sort( keys.begin(), keys.end(), []( const auto& l, const auto& r ) {
+            return std::tie( l.code, l.table, l.scope, l.pk ) < std::tie( r.code, r.table, r.scope, r.pk );
+         });
+
+         auto start = fc::time_point::now();
+         auto count = chaindb.warm_up_cache( keys );
+         ilog( "warmed up chaindb cache with ${count} of ${n} rows in ${ms} ms",
+               ("count", count)("n", keys.size())("ms", (fc::time_point::now() - start).count() / 1000) );
+      } catch( const fc::exception& e ) {
+         wlog( "unable to load cache manifest: ${details}", ("details", e.to_detail_string()) );
+      }
+   }
 
+   void rebuild_dedupe_index() {
+       dedupe_index.clear();
        auto transaction_table = chaindb.get_table<transaction_object>();
-       for (auto& value: transaction_table) {
-           // only load to RAM
+       for (auto& trx: transaction_table) {
+           dedupe_index.add(trx.trx_id, trx.expiration);
        }
+       // the generated transaction table is changed in the same places, the schedule is rebuilt lazily
+       deferred_scheduler.reset();
    }
 
    void create_native_account( account_name name, const authority& owner, const authority& active, bool is_privileged = false ) {
@@ -686,7 +833,10 @@ struct controller_impl {
       });
 
       try {
-         pending->apply_changes();
+         {
+            replay_profiler::scoped_timer timer( profiler.get(), replay_profiler::flush );
+            pending->apply_changes();
+         }
 
          if (add_to_fork_db) {
             pending->_pending_block_state->validated = true;
@@ -713,6 +863,15 @@ struct controller_impl {
 
       // push the state for pending.
       pending->push();
+      deferred_scheduler.sync();
+
+      if( add_to_fork_db ) {
+         fork_db.flush();
+      }
+
+      if( !replaying && conf.cache_manifest_interval && head->block_num % conf.cache_manifest_interval == 0 ) {
+         save_cache_manifest_async();
+      }
    }
 
    // The returned scoped_exit should not exceed the lifetime of the pending which existed when make_block_restore_point was called.
@@ -796,6 +955,7 @@ struct controller_impl {
 //         -(config::billable_size_v<generated_transaction_object> + gto.packed_trx.size())
 //      );
       // No need to verify_account_ram_usage since we are only reducing memory
+      deferred_scheduler.remove( gto.trx_id );
       chaindb.erase( gto, resource_limits.get_storage_payer(self.pending_block_slot(), account_name()));
    }
 
@@ -897,6 +1057,7 @@ struct controller_impl {
          undo_session = maybe_session(chaindb);
 
       auto gtrx = generated_transaction(gto);
+      auto scheduled = deferred_scheduler.find( gtrx.trx_id );
 
       // remove the generated transaction object after making a copy
       // this will ensure that anything which affects the GTO multi-index-container will not invalidate
@@ -906,14 +1067,19 @@ struct controller_impl {
       // resulting in the GTO being restored and available for a future block to retire.
       remove_scheduled_transaction(gto);
 
-      fc::datastream<const char*> ds( gtrx.packed_trx.data(), gtrx.packed_trx.size() );
-
       EOS_ASSERT( gtrx.delay_until <= self.pending_block_time(), transaction_exception, "this transaction isn't ready",
                  ("gtrx.delay_until",gtrx.delay_until)("pbt",self.pending_block_time())          );
 
-      signed_transaction dtrx;
-      fc::raw::unpack(ds,static_cast<transaction&>(dtrx) );
-      transaction_metadata_ptr trx = std::make_shared<transaction_metadata>( dtrx );
+      transaction_metadata_ptr trx;
+      if( scheduled ) {
+         trx = scheduled->trx;
+      } else {
+         fc::datastream<const char*> ds( gtrx.packed_trx.data(), gtrx.packed_trx.size() );
+         signed_transaction utrx;
+         fc::raw::unpack(ds,static_cast<transaction&>(utrx) );
+         trx = std::make_shared<transaction_metadata>( utrx );
+      }
+      const signed_transaction& dtrx = trx->packed_trx->get_signed_transaction();
       trx->accepted = true;
       trx->scheduled = true;
 
@@ -970,8 +1136,14 @@ struct controller_impl {
          //trx_context.add_net_usage(bandwith_request_result.used_net);
 
          trx_context.init_for_deferred_trx( gtrx.published );
-         trx_context.exec();
+         {
+            replay_profiler::scoped_timer timer( profiler.get(), replay_profiler::execution );
+            trx_context.exec();
+         }
          trx_context.finalize(); // Automatically rounds up network and CPU usage in trace and bills payers if successful
+         if( profiler ) {
+            profiler->add_transaction( *trace );
+         }
          EOS_ASSERT(!trx_context.nested_trx, transaction_exception, "deferred trx can't start nested trx");
 
          auto restore = make_block_restore_point();
@@ -1092,9 +1264,11 @@ struct controller_impl {
       try {
          auto start = fc::time_point::now();
          const bool check_auth = !self.skip_auth_check() && !trx->implicit;
+         replay_profiler::scoped_timer sig_timer( profiler.get(), replay_profiler::signatures );
          // call recover keys so that trx->sig_cpu_usage is set correctly
          const fc::microseconds sig_cpu_usage = check_auth ? std::get<0>( trx->recover_keys( chain_id ) ) : fc::microseconds();
          const flat_set<public_key_type>& recovered_keys = check_auth ? std::get<1>( trx->recover_keys( chain_id ) ) : flat_set<public_key_type>();
+         sig_timer.stop();
          if( !billed.explicit_usage ) {
             fc::microseconds already_consumed_time( EOS_PERCENT(sig_cpu_usage.count(), conf.sig_cpu_bill_pct) );
 
@@ -1136,6 +1310,7 @@ struct controller_impl {
             trx_context.delay = fc::seconds(trn.delay_sec);
 
             if( check_auth ) {
+               replay_profiler::scoped_timer timer( profiler.get(), replay_profiler::authorization );
                authorization.check_authorization(
                        trn.actions,
                        recovered_keys,
@@ -1148,8 +1323,14 @@ struct controller_impl {
 
             auto restore = make_block_restore_point();
 
-            trx_context.exec();
+            {
+               replay_profiler::scoped_timer timer( profiler.get(), replay_profiler::execution );
+               trx_context.exec();
+            }
             trx_context.finalize(); // Automatically rounds up network and CPU usage in trace and bills payers if successful
+            if( profiler ) {
+               profiler->add_transaction( *trace );
+            }
 
             if (!trx->implicit) {
                transaction_receipt::status_enum s = (trx_context.delay == fc::seconds(0))
@@ -1357,6 +1538,30 @@ struct controller_impl {
       static_cast<signed_block_header&>(*p->block) = p->header;
    } /// sign_block
 
+   /**
+    * Loads the rows which are read by each transaction of the validated block: accounts of actions and
+    * authorizers and their resource usage. Rows missed in the cache are requested by one batch per table,
+    * instead of one request per row during execution. Transactions of the block have explicit billing,
+    * so the loaded rows don't change the RAM usage of them.
+    */
+   void prefetch_working_set( const vector<transaction_metadata_ptr>& trxs ) {
+      if( trxs.empty() ) return;
+
+      vector<cyberway::chaindb::primary_key_t> accounts;
+      for( const auto& mtrx: trxs ) {
+         for( const auto& act: mtrx->packed_trx->get_transaction().actions ) {
+            accounts.push_back( act.account.value );
+            for( const auto& auth: act.authorization ) {
+               accounts.push_back( auth.actor.value );
+            }
+         }
+      }
+
+      chaindb.prefetch<account_object>( accounts );
+      chaindb.prefetch<account_sequence_object>( accounts );
+      chaindb.prefetch<resource_limits::resource_usage_object>( std::move(accounts) );
+   }
+
    void apply_block( const signed_block_ptr& b, controller::block_status s ) { try {
       try {
          EOS_ASSERT( b->block_extensions.size() == 0, block_validate_exception, "no supported extensions" );
@@ -1379,6 +1584,7 @@ struct controller_impl {
                maybe_nested_receipts.emplace(id, receipt);
             }
          }
+         prefetch_working_set( packed_transactions );
 
          transaction_trace_ptr trace;
 
@@ -1513,6 +1719,7 @@ struct controller_impl {
             maybe_switch_forks( s );
          }
 
+         fork_db.flush();
       } FC_LOG_AND_RETHROW( )
    }
 
@@ -1767,6 +1974,7 @@ struct controller_impl {
          }
          pending.reset();
       }
+      deferred_scheduler.sync();
    }
 
 
@@ -1979,6 +2187,11 @@ authorization_manager&         controller::get_mutable_authorization_manager()
    return my->authorization;
 }
 
+deferred_transaction_scheduler& controller::get_mutable_deferred_scheduler()
+{
+   return my->deferred_scheduler;
+}
+
 controller::controller( const controller::config& cfg )
 :my( new controller_impl( cfg, *this ) )
 {
@@ -2207,7 +2420,7 @@ sha256 controller::calculate_integrity_hash()const { try {
 
 void controller::write_snapshot(snapshot_writer_ptr snapshot ) {
    EOS_ASSERT( !my->pending, block_validate_exception, "cannot take a consistent snapshot with a pending block" );
-   snapshot_controller(my->chaindb, my->resource_limits, my->fork_db, my->reversible_blocks, my->head, my->conf.genesis).write_snapshot(std::move(snapshot));
+   snapshot_controller(my->chaindb, my->resource_limits, my->fork_db, my->reversible_blocks, my->head, my->conf.genesis, my->thread_pool).write_snapshot(std::move(snapshot));
 }
 
 void controller::pop_block() {
@@ -2447,9 +2660,20 @@ void controller::validate_reversible_available_size() const {
 }
 
 bool controller::is_known_unexpired_transaction( const transaction_id_type& id) const {
+   if( !my->dedupe_index.may_contain(id) ) {
+      return false;
+   }
    return chaindb().find<transaction_object, by_trx_id>(id, cyberway::chaindb::cursor_kind::InRAM);
 }
 
+void controller::add_unexpired_transaction( const transaction_id_type& id, fc::time_point_sec expiration ) {
+   my->chaindb.emplace<transaction_object>([&](transaction_object& transaction) {
+      transaction.trx_id     = id;
+      transaction.expiration = expiration;
+   });
+   my->dedupe_index.add(id, expiration);
+}
+
 void controller::set_subjective_cpu_leeway(fc::microseconds leeway) {
    my->subjective_cpu_leeway = leeway;
 }
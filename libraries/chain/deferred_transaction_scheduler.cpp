@@ -0,0 +1,126 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
+
+#include <cyberway/chaindb/controller.hpp>
+
+namespace eosio { namespace chain {
+
+   using cyberway::chaindb::cursor_kind;
+
+   namespace {
+      transaction_metadata_ptr make_metadata( const transaction& trx ) {
+         signed_transaction dtrx;
+         static_cast<transaction&>(dtrx) = trx;
+         return std::make_shared<transaction_metadata>( dtrx );
+      }
+
+      transaction_metadata_ptr unpack_metadata( const generated_transaction_object& gto ) {
+         fc::datastream<const char*> ds( gto.packed_trx.data(), gto.packed_trx.size() );
+         signed_transaction dtrx;
+         fc::raw::unpack( ds, static_cast<transaction&>(dtrx) );
+         return std::make_shared<transaction_metadata>( dtrx );
+      }
+   }
+
+   deferred_transaction_scheduler::deferred_transaction_scheduler( cyberway::chaindb::chaindb_controller& chaindb )
+   : chaindb( chaindb ) {
+   }
+
+   void deferred_transaction_scheduler::add( const generated_transaction_object& gto, const transaction& trx ) {
+      touched.push_back( gto.trx_id );
+      if( valid ) insert( gto, make_metadata( trx ) );
+   }
+
+   void deferred_transaction_scheduler::remove( const transaction_id_type& trx_id ) {
+      // the row can be restored by undo of the transaction, so the entry is kept until sync()
+      touched.push_back( trx_id );
+   }
+
+   deferred_transaction_scheduler::entry_ptr deferred_transaction_scheduler::find( const transaction_id_type& trx_id ) {
+      if( !valid ) rebuild();
+
+      auto itr = entries.find( trx_id );
+      if( itr == entries.end() ) return entry_ptr();
+      return itr->second;
+   }
+
+   vector<deferred_transaction_scheduler::entry_ptr> deferred_transaction_scheduler::get_ready( time_point time ) {
+      if( !valid ) rebuild();
+
+      vector<entry_ptr> result;
+      for( auto itr = schedule.begin(); itr != schedule.end() && itr->second->delay_until <= time; ++itr ) {
+         result.push_back( itr->second );
+      }
+      return result;
+   }
+
+   bool deferred_transaction_scheduler::is_scheduled( const transaction_id_type& trx_id ) const {
+      return chaindb.find<generated_transaction_object, by_trx_id>( trx_id, cursor_kind::OneRecord ) != nullptr;
+   }
+
+   void deferred_transaction_scheduler::sync() {
+      if( valid ) {
+         for( const auto& trx_id: touched ) {
+            const auto* gto = chaindb.find<generated_transaction_object, by_trx_id>( trx_id, cursor_kind::OneRecord );
+            auto itr = entries.find( trx_id );
+            if( !gto ) {
+               if( itr != entries.end() ) erase( trx_id );
+            } else if( itr == entries.end() ) {
+               insert( *gto, unpack_metadata( *gto ) );
+            } else if( get_key( *itr->second ) != schedule_key( gto->delay_until, gto->id, gto->trx_id ) ||
+                       itr->second->published != gto->published ) {
+               insert( *gto, itr->second->trx );
+            }
+         }
+      }
+      touched.clear();
+   }
+
+   void deferred_transaction_scheduler::reset() {
+      valid = false;
+      schedule.clear();
+      entries.clear();
+   }
+
+   void deferred_transaction_scheduler::rebuild() {
+      // touched rows are kept: the table can contain rows of the pending block, which can be undone later
+      schedule.clear();
+      entries.clear();
+
+      auto trx_table = chaindb.get_table<generated_transaction_object>();
+      for( const auto& gto: trx_table ) {
+         insert( gto, unpack_metadata( gto ) );
+      }
+      valid = true;
+   }
+
+   void deferred_transaction_scheduler::insert( const generated_transaction_object& gto, transaction_metadata_ptr trx ) {
+      auto e = std::make_shared<entry>();
+      e->id          = gto.id;
+      e->trx_id      = gto.trx_id;
+      e->delay_until = gto.delay_until;
+      e->published   = gto.published;
+      e->trx         = std::move(trx);
+
+      auto itr = entries.find( e->trx_id );
+      if( itr != entries.end() ) {
+         schedule.erase( get_key( *itr->second ) );
+         itr->second = e;
+      } else {
+         entries.emplace( e->trx_id, e );
+      }
+      schedule.emplace( get_key( *e ), std::move(e) );
+   }
+
+   void deferred_transaction_scheduler::erase( const transaction_id_type& trx_id ) {
+      auto itr = entries.find( trx_id );
+      if( itr == entries.end() ) return;
+
+      schedule.erase( get_key( *itr->second ) );
+      entries.erase( itr );
+   }
+
+} } /// namespace eosio::chain
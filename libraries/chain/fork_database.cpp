@@ -8,6 +8,9 @@
 #include <boost/multi_index/composite_key.hpp>
 #include <fc/io/fstream.hpp>
 #include <fstream>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace eosio { namespace chain {
    using boost::multi_index_container;
@@ -42,12 +45,217 @@ namespace eosio { namespace chain {
    > fork_multi_index_type;
 
 
+   /**
+    * The log consists of the version followed by records: the type, the size and the packed payload.
+    * flush() closes each group of records with the head record, a group without it is the tail of
+    * an interrupted write and is dropped on load.
+    */
+   enum class fork_db_record : uint8_t {
+      add,     ///< block_state
+      remove,  ///< block_id_type
+      flags,   ///< fork_db_block_flags
+      confirm, ///< header_confirmation
+      head     ///< block_id_type
+   };
+
+   struct fork_db_block_flags {
+      block_id_type id;
+      bool          validated = false;
+      bool          in_current_chain = false;
+      uint32_t      bft_irreversible_blocknum = 0;
+   };
+
+} } /// eosio::chain
+
+FC_REFLECT( eosio::chain::fork_db_block_flags, (id)(validated)(in_current_chain)(bft_irreversible_blocknum) )
+
+namespace eosio { namespace chain {
+
+   namespace {
+      constexpr uint32_t forkdb_log_version = 1;
+      constexpr size_t   record_header_size = sizeof(uint8_t) + sizeof(uint32_t);
+      /// if more unflushed changes are collected (e.g. on replay), the log is compacted on the next flush
+      constexpr size_t   max_unflushed_size = 64*1024*1024;
+      /// the log is compacted when it exceeds this size plus twice the size of the last compacted log
+      constexpr uint64_t min_compaction_size = 64*1024*1024;
+
+      template<typename T>
+      void pack_record( vector<char>& records, fork_db_record type, const T& payload ) {
+         const auto size = fc::raw::pack_size( payload );
+         const auto pos = records.size();
+         records.resize( pos + record_header_size + size );
+
+         fc::datastream<char*> ds( records.data() + pos, records.size() - pos );
+         fc::raw::pack( ds, static_cast<uint8_t>(type) );
+         fc::raw::pack( ds, static_cast<uint32_t>(size) );
+         fc::raw::pack( ds, payload );
+      }
+
+      /// writes the file and flushes it to the disk, so it can replace the log by rename
+      void write_synced( const fc::path& path, const vector<char>& data ) {
+         const auto fd = ::open( path.generic_string().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+         EOS_ASSERT( fd >= 0, fork_database_exception, "unable to open ${p}", ("p", path) );
+
+         bool good = true;
+         for( size_t pos = 0; good && pos < data.size(); ) {
+            const auto n = ::write( fd, data.data() + pos, data.size() - pos );
+            good = n > 0 || (n < 0 && errno == EINTR);
+            if( n > 0 ) pos += n;
+         }
+         good = good && ::fsync( fd ) == 0;
+         ::close( fd );
+         EOS_ASSERT( good, fork_database_exception, "unable to write ${p}", ("p", path) );
+      }
+
    struct fork_database_impl {
       fork_multi_index_type index;
       block_state_ptr       head;
       fc::path              datadir;
+
+      std::ofstream         log;
+      uint64_t              log_size = 0;
+      uint64_t              compacted_size = 0;
+      vector<char>          unflushed;
+      bool                  needs_compaction = false;
+      bool                  closed = false;
+      block_id_type         flushed_head;
+
+      fc::path log_path()const {
+         return datadir / config::forkdb_log_filename;
+      }
+
+      template<typename T>
+      void append( fork_db_record type, const T& payload ) {
+         if( needs_compaction ) return;
+
+         pack_record( unflushed, type, payload );
+         if( unflushed.size() > max_unflushed_size ) {
+            unflushed.clear();
+            needs_compaction = true;
+         }
+      }
+
+      void append_flags( const block_state& s ) {
+         append( fork_db_record::flags, fork_db_block_flags{s.id, s.validated, s.in_current_chain, s.bft_irreversible_blocknum} );
+      }
+
+      void load_log();
+      void apply_record( fork_db_record type, fc::datastream<const char*>& ds );
+      void compact();
    };
 
+   void fork_database_impl::load_log() {
+      string content;
+      fc::read_file_contents( log_path(), content );
+
+      fc::datastream<const char*> ds( content.data(), content.size() );
+      uint32_t version = 0;
+      fc::raw::unpack( ds, version );
+      EOS_ASSERT( version == forkdb_log_version, fork_database_exception,
+                  "unsupported version of fork database log: ${v}", ("v", version) );
+
+      vector<std::pair<fork_db_record, fc::datastream<const char*>>> group;
+      while( ds.remaining() >= record_header_size ) {
+         uint8_t  type = 0;
+         uint32_t size = 0;
+         fc::raw::unpack( ds, type );
+         fc::raw::unpack( ds, size );
+         if( ds.remaining() < size ) break;
+
+         group.emplace_back( static_cast<fork_db_record>(type), fc::datastream<const char*>( ds.pos(), size ) );
+         ds.skip( size );
+
+         if( static_cast<fork_db_record>(type) == fork_db_record::head ) {
+            for( auto& r: group ) {
+               apply_record( r.first, r.second );
+            }
+            group.clear();
+         }
+      }
+
+      if( !group.empty() ) {
+         wlog( "dropped ${n} records of interrupted write to fork database log", ("n", group.size()) );
+      }
+   }
+
+   void fork_database_impl::apply_record( fork_db_record type, fc::datastream<const char*>& ds ) {
+      switch( type ) {
+         case fork_db_record::add: {
+            auto s = std::make_shared<block_state>();
+            fc::raw::unpack( ds, *s );
+            auto itr = index.find( s->id );
+            if( itr != index.end() ) {
+               index.replace( itr, s );
+            } else {
+               index.insert( s );
+            }
+            break;
+         }
+         case fork_db_record::remove: {
+            block_id_type id;
+            fc::raw::unpack( ds, id );
+            index.erase( id );
+            break;
+         }
+         case fork_db_record::flags: {
+            fork_db_block_flags f;
+            fc::raw::unpack( ds, f );
+            auto itr = index.find( f.id );
+            if( itr != index.end() ) {
+               index.modify( itr, [&]( auto& bsp ) {
+                  bsp->validated = f.validated;
+                  bsp->in_current_chain = f.in_current_chain;
+                  bsp->bft_irreversible_blocknum = f.bft_irreversible_blocknum;
+               });
+            }
+            break;
+         }
+         case fork_db_record::confirm: {
+            header_confirmation c;
+            fc::raw::unpack( ds, c );
+            auto itr = index.find( c.block_id );
+            if( itr != index.end() ) {
+               (*itr)->add_confirmation( c );
+            }
+            break;
+         }
+         case fork_db_record::head: {
+            block_id_type id;
+            fc::raw::unpack( ds, id );
+            auto itr = index.find( id );
+            head = itr != index.end() ? *itr : block_state_ptr();
+            flushed_head = id;
+            break;
+         }
+         default:
+            EOS_THROW( fork_database_exception, "unknown record type ${t} in fork database log", ("t", static_cast<uint32_t>(type)) );
+      }
+   }
+
+   /// rewrites the log with the current content of the fork database
+   void fork_database_impl::compact() {
+      vector<char> records;
+      records.resize( sizeof(forkdb_log_version) );
+      memcpy( records.data(), &forkdb_log_version, sizeof(forkdb_log_version) );
+
+      for( const auto& s: index ) {
+         pack_record( records, fork_db_record::add, *s );
+      }
+      flushed_head = head ? head->id : block_id_type();
+      pack_record( records, fork_db_record::head, flushed_head );
+
+      if( log.is_open() ) log.close();
+
+      auto tmp_path = datadir / (string(config::forkdb_log_filename) + ".tmp");
+      write_synced( tmp_path, records );
+      fc::rename( tmp_path, log_path() );
+
+      log.open( log_path().generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+      log_size = compacted_size = records.size();
+      unflushed.clear();
+      needs_compaction = false;
+   }
+
 
    fork_database::fork_database( const fc::path& data_dir ):my( new fork_database_impl() ) {
       my->datadir = data_dir;
@@ -55,6 +263,7 @@ namespace eosio { namespace chain {
       if (!fc::is_directory(my->datadir))
          fc::create_directories(my->datadir);
 
+      // forkdb.dat is written by the previous versions on shutdown
       auto fork_db_dat = my->datadir / config::forkdb_filename;
       if( fc::exists( fork_db_dat ) ) {
          string content;
@@ -73,23 +282,56 @@ namespace eosio { namespace chain {
          my->head = get_block( head_id );
 
          fc::remove( fork_db_dat );
+      } else if( fc::exists( my->log_path() ) ) {
+         my->load_log();
+      }
+
+      // starts the log from the loaded content, this also drops the tail of an interrupted write,
+      // without content the log is created by the first flush which has something to write
+      if( my->index.size() ) {
+         my->compact();
       }
    }
 
+   void fork_database::flush() {
+      if( my->closed ) return;
+
+      if( !my->log.is_open() ) {
+         if( !my->index.size() ) {
+            my->unflushed.clear();
+            return;
+         }
+         my->compact();
+         return;
+      }
+
+      if( my->needs_compaction || my->log_size > 2 * my->compacted_size + min_compaction_size ) {
+         my->compact();
+         return;
+      }
+
+      auto head_id = my->head ? my->head->id : block_id_type();
+      if( my->unflushed.empty() && head_id == my->flushed_head ) return;
+
+      pack_record( my->unflushed, fork_db_record::head, head_id );
+      my->log.write( my->unflushed.data(), my->unflushed.size() );
+      my->log.flush();
+      EOS_ASSERT( my->log.good(), fork_database_exception, "unable to write fork database log" );
+
+      my->log_size += my->unflushed.size();
+      my->flushed_head = head_id;
+      my->unflushed.clear();
+   }
+
    void fork_database::close() {
-      if( my->index.size() == 0 ) return;
+      if( my->closed ) return;
+      my->closed = true;
 
-      auto fork_db_dat = my->datadir / config::forkdb_filename;
-      std::ofstream out( fork_db_dat.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
-      uint32_t num_blocks_in_fork_db = my->index.size();
-      fc::raw::pack( out, unsigned_int{num_blocks_in_fork_db} );
-      for( const auto& s : my->index ) {
-         fc::raw::pack( out, *s );
+      if( my->log.is_open() || my->index.size() ) {
+         my->compact();
+         my->log.close();
       }
-      if( my->head )
-         fc::raw::pack( out, my->head->id );
-      else
-         fc::raw::pack( out, block_id_type() );
+      if( my->index.size() == 0 ) return;
 
       /// we don't normally indicate the head block as irreversible
       /// we cannot normally prune the lib if it is the head block because
@@ -116,6 +358,7 @@ namespace eosio { namespace chain {
          //FC_ASSERT( s->block_num == s->header.block_num() );
 
       EOS_ASSERT( result.second, fork_database_exception, "unable to insert block state, duplicate state detected" );
+      my->append( fork_db_record::add, *s );
       if( !my->head ) {
          my->head =  s;
       } else if( my->head->block_num < s->block_num ) {
@@ -135,6 +378,7 @@ namespace eosio { namespace chain {
 
       auto inserted = my->index.insert(n);
       EOS_ASSERT( inserted.second, fork_database_exception, "duplicate block added?" );
+      my->append( fork_db_record::add, *n );
 
       my->head = *my->index.get<by_lib_block_num>().begin();
 
@@ -219,8 +463,10 @@ namespace eosio { namespace chain {
 
       for( uint32_t i = 0; i < remove_queue.size(); ++i ) {
          auto itr = my->index.find( remove_queue[i] );
-         if( itr != my->index.end() )
+         if( itr != my->index.end() ) {
             my->index.erase(itr);
+            my->append( fork_db_record::remove, remove_queue[i] );
+         }
 
          auto& previdx = my->index.get<by_prev>();
          auto  previtr = previdx.lower_bound(remove_queue[i]);
@@ -239,6 +485,7 @@ namespace eosio { namespace chain {
       } else {
          /// remove older than irreversible and mark block as valid
          h->validated = true;
+         my->append_flags( *h );
       }
    }
 
@@ -253,6 +500,7 @@ namespace eosio { namespace chain {
       by_id_idx.modify( itr, [&]( auto& bsp ) { // Need to modify this way rather than directly so that Boost MultiIndex can re-sort
          bsp->in_current_chain = in_current_chain;
       });
+      my->append_flags( **itr );
    }
 
    void fork_database::prune( const block_state_ptr& h ) {
@@ -269,6 +517,7 @@ namespace eosio { namespace chain {
       if( itr != my->index.end() ) {
          irreversible(*itr);
          my->index.erase(itr);
+         my->append( fork_db_record::remove, h->id );
       }
 
       auto& numidx = my->index.get<by_block_num>();
@@ -305,6 +554,7 @@ namespace eosio { namespace chain {
       auto b = get_block( c.block_id );
       EOS_ASSERT( b, fork_db_block_not_found, "unable to find block id ${id}", ("id",c.block_id));
       b->add_confirmation( c );
+      my->append( fork_db_record::confirm, c );
 
       if( b->bft_irreversible_blocknum < b->block_num &&
          b->confirmations.size() >= ((b->active_schedule.producers.size() * 2) / 3 + 1) ) {
@@ -326,6 +576,7 @@ namespace eosio { namespace chain {
       idx.modify( itr, [&]( auto& bsp ) {
            bsp->bft_irreversible_blocknum = bsp->block_num;
       });
+      my->append_flags( **itr );
 
       /** to prevent stack-overflow, we perform a bredth-first traversal of the
        * fork database. At each stage we iterate over the leafs from the prior stage
@@ -345,6 +596,7 @@ namespace eosio { namespace chain {
                  if( bsp->bft_irreversible_blocknum < block_num ) {
                     bsp->bft_irreversible_blocknum = block_num;
                     updated.push_back( bsp->id );
+                    my->append_flags( *bsp );
                  }
                });
                ++pitr;
@@ -22,6 +22,9 @@ namespace cyberway { namespace chaindb {
         abi_info() = default;
         abi_info(const account_name& code, abi_def);
         abi_info(const account_name& code, blob);
+        // index descriptors point to the tables of the object, so a copy rebuilds them
+        abi_info(const abi_info&);
+        abi_info& operator=(const abi_info&) = delete;
 
         void verify_tables_structure(const driver_interface&) const;
 
@@ -53,8 +56,9 @@ namespace cyberway { namespace chaindb {
         }
 
         const index_def* find_index(const table_def& table, const index_name_t index) const {
-            for (auto& idx: table.indexes) if (index == idx.name.value) {
-                return &idx;
+            auto itr = index_map_.find(std::make_pair(table.name.value, index));
+            if (index_map_.end() != itr) {
+                return itr->second.index;
             }
             return nullptr;
         }
@@ -92,12 +96,21 @@ namespace cyberway { namespace chaindb {
         }; // constants
 
     private:
+        // resolved index of the table, the abi is immutable, so descriptors live as long as the abi_info
+        struct index_descriptor final {
+            const index_def* index = nullptr;
+            string           type;  // name of the struct generated for the index in the serializer
+        }; // struct index_descriptor
+
         const account_name code_;
         abi_serializer serializer_;
         fc::flat_map<table_name_t, table_def> table_map_;
+        fc::flat_map<std::pair<table_name_t, index_name_t>, index_descriptor> index_map_;
         static const fc::microseconds max_abi_time_;
 
         void init(abi_def);
+        void init_index_map();
+        const string& get_index_type(const index_info&) const;
 
         template<typename Type> variant to_object_(abi_serializer::mode, const char*, Type&&, const string&, const void*, size_t) const;
         template<typename Type> bytes to_bytes_(const char*, Type&&, const string&, const variant&) const;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <list>
+#include <map>
+
+#include <fc/crypto/sha256.hpp>
+
+#include <cyberway/chaindb/abi_info.hpp>
+
+namespace cyberway { namespace chaindb {
+
+    /**
+     * Process-wide storage of parsed ABIs.
+     *
+     * A parsed abi_info is keyed by the contract account and the hash of its serialized ABI,
+     * so it outlives the eviction of account_object from cache_map and each ABI is parsed once.
+     * The registry is filled lazily on the first access to a contract. It holds its own references,
+     * and when the total size of the serialized ABIs exceeds the limit the least recently used
+     * entries are released. An ABI larger than the limit isn't kept.
+     *
+     * abi_info is reference counted without synchronization, so the registry
+     * should be used only from the chain thread.
+     */
+    class abi_registry final {
+    public:
+        static abi_registry& instance();
+
+        abi_info_ptr get(const account_name& code, const bytes& abi);
+
+        void set_max_size(size_t size);
+        size_t max_size() const { return max_size_; }
+        size_t size() const { return entries_.size(); }
+        size_t used_size() const { return used_size_; }
+
+        void clear();
+
+    private:
+        abi_registry() = default;
+
+        using key_type = std::pair<account_name_t, fc::sha256>;
+
+        struct entry final {
+            abi_info_ptr info;
+            size_t       size;
+            std::list<key_type>::iterator lru;
+        }; // struct entry
+
+        abi_info_ptr find(const key_type&);
+        abi_info_ptr insert(key_type, const account_name& code, abi_def, size_t size);
+        void release_lru();
+
+        std::map<key_type, entry> entries_;
+        std::list<key_type>       lru_;
+        size_t                    used_size_ = 0;
+        size_t                    max_size_  = 16 * 1024 * 1024;
+    }; // class abi_registry
+
+} } // namespace cyberway::chaindb
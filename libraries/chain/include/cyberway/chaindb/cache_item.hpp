@@ -141,13 +141,17 @@ namespace cyberway { namespace chaindb {
         }
 
     private:
+        // the row is still kept as the variant, plus the contract blob or the converted struct,
+        //   the RAM usage of the object is charged by the stored row size, not by this footprint
         cache_object_state* state_ = nullptr;
         object_value        object_;
         bytes               blob_;  // for contracts tables
         cache_data_ptr      data_;  // for interchain tables
+        bytes               index_keys_; // keys of unique secondary indexes, shared by values of the index tree
         stage_kind          stage_ = Released;
 
         friend class  cache_map_impl;
+        friend struct cache_index_value;
         friend struct lru_cache_cell;
         friend struct lru_cache_object_state;
         friend struct system_cache_cell;
@@ -1,10 +1,51 @@
 #pragma once
 
+#include <map>
+#include <vector>
+
 #include <cyberway/chaindb/cache_item.hpp>
 #include <cyberway/chaindb/storage_payer_info.hpp>
 
 namespace cyberway { namespace chaindb {
 
+    struct cache_stats final {
+        uint64_t hits   = 0; // lookups answered by the cache (including the cache of missing objects)
+        uint64_t misses = 0; // lookups passed to the driver
+    }; // struct cache_stats
+
+    // Budgets of the LRU cache by classes of tables, 0 means that only the common RAM limit is applied.
+    // The rows of a class over its budget are evicted in the LRU order,
+    //   so a growing contract can't evict the state which is required by all transactions.
+    // Budgets are subjective: the billed RAM bytes and the eviction by the common limit don't depend on them.
+    struct cache_budget_config final {
+        uint64_t system_size   = 0; // tables of the system contract except stake and resource tables
+        uint64_t stake_size    = 0; // stake and resource tables
+        uint64_t contract_size = 0; // default budget of each contract
+        std::map<account_name_t, uint64_t> contract_sizes; // budgets of designated contracts
+    }; // struct cache_budget_config
+
+    struct cache_budget_usage final {
+        string         budget;   // system, stake or contract
+        account_name_t code = 0; // for budgets of contracts
+        uint64_t       limit = 0;
+        uint64_t       used  = 0;
+        uint64_t       evicted_rows = 0;
+    }; // struct cache_budget_usage
+
+    struct cache_usage final {
+        uint64_t limit = 0; // common RAM limit of the cache
+        uint64_t used  = 0;
+        std::vector<cache_budget_usage> budgets; // contracts are ordered by code
+    }; // struct cache_usage
+
+    // Key of a row in the manifest of the hot set, which is used to warm up the cache on startup
+    struct cache_hot_key final {
+        account_name_t code  = 0;
+        scope_name_t   scope = 0;
+        table_name_t   table = 0;
+        primary_key_t  pk    = primary_key::Unset;
+    }; // struct cache_hot_key
+
     class cache_map final {
     public:
         cache_map();
@@ -39,6 +80,7 @@ namespace cyberway { namespace chaindb {
         void set_service(const table_info&, cache_object&, service_state) const;
         void set_revision(const object_value&, revision_t) const;
         void set_subjective_ram(uint64_t size, uint64_t reserved_size, uint32_t rlm) const;
+        void set_budgets(cache_budget_config) const;
 
         uint64_t calc_ram_bytes(revision_t) const;
         void set_revision(revision_t) const;
@@ -50,8 +92,24 @@ namespace cyberway { namespace chaindb {
         void clear() const;
         void push(revision_t) const;
 
+        const cache_stats& stats() const;
+        // find() doesn't change stats(), the caller counts each lookup once,
+        //   even if it asks both the cache of objects and the cache of missing objects
+        void count_lookup(bool hit) const;
+        cache_usage usage() const;
+
+        // keys of cached rows from the most recently used ones
+        std::vector<cache_hot_key> hot_keys(size_t max_count) const;
+
+        // rows emplaced between start_warm_up() and push_warm_up() are committed to LRU
+        //   without a revision, start_warm_up() fails if there are pending caches
+        bool start_warm_up() const;
+        void push_warm_up() const;
+
     private:
         std::unique_ptr<cache_map_impl> impl_;
     }; // class cache_map
 
 } } // namespace cyberway::chaindb
+
+FC_REFLECT(cyberway::chaindb::cache_hot_key, (code)(scope)(table)(pk))
@@ -16,6 +16,7 @@ namespace cyberway { namespace chaindb {
     template<class> struct object_to_table;
     struct chaindb_controller_impl;
     struct abi_info;
+    struct cache_hot_key;
 
     enum class cursor_kind {
         ManyRecords,
@@ -128,10 +129,26 @@ namespace cyberway { namespace chaindb {
         void drop_db() const;
         void push_cache() const;
 
+        // loads the rows which are missed in the cache by batch requests to the driver,
+        //   returns the number of loaded rows
+        size_t prefetch(const table_request&, std::vector<primary_key_t>) const;
+
+        template<typename Object>
+        size_t prefetch(std::vector<primary_key_t> pks) const {
+            return prefetch(object_to_table<Object>::type::get_table_request(), std::move(pks));
+        }
+
+        // loads the rows of the hot set to the cache, returns the number of loaded rows
+        size_t warm_up_cache(const std::vector<cache_hot_key>&) const;
+
         // https://github.com/cyberway/cyberway/issues/1094
         void enable_rev_bad_update() const;
         void disable_rev_bad_update() const;
 
+        // postpone creating indexes of contract tables while they are bulk loaded
+        void enable_deferred_indexes() const;
+        void disable_deferred_indexes() const;
+
         void close(const cursor_request&) const;
         void close_code_cursors(const account_name&) const;
 
@@ -5,8 +5,13 @@
 
 #include <fc/variant.hpp>
 
+#include <set>
+
 namespace cyberway { namespace chaindb {
 
+    // tables as pairs of code and table name
+    using resident_table_set = std::set<std::pair<account_name_t, table_name_t>>;
+
     struct cursor_info {
         cursor_t      id = invalid_cursor;
         index_info    index;
@@ -24,6 +29,13 @@ namespace cyberway { namespace chaindb {
         virtual void enable_undo_restore() const = 0;
         virtual void disable_undo_restore() const = 0;
 
+        // rows of the tables are kept in RAM, so reading of them doesn't touch the database
+        virtual void set_resident_tables(resident_table_set) const = 0;
+
+        // indexes of contract tables are collected and created on disabling, used for bulk loading
+        virtual void enable_deferred_indexes() const = 0;
+        virtual void disable_deferred_indexes() const = 0;
+
         virtual void drop_db() const = 0;
 
         virtual std::vector<table_def> db_tables(const account_name& code) const = 0;
@@ -54,6 +66,8 @@ namespace cyberway { namespace chaindb {
         virtual cursor_info& prev(const cursor_info&) const = 0;
 
         virtual       object_value  object_by_pk(const table_info&, primary_key_t) const = 0;
+        // found objects in any order, they are requested by batches of keys; missing objects are skipped
+        virtual std::vector<object_value> objects_by_pk(const table_info&, const std::vector<primary_key_t>&) const = 0;
         virtual const object_value& object_at_cursor(const cursor_info&, bool with_decors) const = 0;
 
         virtual primary_key_t available_pk(const table_info&) const = 0;
@@ -23,6 +23,11 @@ namespace cyberway { namespace chaindb {
         void enable_undo_restore() const override;
         void disable_undo_restore() const override;
 
+        void set_resident_tables(resident_table_set) const override;
+
+        void enable_deferred_indexes() const override;
+        void disable_deferred_indexes() const override;
+
         std::vector<table_def> db_tables(const account_name& code) const override;
         void create_index(const index_info&) const override;
         void drop_index(const index_info&) const override;
@@ -53,6 +58,7 @@ namespace cyberway { namespace chaindb {
         cursor_info& prev(const cursor_info&) const override;
 
               object_value  object_by_pk(const table_info&, primary_key_t) const override;
+        std::vector<object_value> objects_by_pk(const table_info&, const std::vector<primary_key_t>&) const override;
         const object_value& object_at_cursor(const cursor_info&, bool) const override;
 
         primary_key_t available_pk(const table_info&) const override;
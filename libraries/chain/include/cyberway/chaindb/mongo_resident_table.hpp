@@ -0,0 +1,160 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <bsoncxx/document/element.hpp>
+#include <bsoncxx/document/value.hpp>
+#include <bsoncxx/document/view.hpp>
+
+#include <cyberway/chaindb/common.hpp>
+
+namespace cyberway { namespace chaindb {
+
+    // compares values in the same way as MongoDB does in indexes, the missing value is equal to null
+    int compare_bson_values(const bsoncxx::document::element&, const bsoncxx::document::element&);
+
+    /**
+     * Full copy of a MongoDB collection in RAM.
+     *
+     * Rows are kept as BSON documents in the same form as in the collection, keys of indexes refer to the fields
+     * of the rows. An index is built on the first request with the key pattern of the MongoDB index, so cursors
+     * over it return rows in the same order and with the same bounds (min() is inclusive, max() is exclusive)
+     * as cursors of MongoDB.
+     *
+     * The driver writes changes to the collection and after that applies them to the resident table.
+     */
+    class mongo_resident_table final {
+    public:
+        using row_ptr  = std::shared_ptr<const bsoncxx::document::value>;
+        using row_key  = std::pair<scope_name_t, primary_key_t>;
+        using key_type = std::vector<bsoncxx::document::element>;
+
+        struct key_field final {
+            string path; // dot-separated path of the field in the row
+            int    order = 1;
+
+            bool operator<(const key_field& other) const {
+                return path < other.path || (path == other.path && order < other.order);
+            }
+        }; // struct key_field
+
+        using key_pattern = std::vector<key_field>;
+
+        struct entry final {
+            key_type key;
+            row_key  id;  // keys of non-unique indexes are equal for different rows
+            row_ptr  row; // holds the fields of the key
+        }; // struct entry
+
+        struct key_compare final {
+            const key_pattern* pattern;
+
+            int compare(const key_type&, const key_type&) const;
+
+            bool operator()(const entry& l, const entry& r) const {
+                auto res = compare(l.key, r.key);
+                return res < 0 || (0 == res && l.id < r.id);
+            }
+
+            bool operator()(const entry& l, const key_type& r) const {
+                return compare(l.key, r) < 0;
+            }
+
+            bool operator()(const key_type& l, const entry& r) const {
+                return compare(l, r.key) < 0;
+            }
+
+            using is_transparent = void;
+        }; // struct key_compare
+
+        struct index final {
+            using tree_type = std::set<entry, key_compare>;
+
+            explicit index(key_pattern src)
+            : pattern(std::move(src)),
+              tree(key_compare{&pattern}) {
+            }
+
+            index(const index&) = delete;
+
+            const key_pattern pattern;
+            tree_type tree;
+        }; // struct index
+
+        class cursor final {
+        public:
+            bool is_end() const {
+                return is_end_;
+            }
+
+            bsoncxx::document::view current() const {
+                return current_.row->view();
+            }
+
+            void next();
+
+        private:
+            friend class mongo_resident_table;
+
+            cursor(std::shared_ptr<const mongo_resident_table>, const index&, bool forward, const key_type& bound);
+
+            void set_position(index::tree_type::const_iterator);
+
+            std::shared_ptr<const mongo_resident_table> table_;
+            const index& index_;
+            const bool   forward_;
+
+            uint64_t version_ = 0;
+            bool     is_end_  = true;
+            index::tree_type::const_iterator itr_;
+            entry    current_; // the row is kept even if it is removed from the table
+        }; // class cursor
+
+        mongo_resident_table(account_name_t code, table_name_t table);
+
+        mongo_resident_table(const mongo_resident_table&) = delete;
+
+        account_name_t code() const {
+            return code_;
+        }
+
+        table_name_t table() const {
+            return table_;
+        }
+
+        size_t size() const {
+            return rows_.size();
+        }
+
+        row_ptr find(scope_name_t scope, primary_key_t pk) const;
+
+        // last row in the order of the pattern or an empty pointer for the empty table
+        row_ptr last(const key_pattern&) const;
+
+        // cursor starts from the first key >= bound (forward) or from the last key < bound (backward)
+        static cursor open(
+            std::shared_ptr<const mongo_resident_table>, const key_pattern&, bool forward,
+            const bsoncxx::document::view& bound);
+
+        void insert(scope_name_t scope, primary_key_t pk, bsoncxx::document::value row);
+        bool erase(scope_name_t scope, primary_key_t pk);
+
+    private:
+        const index& get_index(const key_pattern&) const;
+        entry make_entry(const key_pattern&, const row_key&, const row_ptr&) const;
+
+        const account_name_t code_;
+        const table_name_t   table_;
+
+        uint64_t version_ = 0; // cursors locate their positions again after changes of the table
+        std::map<row_key, row_ptr> rows_;
+        mutable std::map<key_pattern, std::unique_ptr<index>> indexes_;
+    }; // class mongo_resident_table
+
+    using mongo_resident_table_ptr = std::shared_ptr<mongo_resident_table>;
+
+} } // namespace cyberway::chaindb
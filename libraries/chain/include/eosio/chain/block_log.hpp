@@ -9,7 +9,18 @@
 
 namespace eosio { namespace chain {
 
-   namespace detail { class block_log_impl; }
+   namespace detail {
+      class block_log_impl;
+      class block_log_archive;
+   }
+
+   struct block_log_config {
+      uint32_t segment_size     = 0;     ///< number of blocks in a closed segment of block log, 0 - one file for all blocks
+      bool     compression      = false; ///< compress closed segments in background
+      uint32_t blocks_per_chunk = 64;    ///< number of blocks in an independently compressed chunk
+      uint32_t retained_blocks  = 0;     ///< closed segments older than this number of blocks are removed, 0 - keep all
+      fc::path archive_dir;              ///< closed segments are moved to this directory if it isn't empty
+   };
 
    /* The block log is an external append only log of the blocks with a header. Blocks should only
     * be written to the log after they irreverisble as the log is append only. The log is a doubly
@@ -34,15 +45,29 @@ namespace eosio { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * If the segment size is configured, the main file is closed after each segment_size blocks and is renamed to
+    * blocks-<first_block_num>.log (with its index). The new main file starts from the next block number.
+    * Closed segments can be compressed in background into blocks-<first_block_num>.zlog, which consists of
+    * independently compressed chunks of blocks and has own index of chunk positions for O(1) random access.
+    * Blocks are read from the segment which contains them, so the formats can be mixed in one directory.
+    *
+    * Closed segments can be moved to the secondary (archive) directory, and the segments which contain only blocks
+    * older than the configured number of retained blocks are removed. In this case the block log starts from
+    * the first block of the oldest remaining segment.
     */
 
    class block_log {
       public:
-         block_log(const fc::path& data_dir);
+         block_log(const fc::path& data_dir, const block_log_config& config = block_log_config());
          block_log(block_log&& other);
          ~block_log();
 
          uint64_t append(const signed_block_ptr& b);
+
+         /**
+          * Waits for the background compression of closed segments.
+          */
          void flush();
          void reset( const genesis_state& gs, const signed_block_ptr& genesis_block, uint32_t first_block_num = 1 );
 
@@ -58,7 +83,7 @@ namespace eosio { namespace chain {
          uint64_t get_block_pos(uint32_t block_num) const;
          signed_block_ptr        read_head()const;
          const signed_block_ptr& head()const;
-         uint32_t                first_block_num() const {return 1;}
+         uint32_t                first_block_num() const;
 
          static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
@@ -69,8 +94,12 @@ namespace eosio { namespace chain {
 
       private:
          void open(const fc::path& data_dir);
+         void rotate();
 
-         std::unique_ptr<detail::block_log_impl> my;
+         std::unique_ptr<detail::block_log_impl>    my;
+         std::unique_ptr<detail::block_log_archive> archive;
+         block_log_config                           config;
+         fc::path                                   data_dir;
    };
 
 } }
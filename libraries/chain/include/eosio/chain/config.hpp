@@ -33,10 +33,14 @@ const static auto default_reversible_guard_size = 2*_MB;/// 1MB * 340 blocks bas
 
 const static auto default_state_dir_name     = "state";
 const static auto forkdb_filename            = "forkdb.dat";
+const static auto forkdb_log_filename        = "forkdb.log";
+const static auto cache_manifest_filename    = "cache-manifest.bin";
 const static auto default_state_size            = _GB;
 const static auto default_state_guard_size      =    128*_MB;
 const static uint64_t default_ram_size          = 8*_GB;
 const static uint64_t default_reserved_ram_size = 512*_MB;
+const static uint32_t default_cache_manifest_rows     = 100000;
+const static uint32_t default_cache_manifest_interval = 1200; ///< blocks between saves of the cache manifest
 const static uint64_t min_resource_usage_pct = percent_1 / 10;
 
 const static uint64_t system_account_name    = N(cyber);
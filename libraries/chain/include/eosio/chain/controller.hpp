@@ -2,6 +2,7 @@
 #include <eosio/chain/block_state.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain/genesis_state.hpp>
+#include <eosio/chain/block_log.hpp>
 #include <boost/signals2/signal.hpp>
 
 #include <eosio/chain/abi_serializer.hpp>
@@ -31,6 +32,7 @@ namespace eosio { namespace chain {
    using cyberway::chain::username_object;
 
    class authorization_manager;
+   class deferred_transaction_scheduler;
 
    namespace resource_limits {
       class resource_limits_manager;
@@ -137,6 +139,7 @@ namespace eosio { namespace chain {
 
          struct config {
             path                     blocks_dir             =  chain::config::default_blocks_dir_name;
+            block_log_config         blocks_log;
             path                     state_dir              =  chain::config::default_state_dir_name;
             uint64_t                 state_size             =  chain::config::default_state_size;
             uint64_t                 state_guard_size       =  chain::config::default_state_guard_size;
@@ -144,12 +147,18 @@ namespace eosio { namespace chain {
             uint64_t                 reversible_guard_size  =  chain::config::default_reversible_guard_size;
             uint32_t                 sig_cpu_bill_pct       =  chain::config::default_sig_cpu_bill_pct;
             uint16_t                 thread_pool_size       =  chain::config::default_controller_thread_pool_size;
+            uint32_t                 cache_manifest_rows    =  chain::config::default_cache_manifest_rows;     // 0 - don't save and load the hot set
+            uint32_t                 cache_manifest_interval = chain::config::default_cache_manifest_interval; // 0 - save only on shutdown
             bool                     read_only              =  false;
             bool                     force_all_checks       =  false;
             bool                     disable_replay_opts    =  false;
             bool                     contracts_console      =  false;
             bool                     allow_ram_billing_in_notify = false;
 
+            path                     replay_profile_file;             // if not empty, write profile of replayed blocks to it
+            uint32_t                 replay_profile_first_block = 0;
+            uint32_t                 replay_profile_last_block  = 0;  // stop replay after this block (0 - replay all blocks)
+
             genesis_state            genesis;
             wasm_interface::vm_type  wasm_runtime = chain::config::default_wasm_runtime;
 
@@ -237,6 +246,7 @@ namespace eosio { namespace chain {
          resource_limits_manager&              get_mutable_resource_limits_manager();
          const authorization_manager&          get_authorization_manager()const;
          authorization_manager&                get_mutable_authorization_manager();
+         deferred_transaction_scheduler&       get_mutable_deferred_scheduler();
 
          uint32_t             head_block_num()const;
          time_point           head_block_time()const;
@@ -287,6 +297,7 @@ namespace eosio { namespace chain {
          void validate_reversible_available_size() const;
 
          bool is_known_unexpired_transaction( const transaction_id_type& id) const;
+         void add_unexpired_transaction( const transaction_id_type& id, fc::time_point_sec expiration );
 
          int64_t set_proposed_producers( vector<producer_key> producers );
 
@@ -0,0 +1,91 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/transaction_metadata.hpp>
+
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace cyberway { namespace chaindb {
+   class chaindb_controller;
+} } // namespace cyberway::chaindb
+
+namespace eosio { namespace chain {
+
+   /**
+    * In-memory schedule of deferred transactions from the generated transaction table.
+    *
+    * Transactions are ordered by delay_until like the by_delay index and are kept unpacked, so producing
+    * and applying of blocks doesn't scan the table and unpack each transaction again. The table remains
+    * the source of truth. During the pending block the schedule is a superset of the table: rows which are
+    * removed or undone stay in the schedule until the end of the block, so an entry should be confirmed
+    * with is_scheduled() before use. Changed rows are reconciled with the table by sync() at the end
+    * of each pending block, and the whole schedule is rebuilt after the table is changed outside of
+    * the pending block (startup, snapshot loading, popping of blocks).
+    */
+   class deferred_transaction_scheduler {
+   public:
+      struct entry {
+         generated_transaction_object::id_type id;
+         transaction_id_type      trx_id;
+         time_point               delay_until;
+         time_point               published;
+         transaction_metadata_ptr trx; ///< the id of the row is the hash of the transaction, so it never gets stale
+      };
+      using entry_ptr = std::shared_ptr<const entry>;
+
+      explicit deferred_transaction_scheduler( cyberway::chaindb::chaindb_controller& );
+
+      /// registers the created or modified row of the table, trx is the transaction stored in the row
+      void add( const generated_transaction_object&, const transaction& trx );
+      /// registers the row which is removed from the table or gets a new trx_id
+      void remove( const transaction_id_type& );
+
+      /// the unpacked transaction of the row, or an empty pointer if it isn't scheduled
+      entry_ptr find( const transaction_id_type& );
+      /// transactions with delay_until <= time ordered by delay_until, including ones removed in the pending block
+      vector<entry_ptr> get_ready( time_point time );
+      /// checks the table for the row of the transaction
+      bool is_scheduled( const transaction_id_type& ) const;
+
+      /// reconciles rows changed in the pending block with the table, is called when the block is committed or aborted
+      void sync();
+      /// the table is changed outside of the pending block, the schedule is rebuilt on the next access
+      void reset();
+
+      size_t size() const {
+         return entries.size();
+      }
+
+   private:
+      struct id_hash {
+         // transaction id is a cryptographic hash itself
+         size_t operator()( const transaction_id_type& id )const {
+            return id._hash[0];
+         }
+      };
+
+      using schedule_key = std::tuple<time_point, generated_transaction_object::id_type, transaction_id_type>;
+
+      static schedule_key get_key( const entry& e ) {
+         return schedule_key( e.delay_until, e.id, e.trx_id );
+      }
+
+      void rebuild();
+      void insert( const generated_transaction_object&, transaction_metadata_ptr );
+      void erase( const transaction_id_type& );
+
+      cyberway::chaindb::chaindb_controller& chaindb;
+
+      bool valid = false;
+      std::map<schedule_key, entry_ptr> schedule;
+      std::unordered_map<transaction_id_type, entry_ptr, id_hash> entries;
+      vector<transaction_id_type> touched; ///< rows changed in the pending block
+   };
+
+} } /// namespace eosio::chain
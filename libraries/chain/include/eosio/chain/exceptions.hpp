@@ -508,6 +508,8 @@ namespace eosio { namespace chain {
                                     3200005, "http request fail" )
       FC_DECLARE_DERIVED_EXCEPTION( invalid_http_request, http_exception,
                                     3200006, "invalid http request" )
+      FC_DECLARE_DERIVED_EXCEPTION( http_response_too_large, http_exception,
+                                    3200007, "http response exceeds the size limit" )
 
    FC_DECLARE_DERIVED_EXCEPTION( resource_limit_exception, chain_exception,
                                  3210000, "Resource limit exception" )
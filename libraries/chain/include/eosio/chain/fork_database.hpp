@@ -18,6 +18,10 @@ namespace eosio { namespace chain {
     * database tracks the longest chain and the last irreversible block number. All
     * blocks older than the last irreversible block are freed after emitting the
     * irreversible signal.
+    *
+    * Changes are persisted to an append-only log by flush(), so the fork database is
+    * restored to the state of the last flush after an unclean shutdown. The log is
+    * compacted to the current content when it grows too large and on close().
     */
    class fork_database {
       public:
@@ -27,6 +31,12 @@ namespace eosio { namespace chain {
 
          void close();
 
+         /**
+          *  Appends changes made since the previous flush to the log, should be called
+          *  when the head block is consistent with the chain state.
+          */
+         void flush();
+
          block_state_ptr  get_block(const block_id_type& id)const;
          block_state_ptr  get_block_in_current_chain_by_num( uint32_t n )const;
 //         vector<block_state_ptr>    get_blocks_by_number(uint32_t n)const;
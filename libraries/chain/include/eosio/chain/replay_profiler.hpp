@@ -0,0 +1,109 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/trace.hpp>
+
+#include <cyberway/chaindb/cache_map.hpp>
+
+#include <array>
+#include <map>
+#include <tuple>
+
+namespace eosio { namespace chain {
+
+   /**
+    * Collects timings of blocks replayed from the block log.
+    *
+    * Only blocks in the range [first_block, last_block] are profiled. Each block gets the time spent
+    * in every phase of its application and the number of chaindb cache hits and misses, each action
+    * gets a histogram of its execution time. The report is written as JSON.
+    */
+   class replay_profiler {
+   public:
+      enum phase {
+         signatures,    ///< recovery of transaction signatures (or waiting for it on the thread pool)
+         authorization, ///< checking of transaction authorizations
+         execution,     ///< execution of transaction actions
+         flush,         ///< applying of the chaindb journal to the database
+         events,        ///< emission of controller signals
+         phase_count
+      };
+
+      /**
+       * Measures the time of a phase. Phases are exclusive: a timer started inside another one
+       * pauses it, so time of nested phases (e.g. signals emitted while a block is flushed) is counted once.
+       * Timers should be stopped in the reverse order of their start.
+       */
+      class scoped_timer {
+      public:
+         scoped_timer( replay_profiler* p, phase ph );
+         ~scoped_timer() { stop(); }
+
+         scoped_timer( const scoped_timer& ) = delete;
+         scoped_timer& operator=( const scoped_timer& ) = delete;
+
+         void stop();
+
+      private:
+         replay_profiler* profiler;
+         phase            ph;
+         fc::time_point   start;
+         scoped_timer*    parent = nullptr; ///< the paused enclosing timer
+      };
+
+      replay_profiler( uint32_t first_block, uint32_t last_block, fc::path output );
+
+      /// the replay should stop after this block
+      bool is_last_block( uint32_t block_num ) const { return last_block && block_num >= last_block; }
+      bool active() const { return current.valid(); }
+
+      void start_block( uint32_t block_num, const cyberway::chaindb::cache_stats& );
+      void end_block( const cyberway::chaindb::cache_stats& );
+
+      void add_time( phase, fc::microseconds );
+      void add_transaction( const transaction_trace& );
+
+      void write_report() const;
+
+   private:
+      struct histogram {
+         static constexpr size_t bucket_count = 24;
+
+         void add( fc::microseconds );
+
+         uint64_t count = 0;
+         uint64_t total_us = 0;
+         uint64_t max_us = 0;
+         std::array<uint64_t, bucket_count> buckets{}; ///< bucket i counts times less than 2^i us
+      };
+
+      struct block_profile {
+         uint32_t block_num = 0;
+         uint32_t transactions = 0;
+         fc::microseconds total;
+         std::array<fc::microseconds, phase_count> phases{};
+         uint64_t cache_hits = 0;
+         uint64_t cache_misses = 0;
+      };
+
+      void add_action( const action_trace& );
+
+      const uint32_t first_block;
+      const uint32_t last_block;
+      const fc::path output;
+
+      scoped_timer* active_timer = nullptr;
+
+      fc::optional<block_profile> current;
+      fc::time_point current_start;
+      cyberway::chaindb::cache_stats current_cache;
+
+      vector<block_profile> blocks;
+      std::map<std::tuple<account_name, account_name, action_name>, histogram> actions;
+   };
+
+} } /// namespace eosio::chain
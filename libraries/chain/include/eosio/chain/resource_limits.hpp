@@ -16,6 +16,11 @@ namespace cyberway { namespace chaindb {
     struct storage_payer_info;
 }} // namespace cyberway::chaindb
 
+namespace eosio { namespace chain { namespace resource_limits {
+   struct resource_usage_object;
+   struct resource_limits_config_object;
+}}} // namespace eosio::chain::resource_limits
+
 namespace eosio { namespace chain {
 
 namespace resource_limits {
@@ -66,9 +71,10 @@ namespace resource_limits {
          void update_account_usage( const flat_set<account_name>& accounts, uint32_t ordinal );
 
          void add_transaction_usage( const flat_set<account_name>& accounts, const ratios&, uint64_t cpu_usage, uint64_t net_usage, uint64_t ram_usage, fc::time_point pending_block_time, bool validate = true );
+         /// the same as add_transaction_usage() followed by the adding of storage deltas, but each usage object is written once
+         void add_transaction_usage( const flat_set<account_name>& accounts, const flat_map<account_name, int64_t>& storage_deltas, const ratios&, uint64_t cpu_usage, uint64_t net_usage, uint64_t ram_usage, fc::time_point pending_block_time, bool validate = true );
 
          void add_storage_usage( const account_name& account, int64_t delta, uint32_t time_slot );
-         void add_storage_usage( const flat_map<account_name, int64_t>&, const ratios& prices, fc::time_point, bool validate = true );
 
          void process_block_usage(uint32_t time_slot);
 
@@ -86,6 +92,7 @@ namespace resource_limits {
          uint64_t get_used_resources_cost(account_name account) const { return get_used_resources_cost(account, get_pricelist()); };
 
          uint64_t get_account_balance(fc::time_point pending_block_time, const account_name& account, const ratios& prices, bool update_state);
+         flat_map<account_name, uint64_t> get_account_balances(fc::time_point pending_block_time, const flat_set<account_name>& accounts, const ratios& prices, bool update_state);
 
          std::vector<uint64_t> get_account_usage(const account_name& account) const;
 
@@ -94,6 +101,14 @@ namespace resource_limits {
          }
 
       private:
+         struct usage_context;
+
+         usage_context get_usage_context() const;
+         ratio get_account_stake_ratio(const usage_context&, fc::time_point pending_block_time, const account_name& account, bool update_state);
+         std::vector<uint64_t> get_account_usage(const resource_limits_config_object&, const resource_usage_object&) const;
+         uint64_t get_used_resources_cost(account_name account, const std::vector<uint64_t>& usage, const ratios& prices, uint64_t max_cost) const;
+         uint64_t get_account_balance(const usage_context&, fc::time_point pending_block_time, const resource_usage_object&, const ratios& prices, bool update_state);
+
          chaindb_controller& _chaindb;
          bool _validate_storage_price = false;
    };
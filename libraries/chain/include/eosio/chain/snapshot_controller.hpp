@@ -5,6 +5,8 @@
 
 #include <cyberway/chaindb/controller.hpp>
 
+#include <boost/asio/thread_pool.hpp>
+
 namespace cyberway { namespace chaindb {
     class chaindb_controller;
 }}
@@ -22,7 +24,8 @@ namespace eosio { namespace chain {
                             fork_database& fork_db,
                             chainbase::database& reversible_blocks,
                             block_state_ptr& head,
-                            genesis_state& genesis);
+                            genesis_state& genesis,
+                            boost::asio::thread_pool& thread_pool);
 
         void write_snapshot(std::unique_ptr<snapshot_writer> writer);
 
@@ -43,7 +46,6 @@ namespace eosio { namespace chain {
         void insert_undo(cyberway::chaindb::service_state service, fc::variant value);
         void restore_contract(const cyberway::chaindb::abi_info& abi);
         void restore_table(const cyberway::chaindb::table_def& table, const cyberway::chaindb::abi_info& abi);
-        void restore_object(cyberway::chaindb::reflectable_service_state service, bytes bytes, const cyberway::chaindb::table_name& table, const cyberway::chaindb::abi_info& abi);
         void insert_object(cyberway::chaindb::service_state service, fc::variant value, cyberway::chaindb::table_name_t table, account_name code);
 
     private:
@@ -53,6 +55,7 @@ namespace eosio { namespace chain {
         chainbase::database& reversible_blocks;
         block_state_ptr& head;
         genesis_state& genesis;
+        boost::asio::thread_pool& thread_pool;
 
         std::map<const cyberway::chaindb::account_name_t, const cyberway::chaindb::abi_info> abies;
 
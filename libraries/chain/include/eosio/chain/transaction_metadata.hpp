@@ -57,8 +57,9 @@ class transaction_metadata {
       start_recover_keys( const transaction_metadata_ptr& mtrx, boost::asio::thread_pool& thread_pool,
                           const chain_id_type& chain_id, fc::microseconds time_limit );
 
-      // start_recover_keys must be called first
-      recovery_keys_type recover_keys( const chain_id_type& chain_id );
+      // start_recover_keys must be called first,
+      // otherwise keys are recovered in the calling thread, so the transaction should not be shared with other threads yet
+      recovery_keys_type recover_keys( const chain_id_type& chain_id, fc::microseconds time_limit = fc::microseconds::maximum() );
 
 
 };
@@ -13,6 +13,9 @@
 
 #include <eosio/chain/multi_index_includes.hpp>
 
+#include <map>
+#include <unordered_set>
+
 namespace eosio { namespace chain {
    /**
     * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
@@ -44,6 +47,58 @@ namespace eosio { namespace chain {
       >
    >;
 
+   /**
+    * In-memory index of the transaction ids stored in the transaction table.
+    *
+    * Ids are kept in a hash set and grouped into buckets by expiration, so they are released a bucket
+    * at a time. The index is a superset of the table: ids are added together with the rows, but released
+    * only after they expire before the last irreversible block, so rows which come back on undo are
+    * still covered. A miss proves that the transaction is unknown, a hit has to be confirmed by the table.
+    */
+   class transaction_dedupe_index {
+   public:
+      void add( const transaction_id_type& id, time_point_sec expiration ) {
+         if( ids.insert( id ).second ) {
+            buckets[expiration].push_back( id );
+         }
+      }
+
+      bool may_contain( const transaction_id_type& id )const {
+         return ids.count( id );
+      }
+
+      /// releases ids of transactions which expired before the given time
+      void remove_expired( time_point_sec time ) {
+         auto end = buckets.lower_bound( time );
+         for( auto itr = buckets.begin(); itr != end; ++itr ) {
+            for( const auto& id: itr->second ) {
+               ids.erase( id );
+            }
+         }
+         buckets.erase( buckets.begin(), end );
+      }
+
+      void clear() {
+         ids.clear();
+         buckets.clear();
+      }
+
+      size_t size()const {
+         return ids.size();
+      }
+
+   private:
+      struct id_hash {
+         // transaction id is a cryptographic hash itself
+         size_t operator()( const transaction_id_type& id )const {
+            return id._hash[0];
+         }
+      };
+
+      std::unordered_set<transaction_id_type, id_hash>          ids;
+      std::map<time_point_sec, std::vector<transaction_id_type>> buckets;
+   };
+
 } }
 
 CHAINDB_SET_TABLE_TYPE(eosio::chain::transaction_object, eosio::chain::transaction_table)
@@ -56,6 +56,11 @@ namespace eosio { namespace chain {
             wabt
          };
 
+         struct statistics {
+            uint32_t         instantiations = 0;  ///< number of modules instantiated (misses of the instantiation cache)
+            fc::microseconds instantiation_time;  ///< total time spent for instantiation of modules
+         };
+
          wasm_interface(vm_type vm);
          ~wasm_interface();
 
@@ -68,6 +73,13 @@ namespace eosio { namespace chain {
          //Immediately exits currently running wasm. UB is called when no wasm running
          void exit();
 
+         //Counters of module instantiations done by this interface
+         const statistics& get_statistics() const;
+
+         //Number of calls of each intrinsic ("module.name") done by all runtimes of the process,
+         //empty unless built with EOSIO_CONTRACT_BENCH
+         static std::map<string, uint64_t> get_intrinsic_call_counts();
+
       private:
          unique_ptr<struct wasm_interface_impl> my;
          friend class eosio::chain::webassembly::common::intrinsics_accessor;
@@ -60,6 +60,7 @@ namespace eosio { namespace chain {
                trx_context.resume_billing_timer();
             });
             trx_context.pause_billing_timer();
+            auto start = fc::time_point::now();
             IR::Module module;
             try {
                Serialization::MemoryInputStream stream((const U8*)code.data(), code.size());
@@ -85,17 +86,32 @@ namespace eosio { namespace chain {
                EOS_ASSERT(false, wasm_serialization_error, e.message.c_str());
             }
             it = instantiation_cache.emplace(code_id, runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module))).first;
+
+            ++stats.instantiations;
+            stats.instantiation_time += fc::time_point::now() - start;
          }
          return it->second;
       }
 
       std::unique_ptr<wasm_runtime_interface> runtime_interface;
       map<digest_type, std::unique_ptr<wasm_instantiated_module_interface>> instantiation_cache;
+      wasm_interface::statistics stats;
    };
 
+#ifdef EOSIO_CONTRACT_BENCH
+#define _REGISTER_INTRINSIC_CALL_COUNTER(CLS, MOD, METHOD, NAME, SIG)\
+   static eosio::chain::intrinsic_call_counter_registrator _INTRINSIC_NAME(__intrinsic_call_counter, __COUNTER__) (\
+      MOD "." NAME,\
+      &eosio::chain::intrinsic_call_counter<SIG, &CLS::METHOD>::value\
+   );
+#else
+#define _REGISTER_INTRINSIC_CALL_COUNTER(CLS, MOD, METHOD, NAME, SIG)
+#endif
+
 #define _REGISTER_INTRINSIC_EXPLICIT(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
    _REGISTER_WAVM_INTRINSIC(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
-   _REGISTER_WABT_INTRINSIC(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)
+   _REGISTER_WABT_INTRINSIC(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
+   _REGISTER_INTRINSIC_CALL_COUNTER(CLS, MOD, METHOD, NAME, SIG)
 
 #define _REGISTER_INTRINSIC4(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
    _REGISTER_INTRINSIC_EXPLICIT(CLS, MOD, METHOD, WASM_SIG, NAME, SIG )
@@ -98,4 +98,25 @@ namespace eosio { namespace chain {
       char *value;
    };
 
+   /**
+    * number of calls of an intrinsic, it is incremented by the wrappers of both runtimes
+    * only in builds with EOSIO_CONTRACT_BENCH (cmake -DENABLE_CONTRACT_BENCH=ON), the increment isn't atomic
+    * @tparam MethodSig - type of the method which implements the intrinsic
+    * @tparam Method - the method
+    */
+   template<typename MethodSig, MethodSig Method>
+   struct intrinsic_call_counter {
+      static uint64_t value;
+   };
+
+   template<typename MethodSig, MethodSig Method>
+   uint64_t intrinsic_call_counter<MethodSig, Method>::value = 0;
+
+   /**
+    * binds the name of an intrinsic to its counter of calls, see wasm_interface::get_intrinsic_call_counts()
+    */
+   struct intrinsic_call_counter_registrator {
+      intrinsic_call_counter_registrator(const char* name, const uint64_t* counter);
+   };
+
  } } // eosio::chain
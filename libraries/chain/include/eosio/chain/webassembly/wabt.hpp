@@ -655,6 +655,9 @@ struct intrinsic_function_invoker {
 
    template<MethodSig Method>
    static Ret wrapper(wabt_apply_instance_vars& vars, Params... params, const TypedValues&, int) {
+#ifdef EOSIO_CONTRACT_BENCH
+      ++intrinsic_call_counter<MethodSig, Method>::value;
+#endif
       class_from_wasm<Cls>::value(vars.ctx).checktime();
       return (class_from_wasm<Cls>::value(vars.ctx).*Method)(params...);
    }
@@ -671,6 +674,9 @@ struct intrinsic_function_invoker<void, MethodSig, Cls, Params...> {
 
    template<MethodSig Method>
    static void_type wrapper(wabt_apply_instance_vars& vars, Params... params, const TypedValues& args, int offset) {
+#ifdef EOSIO_CONTRACT_BENCH
+      ++intrinsic_call_counter<MethodSig, Method>::value;
+#endif
       class_from_wasm<Cls>::value(vars.ctx).checktime();
       (class_from_wasm<Cls>::value(vars.ctx).*Method)(params...);
       return void_type();
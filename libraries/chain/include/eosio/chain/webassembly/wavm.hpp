@@ -640,6 +640,9 @@ struct intrinsic_function_invoker {
 
    template<MethodSig Method>
    static Ret wrapper(running_instance_context& ctx, Params... params) {
+#ifdef EOSIO_CONTRACT_BENCH
+      ++intrinsic_call_counter<MethodSig, Method>::value;
+#endif
       class_from_wasm<Cls>::value(*ctx.apply_ctx).checktime();
       return (class_from_wasm<Cls>::value(*ctx.apply_ctx).*Method)(params...);
    }
@@ -659,6 +662,9 @@ struct intrinsic_function_invoker<WasmSig, void, MethodSig, Cls, Params...> {
 
    template<MethodSig Method>
    static void_type wrapper(running_instance_context& ctx, Params... params) {
+#ifdef EOSIO_CONTRACT_BENCH
+      ++intrinsic_call_counter<MethodSig, Method>::value;
+#endif
       class_from_wasm<Cls>::value(*ctx.apply_ctx).checktime();
       (class_from_wasm<Cls>::value(*ctx.apply_ctx).*Method)(params...);
       return void_type();
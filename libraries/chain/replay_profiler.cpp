@@ -0,0 +1,162 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <eosio/chain/replay_profiler.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+namespace eosio { namespace chain {
+
+   namespace {
+      const char* phase_names[replay_profiler::phase_count] = {
+         "signatures", "authorization", "execution", "flush", "events"
+      };
+   }
+
+   replay_profiler::scoped_timer::scoped_timer( replay_profiler* p, phase ph )
+   : profiler( p && p->active() ? p : nullptr ), ph( ph ) {
+      if( profiler ) {
+         start = fc::time_point::now();
+         parent = profiler->active_timer;
+         if( parent ) {
+            parent->profiler->add_time( parent->ph, start - parent->start );
+         }
+         profiler->active_timer = this;
+      }
+   }
+
+   void replay_profiler::scoped_timer::stop() {
+      if( profiler ) {
+         auto now = fc::time_point::now();
+         profiler->add_time( ph, now - start );
+         profiler->active_timer = parent;
+         if( parent ) {
+            parent->start = now;
+         }
+         profiler = nullptr;
+      }
+   }
+
+   void replay_profiler::histogram::add( fc::microseconds time ) {
+      uint64_t us = std::max<int64_t>( time.count(), 0 );
+      ++count;
+      total_us += us;
+      max_us = std::max( max_us, us );
+
+      size_t bucket = 0;
+      while( bucket + 1 < bucket_count && (uint64_t(1) << bucket) <= us ) ++bucket;
+      ++buckets[bucket];
+   }
+
+   replay_profiler::replay_profiler( uint32_t first_block, uint32_t last_block, fc::path output )
+   : first_block( first_block ), last_block( last_block ), output( std::move(output) ) {
+   }
+
+   void replay_profiler::start_block( uint32_t block_num, const cyberway::chaindb::cache_stats& cache ) {
+      current.reset();
+      if( block_num < first_block || (last_block && block_num > last_block) ) return;
+
+      current.emplace();
+      current->block_num = block_num;
+      current_cache = cache;
+      current_start = fc::time_point::now();
+   }
+
+   void replay_profiler::end_block( const cyberway::chaindb::cache_stats& cache ) {
+      if( !current ) return;
+
+      current->total = fc::time_point::now() - current_start;
+      current->cache_hits = cache.hits - current_cache.hits;
+      current->cache_misses = cache.misses - current_cache.misses;
+      blocks.emplace_back( std::move(*current) );
+      current.reset();
+   }
+
+   void replay_profiler::add_time( phase ph, fc::microseconds time ) {
+      if( current ) current->phases[ph] += time;
+   }
+
+   void replay_profiler::add_transaction( const transaction_trace& trace ) {
+      if( !current ) return;
+
+      ++current->transactions;
+      for( const auto& act: trace.action_traces ) {
+         add_action( act );
+      }
+   }
+
+   void replay_profiler::add_action( const action_trace& act ) {
+      actions[std::make_tuple( act.receipt.receiver, act.act.account, act.act.name )].add( act.elapsed );
+      for( const auto& inline_act: act.inline_traces ) {
+         add_action( inline_act );
+      }
+   }
+
+   void replay_profiler::write_report() const {
+      std::array<int64_t, phase_count> phase_totals{};
+      int64_t total_us = 0;
+      uint64_t cache_hits = 0, cache_misses = 0;
+
+      fc::variants block_list;
+      block_list.reserve( blocks.size() );
+      for( const auto& b: blocks ) {
+         fc::mutable_variant_object phases;
+         for( size_t i = 0; i < phase_count; ++i ) {
+            phases( phase_names[i], b.phases[i].count() );
+            phase_totals[i] += b.phases[i].count();
+         }
+         total_us += b.total.count();
+         cache_hits += b.cache_hits;
+         cache_misses += b.cache_misses;
+
+         block_list.emplace_back( fc::mutable_variant_object()
+            ( "block_num", b.block_num )
+            ( "transactions", b.transactions )
+            ( "total_us", b.total.count() )
+            ( "phases_us", std::move(phases) )
+            ( "cache_hits", b.cache_hits )
+            ( "cache_misses", b.cache_misses ) );
+      }
+
+      fc::variants action_list;
+      for( const auto& a: actions ) {
+         const auto& h = a.second;
+         fc::variants buckets;
+         for( size_t i = 0; i < histogram::bucket_count; ++i ) {
+            if( !h.buckets[i] ) continue;
+            buckets.emplace_back( fc::mutable_variant_object()
+               ( "lt_us", uint64_t(1) << i )
+               ( "count", h.buckets[i] ) );
+         }
+
+         action_list.emplace_back( fc::mutable_variant_object()
+            ( "receiver", std::get<0>(a.first) )
+            ( "account", std::get<1>(a.first) )
+            ( "action", std::get<2>(a.first) )
+            ( "count", h.count )
+            ( "total_us", h.total_us )
+            ( "max_us", h.max_us )
+            ( "histogram", std::move(buckets) ) );
+      }
+
+      fc::mutable_variant_object totals;
+      totals( "blocks", blocks.size() )( "total_us", total_us );
+      for( size_t i = 0; i < phase_count; ++i ) {
+         totals( string( phase_names[i] ) + "_us", phase_totals[i] );
+      }
+      totals( "cache_hits", cache_hits )( "cache_misses", cache_misses );
+
+      fc::json::save_to_file( fc::mutable_variant_object()
+         ( "first_block", blocks.empty() ? 0 : blocks.front().block_num )
+         ( "last_block", blocks.empty() ? 0 : blocks.back().block_num )
+         ( "totals", std::move(totals) )
+         ( "blocks", std::move(block_list) )
+         ( "actions", std::move(action_list) ), output, true );
+
+      ilog( "replay profile of ${n} blocks is written to '${file}'",
+            ("n", blocks.size())("file", output.generic_string()) );
+   }
+
+} } /// namespace eosio::chain
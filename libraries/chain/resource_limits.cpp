@@ -46,6 +46,26 @@ void elastic_limit_parameters::set(uint64_t target_, uint64_t min_, uint64_t max
     increase_rate.numerator = config::percent_100 + increase_pct;
 }
 
+// global objects which are read once per transaction instead of once per account
+struct resource_limits_manager::usage_context {
+   const resource_limits_config_object& config;
+   const stake_stat_object* stat; // nullptr if staking of the core token isn't enabled
+};
+
+resource_limits_manager::usage_context resource_limits_manager::get_usage_context() const {
+   symbol_code token_code { symbol(CORE_SYMBOL).to_symbol_code() };
+   const stake_stat_object* stat = nullptr;
+
+   if (!(_chaindb.find<stake_param_object>(token_code.value, cursor_kind::OneRecord)) ||
+       !(stat = _chaindb.find<stake_stat_object>(token_code.value, cursor_kind::OneRecord)) ||
+       !stat->enabled || stat->total_staked == 0
+   ) {
+      stat = nullptr;
+   }
+
+   return {_chaindb.get<resource_limits_config_object>(), stat};
+}
+
 void resource_limits_state_object::update_virtual_limit(const resource_limits_config_object& cfg, resource_id res) {
    virtual_limits[res] = update_elastic_limit(virtual_limits[res], block_usage_accumulators[res].average(), cfg.limit_parameters[res]);
 }
@@ -132,7 +152,7 @@ void resource_limits_manager::update_account_usage(const flat_set<account_name>&
    }
 }
 
-void resource_limits_state_object::add_pending_delta(int64_t delta, const chain_config& chain_cfg, resource_id res) {
+static void add_pending_delta(std::vector<int64_t>& pending_usage, int64_t delta, const chain_config& chain_cfg, resource_id res) {
     static auto constexpr large_number_no_overflow = std::numeric_limits<int64_t>::max() / 2;
     delta = std::max(std::min(delta, large_number_no_overflow), -large_number_no_overflow);
     auto& pending = pending_usage[res];
@@ -143,87 +163,86 @@ void resource_limits_state_object::add_pending_delta(int64_t delta, const chain_
         ("res", static_cast<int>(res))("delta", delta)("new_pending", pending)("max", max));
 }
 
+void resource_limits_state_object::add_pending_delta(int64_t delta, const chain_config& chain_cfg, resource_id res) {
+    resource_limits::add_pending_delta(pending_usage, delta, chain_cfg, res);
+}
+
 void resource_limits_manager::add_transaction_usage(
     const flat_set<account_name>& accounts, const ratios& prices,
     uint64_t cpu_usage, uint64_t net_usage, uint64_t ram_usage,
     fc::time_point pending_block_time, bool validate
 ) {
-   auto state_table = _chaindb.get_table<resource_limits_state_object>();
-   const auto& state = state_table.get();
-   const auto& config = _chaindb.get<resource_limits_config_object>();
+   add_transaction_usage(accounts, {}, prices, cpu_usage, net_usage, ram_usage, pending_block_time, validate);
+}
+
+void resource_limits_manager::add_transaction_usage(
+    const flat_set<account_name>& accounts, const flat_map<account_name, int64_t>& storage_deltas, const ratios& prices,
+    uint64_t cpu_usage, uint64_t net_usage, uint64_t ram_usage,
+    fc::time_point pending_block_time, bool validate
+) {
+   const auto ctx = get_usage_context();
+   const auto& config = ctx.config;
    auto usage_table = _chaindb.get_table<resource_usage_object>();
    auto owner_idx = usage_table.get_index<by_id>();
    auto time_slot = block_timestamp_type(pending_block_time).slot;
 
-   for( const auto& a : accounts ) {
-
-      const auto& usage = owner_idx.get( a );
+   // the usage is changed in copies of objects, which are written after all checks
+   std::map<account_name, resource_usage_object> usages;
+   auto get_usage = [&](const account_name& account) -> resource_usage_object& {
+      auto itr = usages.find(account);
+      if (usages.end() == itr) {
+         itr = usages.emplace(account, owner_idx.get(account)).first;
+      }
+      return itr->second;
+   };
 
-      usage_table.modify( usage, [&]( auto& bu ) {
-          bu.accumulators[CPU].add(cpu_usage, time_slot, config.account_usage_average_windows[CPU]);
-          bu.accumulators[NET].add(net_usage, time_slot, config.account_usage_average_windows[NET]);
-          bu.accumulators[RAM].add(ram_usage, time_slot, config.account_usage_average_windows[RAM]);
-      });
+   for( const auto& a : accounts ) {
+      auto& usage = get_usage(a);
+      usage.accumulators[CPU].add(cpu_usage, time_slot, config.account_usage_average_windows[CPU]);
+      usage.accumulators[NET].add(net_usage, time_slot, config.account_usage_average_windows[NET]);
+      usage.accumulators[RAM].add(ram_usage, time_slot, config.account_usage_average_windows[RAM]);
       if (validate) {
           // validate the resources available
-          get_account_balance(pending_block_time, a, prices, true);
+          get_account_balance(ctx, pending_block_time, usage, prices, true);
       }
    }
+
    // account for this transaction in the block and do not exceed those limits either
    const auto& chain_cfg = _chaindb.get<global_property_object>().configuration;
-   state_table.modify(state, [&](resource_limits_state_object& rls) {
-      rls.add_pending_delta(cpu_usage, chain_cfg, CPU);
-      rls.add_pending_delta(net_usage, chain_cfg, NET);
-      rls.add_pending_delta(ram_usage, chain_cfg, RAM);
-   });
-}
-
-void resource_limits_manager::add_storage_usage(
-   const flat_map<account_name, int64_t>& deltas, const ratios& prices, fc::time_point pending_block_time, bool validate
-) {
-   if( deltas.empty() ) {
-       return;
-   }
-
-   symbol_code token_code { symbol(CORE_SYMBOL).to_symbol_code() };
-
-   const stake_param_object* param = nullptr;
-   const stake_stat_object*  stat  = nullptr;
-
-   if (!(_chaindb.find<stake_param_object>(token_code.value, cursor_kind::OneRecord)) ||
-       !(stat = _chaindb.find<stake_stat_object>(token_code.value, cursor_kind::OneRecord)) ||
-       !stat->enabled || stat->total_staked == 0
-   ) {
-      return;
-   }
-
-   auto  time_slot = block_timestamp_type(pending_block_time).slot;
-   auto& config = _chaindb.get<resource_limits_config_object>();
-
-   int64_t delta = 0;
-   for( const auto& a : deltas ) {
-      if( 0 == a.second ) {
-          continue;
+   auto state_table = _chaindb.get_table<resource_limits_state_object>();
+   const auto& state = state_table.get();
+   auto pending_usage = state.pending_usage;
+   add_pending_delta(pending_usage, cpu_usage, chain_cfg, CPU);
+   add_pending_delta(pending_usage, net_usage, chain_cfg, NET);
+   add_pending_delta(pending_usage, ram_usage, chain_cfg, RAM);
+
+   if (ctx.stat) {
+      int64_t delta = 0;
+      for( const auto& a : storage_deltas ) {
+         if( 0 == a.second ) {
+             continue;
+         }
+         delta += a.second;
+
+         auto& usage = get_usage(a.first);
+         usage.accumulators[STORAGE].add(a.second, time_slot, config.account_usage_average_windows[STORAGE]);
+         if( validate && (a.second > 0 || _validate_storage_price)) {
+            get_account_balance(ctx, pending_block_time, usage, prices, true);
+         }
       }
-      delta += a.second;
 
-      auto& usage = _chaindb.get<resource_usage_object>(a.first);
-      _chaindb.modify( usage, [&]( auto& u ) {
-          u.accumulators[STORAGE].add(a.second, time_slot, config.account_usage_average_windows[STORAGE]);
-      });
-      if( validate && (a.second > 0 || _validate_storage_price)) {
-         get_account_balance(pending_block_time, a.first, prices, true);
+      if (0 != delta) {
+         add_pending_delta(pending_usage, delta, chain_cfg, STORAGE);
       }
    }
 
-   if ( 0 == delta ) {
-       return;
+   for (auto& u: usages) {
+      usage_table.modify(owner_idx.get(u.first), [&](auto& bu) {
+         bu.accumulators = std::move(u.second.accumulators);
+      });
    }
-
-   auto  state_table = _chaindb.get_table<resource_limits_state_object>();
-   auto& state = state_table.get();
    state_table.modify(state, [&](resource_limits_state_object& rls) {
-      rls.add_pending_delta(delta, _chaindb.get<global_property_object>().configuration, STORAGE);
+      rls.pending_usage = std::move(pending_usage);
    });
 }
 
@@ -232,21 +251,16 @@ void resource_limits_manager::add_storage_usage(const account_name& account, int
       return;
    }
 
-   symbol_code token_code { symbol(CORE_SYMBOL).to_symbol_code() };
-
-   const stake_param_object* param = nullptr;
-   const stake_stat_object* stat = nullptr;
-
-   if (_chaindb.get<account_object>(account).privileged || //assignments:
-       !(_chaindb.find<stake_param_object>(token_code.value, cursor_kind::OneRecord)) ||
-       !(stat  = _chaindb.find<stake_stat_object>(token_code.value, cursor_kind::OneRecord)) ||
-       !stat->enabled || stat->total_staked == 0
-   ) {
+   if (_chaindb.get<account_object>(account).privileged) {
+      return;
+   }
 
+   const auto ctx = get_usage_context();
+   if (!ctx.stat) {
       return;
    }
 
-   const auto& config = _chaindb.get<resource_limits_config_object>();
+   const auto& config = ctx.config;
    auto state_table  = _chaindb.get_table<resource_limits_state_object>();
    const auto& state = state_table.get();
    state_table.modify(state, [&](resource_limits_state_object& rls) {
@@ -259,9 +273,13 @@ void resource_limits_manager::add_storage_usage(const account_name& account, int
 }
 
 std::vector<uint64_t> resource_limits_manager::get_account_usage(const account_name& account)const {
-    const auto& config = _chaindb.get<resource_limits_config_object>();
-    auto usage_index = _chaindb.get_index<resource_usage_object, by_id>();
-    const auto& usage = usage_index.get(account);
+    // only the config is needed, so the stake objects of the usage context aren't read
+    return get_account_usage(_chaindb.get<resource_limits_config_object>(), _chaindb.get<resource_usage_object>(account));
+}
+
+std::vector<uint64_t> resource_limits_manager::get_account_usage(
+    const resource_limits_config_object& config, const resource_usage_object& usage
+) const {
     std::vector<uint64_t> ret(resources_num);
 
     for (size_t i = 0; i < resources_num; i++) {
@@ -304,7 +322,8 @@ uint64_t resource_limits_manager::get_block_limit(resource_id res, const chain_c
 ratios resource_limits_manager::get_pricelist() const {
 
     const auto& state  = _chaindb.get<resource_limits_state_object>();
-    const auto& config = _chaindb.get<resource_limits_config_object>();
+    const auto  ctx    = get_usage_context();
+    const auto& config = ctx.config;
 
     std::vector<uint64_t> used_pct(resources_num);
     for (size_t i = 0; i < resources_num; i++) {
@@ -314,14 +333,7 @@ ratios resource_limits_manager::get_pricelist() const {
 
     ratios ret(resources_num, ratio{0ll, 1ll});
 
-    symbol_code token_code { symbol(CORE_SYMBOL).to_symbol_code() };
-    const stake_param_object* param = nullptr;
-    const stake_stat_object* stat = nullptr;
-
-    if ((param = _chaindb.find<stake_param_object>(token_code.value, cursor_kind::OneRecord)) &&
-        (stat  = _chaindb.find<stake_stat_object>(token_code.value, cursor_kind::OneRecord)) &&
-        stat->enabled && stat->total_staked != 0
-    ) {
+    if (auto stat = ctx.stat) {
         EOS_ASSERT(stat->total_staked > 0, resource_limit_exception, "SYSTEM: incorrect total_staked");
 
         for (size_t i = 0; i < resources_num; i++) {
@@ -352,16 +364,16 @@ ratio resource_limits_manager::get_resource_usage_by_account_cost_ratio(account_
 }
 
 ratio resource_limits_manager::get_account_stake_ratio(fc::time_point pending_block_time, const account_name& account, bool update_state) {
-    symbol_code token_code { symbol(CORE_SYMBOL).to_symbol_code() };
-
-    const stake_param_object* param = nullptr;
-    const stake_stat_object* stat = nullptr;
+    return get_account_stake_ratio(get_usage_context(), pending_block_time, account, update_state);
+}
 
-    if (_chaindb.get<account_object>(account).privileged || //assignments:
-        !(param = _chaindb.find<stake_param_object>(token_code.value)) ||
-        !(stat  = _chaindb.find<stake_stat_object>(token_code.value)) ||
-        !stat->enabled || stat->total_staked == 0) {
+ratio resource_limits_manager::get_account_stake_ratio(
+    const usage_context& ctx, fc::time_point pending_block_time, const account_name& account, bool update_state
+) {
+    symbol_code token_code { symbol(CORE_SYMBOL).to_symbol_code() };
 
+    auto stat = ctx.stat;
+    if (_chaindb.get<account_object>(account).privileged || !stat) {
         return {0,0};
     }
 
@@ -384,8 +396,12 @@ ratio resource_limits_manager::get_account_stake_ratio(fc::time_point pending_bl
 }
 
 uint64_t resource_limits_manager::get_used_resources_cost(account_name account, const std::vector<ratio>& prices, uint64_t max_cost) const {
-    auto res_usage = get_account_usage(account);
+    return get_used_resources_cost(account, get_account_usage(account), prices, max_cost);
+}
 
+uint64_t resource_limits_manager::get_used_resources_cost(
+    account_name account, const std::vector<uint64_t>& res_usage, const std::vector<ratio>& prices, uint64_t max_cost
+) const {
     uint64_t cost = 0;
     for (size_t i = 0; i < resources_num; i++) {
         auto add = safe_prop_ceil(res_usage[i], prices[i].numerator, prices[i].denominator);
@@ -403,15 +419,35 @@ uint64_t resource_limits_manager::get_used_resources_cost(account_name account,
 }
 
 uint64_t resource_limits_manager::get_account_balance(fc::time_point pending_block_time, const account_name& account, const std::vector<ratio>& prices, bool update_state) {
+    return get_account_balance(get_usage_context(), pending_block_time, _chaindb.get<resource_usage_object>(account), prices, update_state);
+}
+
+flat_map<account_name, uint64_t> resource_limits_manager::get_account_balances(
+    fc::time_point pending_block_time, const flat_set<account_name>& accounts, const ratios& prices, bool update_state
+) {
+    const auto ctx = get_usage_context();
+    auto usage_index = _chaindb.get_index<resource_usage_object, by_id>();
 
-    const auto account_stake_ratio = get_account_stake_ratio(pending_block_time, account, update_state);
+    flat_map<account_name, uint64_t> balances;
+    balances.reserve(accounts.size());
+    for (const auto& a: accounts) {
+        balances.emplace(a, get_account_balance(ctx, pending_block_time, usage_index.get(a), prices, update_state));
+    }
+    return balances;
+}
+
+uint64_t resource_limits_manager::get_account_balance(
+    const usage_context& ctx, fc::time_point pending_block_time, const resource_usage_object& usage,
+    const std::vector<ratio>& prices, bool update_state
+) {
+    const auto account_stake_ratio = get_account_stake_ratio(ctx, pending_block_time, usage.owner, update_state);
     const auto staked = account_stake_ratio.numerator;
     const auto total_staked = account_stake_ratio.denominator;
 
     if (total_staked == 0) {
         return UINT64_MAX;
     }
-    uint64_t cost = get_used_resources_cost(account, prices, update_state ? staked : UINT64_MAX);
+    uint64_t cost = get_used_resources_cost(usage.owner, get_account_usage(ctx.config, usage), prices, update_state ? staked : UINT64_MAX);
     return (staked > cost) ? (staked - cost) : 0;
 }
 
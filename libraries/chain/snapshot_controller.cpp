@@ -7,6 +7,9 @@
 #include <eosio/chain/fork_database.hpp>
 #include <eosio/chain/snapshot_controller.hpp>
 #include <eosio/chain/reversible_block_object.hpp>
+#include <eosio/chain/thread_utils.hpp>
+
+#include <deque>
 
 enum class undo_data_type {
     normal_object,
@@ -48,6 +51,35 @@ namespace eosio { namespace chain {
         bool skip_processing_table(account_name code, cyberway::chaindb::table_name_t table) {
             return cyberway::chaindb::is_system_code(code) && (skip_processing_table(table));
         }
+
+        // rows of contract tables are (de)serialized on the thread pool in batches,
+        //   while the main thread reads the next batch and writes the previous ones in order
+        const size_t ROWS_PER_BATCH = 1024;
+        const size_t MAX_PENDING_BATCHES = 32;
+
+        using serialized_row = std::pair<cyberway::chaindb::reflectable_service_state, bytes>;
+        using deserialized_row = std::pair<cyberway::chaindb::reflectable_service_state, fc::variant>;
+
+        template <typename Row>
+        struct pending_batches final {
+            std::deque<std::future<std::vector<Row>>> futures;
+
+            ~pending_batches() {
+                // tasks refer to the table info on the stack
+                for (auto& future: futures) {
+                    if (future.valid()) {
+                        future.wait();
+                    }
+                }
+            }
+        };
+
+        cyberway::chaindb::table_info get_table_info(const cyberway::chaindb::table_def& table, const cyberway::chaindb::abi_info& abi) {
+            cyberway::chaindb::table_info info(abi.code(), config::ignore_scope_account);
+            info.table    = &table;
+            info.pk_order = abi.find_pk_order(table);
+            return info;
+        }
     }
 
     snapshot_controller::snapshot_controller(cyberway::chaindb::chaindb_controller& chaindb_controller,
@@ -55,13 +87,15 @@ namespace eosio { namespace chain {
                                              fork_database& fork_db,
                                              chainbase::database& reversible_blocks,
                                              block_state_ptr& head,
-                                             genesis_state& genesis) :
+                                             genesis_state& genesis,
+                                             boost::asio::thread_pool& thread_pool) :
         chaindb_controller(chaindb_controller),
         resource_limits(resource_limits),
         fork_db(fork_db),
         reversible_blocks(reversible_blocks),
         head(head),
-        genesis(genesis) {}
+        genesis(genesis),
+        thread_pool(thread_pool) {}
 
     void snapshot_controller::write_snapshot(std::unique_ptr<snapshot_writer> writer) {
         this->writer = std::move(writer);
@@ -120,7 +154,7 @@ namespace eosio { namespace chain {
                        fix_abi(abi);
                     }
 
-                    abies.emplace(std::make_pair<const cyberway::chaindb::account_name_t, const cyberway::chaindb::abi_info>(std::move(account.name.value), {account.name.value, abi}));
+                    abies.emplace(std::piecewise_construct, std::forward_as_tuple(account.name.value), std::forward_as_tuple(account.name, std::move(abi)));
                 }
                 section.add_row(account);
             });
@@ -178,16 +212,50 @@ namespace eosio { namespace chain {
 
     void snapshot_controller::dump_table(const cyberway::chaindb::table_def& table, const cyberway::chaindb::abi_info& abi) const {
         const cyberway::chaindb::index_request request = {abi.code(), config::ignore_scope_account, table.name, abi.find_pk_index(table)->name};
+        const auto info = get_table_info(table, abi);
 
         writer->write_section(abi.code().to_string() + "_" + table.name.to_string(), [&, this](auto& section){
+            pending_batches<serialized_row> batches;
+            std::vector<cyberway::chaindb::object_value> objects;
+
+            auto write_batch = [&]() {
+                for (auto& row: batches.futures.front().get()) {
+                    section.add_row(row.first);
+                    section.add_row(row.second);
+                }
+                batches.futures.pop_front();
+            };
+
+            auto serialize_batch = [&]() {
+                batches.futures.push_back(async_thread_pool(thread_pool, [&info, &abi, objects = std::move(objects)]() {
+                    std::vector<serialized_row> rows;
+                    rows.reserve(objects.size());
+                    for (auto& object: objects) {
+                        rows.emplace_back(object.service, abi.to_bytes(info, object.value));
+                    }
+                    return rows;
+                }));
+                objects.clear();
+
+                if (batches.futures.size() >= MAX_PENDING_BATCHES) {
+                    write_batch();
+                }
+            };
+
             auto begin = chaindb_controller.begin(request);
             const auto end = chaindb_controller.end(request);
             for (cyberway::chaindb::primary_key_t key = begin.pk; key != end.pk; key = chaindb_controller.next({abi.code(), begin.cursor})) {
-                auto object = chaindb_controller.object_at_cursor({abi.code(), begin.cursor});
-                const auto serialized = chaindb_controller.serialize(abi, object);
+                objects.push_back(chaindb_controller.object_at_cursor({abi.code(), begin.cursor}));
+                if (objects.size() >= ROWS_PER_BATCH) {
+                    serialize_batch();
+                }
+            }
 
-                section.add_row(cyberway::chaindb::reflectable_service_state(object.service));
-                section.add_row(serialized);
+            if (!objects.empty()) {
+                serialize_batch();
+            }
+            while (!batches.futures.empty()) {
+                write_batch();
             }
         });
     }
@@ -204,14 +272,30 @@ namespace eosio { namespace chain {
            section.read_row(genesis);
         });
 
-        restore_accounts();
+        // indexes of contract tables are built once after all their rows are loaded
+        chaindb_controller.enable_deferred_indexes();
+        try {
+            restore_accounts();
 
-        restore_undo_state();
+            restore_undo_state();
 
-        for (const auto& abi : abies) {
-           restore_contract(abi.second);
+            for (const auto& abi : abies) {
+               restore_contract(abi.second);
+            }
+        } catch (...) {
+            // tables created after the failure should get their indexes at once
+            try {
+                chaindb_controller.disable_deferred_indexes();
+            } catch (const fc::exception& e) {
+                elog("Fail to create deferred indexes: ${e}", ("e", e.to_detail_string()));
+            } catch (const std::exception& e) {
+                elog("Fail to create deferred indexes: ${e}", ("e", e.what()));
+            }
+            throw;
         }
 
+        chaindb_controller.disable_deferred_indexes();
+
         return snapshot_head_block;
     }
 
@@ -282,7 +366,7 @@ namespace eosio { namespace chain {
                          if (value.name.value == config::system_account_name) {
                             fix_abi(abi);
                          }
-                         abies.emplace(std::make_pair<const cyberway::chaindb::account_name_t, const cyberway::chaindb::abi_info>(value.name, {value.name, abi}));
+                         abies.emplace(std::piecewise_construct, std::forward_as_tuple(value.name.value), std::forward_as_tuple(value.name, std::move(abi)));
                      }
                  });
              } while(hasMore);
@@ -343,11 +427,39 @@ namespace eosio { namespace chain {
     }
 
     void snapshot_controller::restore_table(const cyberway::chaindb::table_def& table, const cyberway::chaindb::abi_info& abi) {
+        const auto info = get_table_info(table, abi);
+
         reader->read_section(abi.code().to_string() + "_" + table.name.to_string(), [&, this] (auto& section) {
             if (section.empty()) {
                 return;
             }
 
+            pending_batches<deserialized_row> batches;
+            std::vector<serialized_row> rows;
+
+            auto insert_batch = [&]() {
+                for (auto& row: batches.futures.front().get()) {
+                    insert_object(std::move(row.first), std::move(row.second), table.name, abi.code());
+                }
+                batches.futures.pop_front();
+            };
+
+            auto deserialize_batch = [&]() {
+                batches.futures.push_back(async_thread_pool(thread_pool, [&info, &abi, rows = std::move(rows)]() {
+                    std::vector<deserialized_row> objects;
+                    objects.reserve(rows.size());
+                    for (auto& row: rows) {
+                        objects.emplace_back(row.first, abi.to_object(info, row.second.data(), row.second.size()));
+                    }
+                    return objects;
+                }));
+                rows.clear();
+
+                if (batches.futures.size() >= MAX_PENDING_BATCHES) {
+                    insert_batch();
+                }
+            };
+
             bool has_more = false;
 
             do {
@@ -357,21 +469,22 @@ namespace eosio { namespace chain {
                bytes bytes;
                has_more = section.read_row(bytes);
 
-               restore_object(std::move(service), std::move(bytes), table.name, abi);
+               rows.emplace_back(std::move(service), std::move(bytes));
+               if (rows.size() >= ROWS_PER_BATCH) {
+                   deserialize_batch();
+               }
             } while(has_more);
+
+            if (!rows.empty()) {
+                deserialize_batch();
+            }
+            while (!batches.futures.empty()) {
+                insert_batch();
+            }
         });
         chaindb_controller.apply_all_changes();
     }
 
-    void snapshot_controller::restore_object(cyberway::chaindb::reflectable_service_state service,
-                                             bytes bytes,
-                                             const cyberway::chaindb::table_name& table,
-                                             const cyberway::chaindb::abi_info& abi) {
-        auto value = chaindb_controller.deserialize({service.code, service.scope, service.table}, abi, bytes);
-
-        insert_object(service, value, table, abi.code());
-    }
-
     void snapshot_controller::insert_object(cyberway::chaindb::service_state service,
                                             fc::variant value,
                                             cyberway::chaindb::table_name_t table,
@@ -4,6 +4,7 @@
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 
@@ -376,11 +377,9 @@ namespace bacc = boost::accumulators;
       auto& rl = control.get_mutable_resource_limits_manager();
       auto  pending_block_time = control.pending_block_time();
 
-      rl.add_transaction_usage( bill_to_accounts, pricelist,
+      rl.add_transaction_usage( bill_to_accounts, accounts_storage_deltas, pricelist,
          static_cast<uint64_t>(billed_cpu_time_us), net_usage, billed_ram_bytes,
-         pending_block_time);
-
-      rl.add_storage_usage( accounts_storage_deltas, pricelist, pending_block_time );
+         pending_block_time );
 
       if( control.is_producing_block() ) {
          control.chaindb().apply_all_changes();
@@ -619,20 +618,15 @@ namespace bacc = boost::accumulators;
         gto.expiration  = gto.delay_until + fc::seconds(control.get_global_properties().configuration.deferred_trx_expiration_window);
         trx_size = gto.set( trx );
       });
+      control.get_mutable_deferred_scheduler().add( res.obj, trx );
 
 // TODO: Removed by CyberWay
 //      add_ram_usage( cgto.payer, (config::billable_size_v<generated_transaction_object> + trx_size) );
    }
 
    void transaction_context::record_transaction( const transaction_id_type& id, fc::time_point_sec expire ) {
-      auto trx_idx = control.chaindb().get_index<transaction_object, by_trx_id>();
-      auto itr = trx_idx.find(id, cyberway::chaindb::cursor_kind::InRAM);
-      EOS_ASSERT(trx_idx.end() == itr, tx_duplicate, "duplicate transaction ${id}", ("id", id ));
-
-      trx_idx.emplace([&](transaction_object& transaction) {
-         transaction.trx_id     = id;
-         transaction.expiration = expire;
-      });
+      EOS_ASSERT(!control.is_known_unexpired_transaction(id), tx_duplicate, "duplicate transaction ${id}", ("id", id ));
+      control.add_unexpired_transaction(id, expire);
    } /// record_transaction
 
    void transaction_context::validate_referenced_accounts(const transaction& trx) const {
@@ -688,8 +682,9 @@ namespace bacc = boost::accumulators;
         rl.update_account_usage(trx_ctx.bill_to_accounts, block_timestamp_type(pending_block_time).slot);
         min_cpu_limit = UINT64_MAX;
         cpu_limits.reserve(trx_ctx.bill_to_accounts.capacity());
-        for (const auto& a : trx_ctx.bill_to_accounts) {
-            auto balance = rl.get_account_balance(pending_block_time, a, trx_ctx.pricelist, true);
+        for (const auto& ab : rl.get_account_balances(pending_block_time, trx_ctx.bill_to_accounts, trx_ctx.pricelist, true)) {
+            auto& a = ab.first;
+            auto  balance = ab.second;
             auto& lim = cpu_limits[a];
             lim = UINT64_MAX;
             if (cpu_price.numerator && balance < UINT64_MAX) {
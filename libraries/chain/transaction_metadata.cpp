@@ -4,7 +4,7 @@
 
 namespace eosio { namespace chain {
 
-recovery_keys_type transaction_metadata::recover_keys( const chain_id_type& chain_id ) {
+recovery_keys_type transaction_metadata::recover_keys( const chain_id_type& chain_id, fc::microseconds time_limit ) {
    // Unlikely for more than one chain_id to be used in one nodeos instance
    if( signing_keys_future.valid() ) {
       const std::tuple<chain_id_type, fc::microseconds, flat_set<public_key_type>>& sig_keys = signing_keys_future.get();
@@ -15,9 +15,11 @@ recovery_keys_type transaction_metadata::recover_keys( const chain_id_type& chai
 
    // shared_keys_future not created or different chain_id
    std::promise<signing_keys_future_value_type> p;
+   fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
+                             fc::time_point::maximum() : fc::time_point::now() + time_limit;
    flat_set<public_key_type> recovered_pub_keys;
    const signed_transaction& trn = packed_trx->get_signed_transaction();
-   fc::microseconds cpu_usage = trn.get_signature_keys( chain_id, fc::time_point::maximum(), recovered_pub_keys );
+   fc::microseconds cpu_usage = trn.get_signature_keys( chain_id, deadline, recovered_pub_keys );
    p.set_value( std::make_tuple( chain_id, cpu_usage, std::move( recovered_pub_keys ) ) );
    signing_keys_future = p.get_future().share();
 
@@ -67,6 +67,29 @@ namespace eosio { namespace chain {
       my->runtime_interface->immediately_exit_currently_running_module();
    }
 
+   const wasm_interface::statistics& wasm_interface::get_statistics() const {
+      return my->stats;
+   }
+
+   namespace {
+      std::map<string, const uint64_t*>& intrinsic_call_counters() {
+         static std::map<string, const uint64_t*> counters;
+         return counters;
+      }
+   }
+
+   intrinsic_call_counter_registrator::intrinsic_call_counter_registrator(const char* name, const uint64_t* counter) {
+      intrinsic_call_counters().emplace(name, counter);
+   }
+
+   std::map<string, uint64_t> wasm_interface::get_intrinsic_call_counts() {
+      std::map<string, uint64_t> counts;
+      for (const auto& c: intrinsic_call_counters()) {
+         counts.emplace(c.first, *c.second);
+      }
+      return counts;
+   }
+
    wasm_instantiated_module_interface::~wasm_instantiated_module_interface() {}
    wasm_runtime_interface::~wasm_runtime_interface() {}
 
@@ -675,6 +698,14 @@ class producer_api : public context_aware_api {
       }
 };
 
+/**
+ * Part of the data buffer hashed by the batch methods of crypto_api
+ */
+struct hash_segment {
+   uint32_t offset; ///< offset from the beginning of the data buffer
+   uint32_t length;
+};
+
 class crypto_api : public context_aware_api {
    public:
       explicit crypto_api( apply_context& ctx )
@@ -723,6 +754,33 @@ class crypto_api : public context_aware_api {
          return e.result();
       }
 
+      /**
+       * Hashes several parts of one data buffer in one call to avoid the overhead of an intrinsic call per part.
+       * The results are the same as those of the single-buffer methods.
+       */
+      template<class Encoder, class Hash> void encode_batch( array_ptr<char> data, size_t datalen,
+                                                             array_ptr<const hash_segment> segments, size_t count,
+                                                             array_ptr<Hash> hashes, size_t hashes_count ) {
+         EOS_ASSERT( count == hashes_count, crypto_api_exception, "number of hashes doesn't match number of segments" );
+
+         const size_t bs = eosio::chain::config::hashing_checktime_block_size;
+         size_t unchecked = 0;
+         for( size_t i = 0; i < count; ++i ) {
+            const auto& s = segments.value[i];
+            EOS_ASSERT( s.offset <= datalen && s.length <= datalen - s.offset, crypto_api_exception,
+                        "hash segment is out of the data buffer" );
+
+            hashes.value[i] = encode<Encoder>( data.value + s.offset, s.length );
+
+            // even an empty segment costs at least one compression of the hash function
+            unchecked += std::max<size_t>( s.length % bs, 64 );
+            if( unchecked > bs ) {
+               context.trx_context.checktime();
+               unchecked = 0;
+            }
+         }
+      }
+
       void assert_sha256(array_ptr<char> data, size_t datalen, const fc::sha256& hash_val) {
          auto result = encode<fc::sha256::encoder>( data, datalen );
          EOS_ASSERT( result == hash_val, crypto_api_exception, "hash mismatch" );
@@ -758,6 +816,26 @@ class crypto_api : public context_aware_api {
       void ripemd160(array_ptr<char> data, size_t datalen, fc::ripemd160& hash_val) {
          hash_val = encode<fc::ripemd160::encoder>( data, datalen );
       }
+
+      void sha1_batch(array_ptr<char> data, size_t datalen, array_ptr<const hash_segment> segments, size_t count,
+                      array_ptr<fc::sha1> hashes, size_t hashes_count) {
+         encode_batch<fc::sha1::encoder>( data, datalen, segments, count, hashes, hashes_count );
+      }
+
+      void sha256_batch(array_ptr<char> data, size_t datalen, array_ptr<const hash_segment> segments, size_t count,
+                        array_ptr<fc::sha256> hashes, size_t hashes_count) {
+         encode_batch<fc::sha256::encoder>( data, datalen, segments, count, hashes, hashes_count );
+      }
+
+      void sha512_batch(array_ptr<char> data, size_t datalen, array_ptr<const hash_segment> segments, size_t count,
+                        array_ptr<fc::sha512> hashes, size_t hashes_count) {
+         encode_batch<fc::sha512::encoder>( data, datalen, segments, count, hashes, hashes_count );
+      }
+
+      void ripemd160_batch(array_ptr<char> data, size_t datalen, array_ptr<const hash_segment> segments, size_t count,
+                           array_ptr<fc::ripemd160> hashes, size_t hashes_count) {
+         encode_batch<fc::ripemd160::encoder>( data, datalen, segments, count, hashes, hashes_count );
+      }
 };
 
 class permission_api : public context_aware_api {
@@ -1841,6 +1919,10 @@ REGISTER_INTRINSICS(crypto_api,
    (sha256,                 void(int, int, int)           )
    (sha512,                 void(int, int, int)           )
    (ripemd160,              void(int, int, int)           )
+   (sha1_batch,             void(int, int, int, int, int, int) )
+   (sha256_batch,           void(int, int, int, int, int, int) )
+   (sha512_batch,           void(int, int, int, int, int, int) )
+   (ripemd160_batch,        void(int, int, int, int, int, int) )
 );
 
 
@@ -4,6 +4,7 @@
 #include <eosio/chain/wast_to_wasm.hpp>
 #include <eosio/chain/eosio_contract.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
 
 #include <eosio.bios/eosio.bios.wast.hpp>
 #include <eosio.bios/eosio.bios.abi.hpp>
@@ -273,14 +274,11 @@ namespace eosio { namespace testing {
    }
 
    vector<transaction_id_type> base_tester::get_scheduled_transactions() const {
-      const auto& idx = control->chaindb().get_index<generated_transaction_object,by_delay>();
+      auto& scheduler = control->get_mutable_deferred_scheduler();
 
       vector<transaction_id_type> result;
-
-      auto itr = idx.begin();
-      while( itr != idx.end() && itr->delay_until <= control->pending_block_time() ) {
-         result.emplace_back(itr->trx_id);
-         ++itr;
+      for( const auto& sch: scheduler.get_ready( control->pending_block_time() ) ) {
+         if( scheduler.is_scheduled( sch->trx_id ) ) result.emplace_back( sch->trx_id );
       }
       return result;
    }
@@ -932,7 +932,7 @@ void chain_api_plugin::plugin_startup() {
 
     my.reset(new chain_api_plugin_impl(chain.chain(), chain.get_abi_serializer_max_time(), !http.verbose_errors()));
 
-    http.add_api({
+    http.add_api(chain.get_response_cache().wrap({
       CREATE_READ_HANDLER((*my), get_account, 200),
       CREATE_READ_HANDLER((*my), get_code, 200),
       CREATE_READ_HANDLER((*my), get_code_hash, 200),
@@ -954,7 +954,7 @@ void chain_api_plugin::plugin_startup() {
       CREATE_READ_HANDLER((*my), resolve_names, 200),
       CREATE_READ_HANDLER((*my), get_proxy_status, 200),
       CREATE_READ_HANDLER((*my), get_proxylevel_limits, 200)
-    });
+    }));
 }
 
 } // namespace api
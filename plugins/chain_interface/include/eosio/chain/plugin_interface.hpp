@@ -50,6 +50,8 @@ namespace eosio { namespace chain { namespace plugin_interface {
          // synchronously push a block/trx to a single provider
          using block_sync            = method_decl<chain_plugin_interface, void(const signed_block_ptr&), first_provider_policy>;
          using transaction_async     = method_decl<chain_plugin_interface, void(const transaction_metadata_ptr&, bool, next_function<transaction_trace_ptr>), first_provider_policy>;
+         // transactions with recovered keys are queued as one unit and processed in order, each one reports to its own next
+         using transaction_batch_async = method_decl<chain_plugin_interface, void(const std::vector<std::pair<transaction_metadata_ptr, next_function<transaction_trace_ptr>>>&, bool), first_provider_policy>;
       }
    }
 
@@ -20,9 +20,15 @@
 #include <eosio/plugins_common/http_request_handlers.hpp>
 #include <eosio/plugins_common/chain_utils.hpp>
 
+#include <cyberway/chaindb/abi_registry.hpp>
+#include <cyberway/chaindb/cache_map.hpp>
+#include <cyberway/chaindb/driver_interface.hpp>
+#include <eosio/plugins_common/response_cache.hpp>
+
 #include <eosio/http_plugin/http_plugin.hpp>
 
 #include <boost/signals2/connection.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -31,6 +37,7 @@
 #include <fc/variant.hpp>
 #include <signal.h>
 #include <cstdlib>
+#include <atomic>
 
 namespace eosio {
 
@@ -148,6 +155,83 @@ using boost::signals2::scoped_connection;
       NEXT(e.dynamic_copy_exception());\
    }
 
+namespace {
+   // state of the batch shared by the workers of the thread pool and the callbacks of producer_plugin
+   struct push_batch final {
+      push_batch(size_t size, next_function<push_transactions_results> next)
+      : packed(size), trxs(size), errors(size), results(size), pending_checks(size), pending_results(size), next(std::move(next)) {
+      }
+
+      std::vector<packed_transaction_ptr>   packed; ///< transactions which were converted with ABI in the main thread
+      std::vector<transaction_metadata_ptr> trxs;
+      std::vector<fc::exception_ptr>        errors;
+      push_transactions_results             results;
+      std::atomic<size_t>                   pending_checks;
+      size_t                                pending_results; ///< is used only in the main thread
+      next_function<push_transactions_results> next;
+   };
+
+   // context-free checks of a transaction, they repeat the checks of the controller to reject a transaction before it is queued
+   struct push_checks final {
+      chain_id_type    chain_id;
+      time_point       reference_time; ///< the time of the pending block or of the head block, next blocks are always later
+      bool             skip_trx_checks = false; ///< the controller doesn't check expiration and usage limits
+      uint64_t         max_block_net_usage = 0;
+      uint64_t         max_net_usage = 0;
+      uint64_t         base_net_usage = 0;
+      uint64_t         trx_id_net_usage = 0;
+      uint32_t         discount_num = 0;
+      uint32_t         discount_den = 0;
+      fc::microseconds max_recovery_time;
+      fc::microseconds abi_serializer_max_time;
+
+      void validate(const packed_transaction& ptrx) const {
+         if( skip_trx_checks ) {
+            return;
+         }
+
+         const auto& trx = ptrx.get_signed_transaction();
+
+         EOS_ASSERT( time_point(trx.expiration) >= reference_time, expired_tx_exception,
+                     "transaction has expired, expiration is ${trx.expiration} and block time is ${time}",
+                     ("trx.expiration",trx.expiration)("time",reference_time) );
+
+         uint64_t prunable_size = ptrx.get_prunable_size();
+         if( discount_den > 0 && discount_num < discount_den ) {
+            prunable_size = (prunable_size * discount_num + discount_den - 1) / discount_den;
+         }
+         uint64_t net_usage = base_net_usage + ptrx.get_unprunable_size() + prunable_size;
+         if( trx.delay_sec.value > 0 ) {
+            // the controller charges ahead for retiring the delayed transaction
+            net_usage += base_net_usage + trx_id_net_usage;
+         }
+
+         // the same limits as in transaction_context::init(), the block limit is taken for an empty block
+         uint64_t net_limit = max_block_net_usage;
+         bool due_to_block = true;
+         auto update_limit = [&](uint64_t limit) {
+            if( limit && limit <= net_limit ) {
+               net_limit = limit;
+               due_to_block = false;
+            }
+         };
+         update_limit(max_net_usage);
+         update_limit(static_cast<uint64_t>(trx.max_net_usage_words.value) * 8);
+         net_limit = (net_limit / 8) * 8;
+
+         if( BOOST_UNLIKELY(net_usage > net_limit) ) {
+            auto res_id = static_cast<int>(resource_limits::NET);
+            if( due_to_block ) {
+               EOS_THROW( block_usage_exceeded, "not enough resource(${res_id}) left in block: ${arg} > ${max}",
+                          ("res_id", res_id)("arg", net_usage)("max", net_limit) );
+            }
+            EOS_THROW( tx_usage_exceeded, "transaction resource(${res_id}) usage is too high: ${arg} > ${max}",
+                       ("res_id", res_id)("arg", net_usage)("max", net_limit) );
+         }
+      }
+   };
+} // namespace
+
 class chain_plugin_impl {
 public:
    chain_plugin_impl()
@@ -160,6 +244,7 @@ public:
    ,incoming_block_channel(app().get_channel<incoming::channels::block>())
    ,incoming_block_sync_method(app().get_method<incoming::methods::block_sync>())
    ,incoming_transaction_async_method(app().get_method<incoming::methods::transaction_async>())
+   ,incoming_transaction_batch_async_method(app().get_method<incoming::methods::transaction_batch_async>())
    {}
 
    bfs::path                        blocks_dir;
@@ -177,6 +262,7 @@ public:
    fc::optional<vm_type>            wasm_runtime;
    fc::microseconds                 abi_serializer_max_time_ms;
    fc::optional<bfs::path>          snapshot_path;
+   response_cache                   api_cache;
 
    // retained references to channels for easy publication
    channels::pre_accepted_block::channel_type&     pre_accepted_block_channel;
@@ -190,6 +276,7 @@ public:
    // retained references to methods for easy calling
    incoming::methods::block_sync::method_type&        incoming_block_sync_method;
    incoming::methods::transaction_async::method_type& incoming_transaction_async_method;
+   incoming::methods::transaction_batch_async::method_type& incoming_transaction_batch_async_method;
 
    // method provider handles
    methods::get_block_by_number::method_type::handle                 get_block_by_number_provider;
@@ -216,6 +303,9 @@ public:
    void push_transaction(const push_transaction_params& params, chain::plugin_interface::next_function<push_transaction_results> next);
 
    void push_transactions(const push_transactions_params& params, chain::plugin_interface::next_function<push_transactions_results> next);
+
+private:
+   void push_checked_transactions(const std::shared_ptr<push_batch>& batch);
 };
 
 void chain_plugin_impl::push_block(push_block_params&& params, next_function<push_block_results> next) {
@@ -264,37 +354,138 @@ void chain_plugin_impl::push_transaction(const push_transaction_params& params,
    } CATCH_AND_CALL(next);
 }
 
-static void push_recurse(chain_plugin_impl* plugin, int index, const std::shared_ptr<push_transactions_params>& params, const std::shared_ptr<push_transactions_results>& results, const next_function<push_transactions_results>& next) {
-   auto wrapped_next = [=](const fc::static_variant<fc::exception_ptr, push_transaction_results>& result) {
-      if (result.contains<fc::exception_ptr>()) {
-         const auto& e = result.get<fc::exception_ptr>();
-         results->emplace_back( push_transaction_results{ transaction_id_type(), fc::mutable_variant_object( "error", e->to_detail_string() ) } );
-      } else {
-         const auto& r = result.get<push_transaction_results>();
-         results->emplace_back( r );
+void chain_plugin_impl::push_transactions(const push_transactions_params& params, next_function<push_transactions_results> next) {
+   try {
+      EOS_ASSERT( params.size() <= 1000, too_many_tx_at_once, "Attempt to push too many transactions at once" );
+      if( params.empty() ) {
+         next(push_transactions_results());
+         return;
       }
 
-      int next_index = index + 1;
-      if (next_index < params->size()) {
-         push_recurse(plugin, next_index, params, results, next );
-      } else {
-         next(*results);
+      const auto& cfg = chain->get_global_properties().configuration;
+      push_checks checks;
+      checks.chain_id = chain->get_chain_id();
+      checks.reference_time = chain->pending_block_state() ? chain->pending_block_time() : chain->head_block_time();
+      checks.skip_trx_checks = chain->skip_trx_checks();
+      checks.max_block_net_usage = cfg.max_block_usage[resource_limits::NET];
+      checks.max_net_usage = cfg.max_transaction_usage[resource_limits::NET];
+      checks.base_net_usage = cfg.base_per_transaction_net_usage;
+      checks.trx_id_net_usage = config::transaction_id_net_usage;
+      checks.discount_num = cfg.context_free_discount_net_usage_num;
+      checks.discount_den = cfg.context_free_discount_net_usage_den;
+      checks.max_recovery_time = fc::microseconds(cfg.max_transaction_usage[resource_limits::CPU]);
+      checks.abi_serializer_max_time = abi_serializer_max_time_ms;
+
+      auto batch = std::make_shared<push_batch>(params.size(), next);
+
+      // ABI is read from the chaindb, which is available only in the main thread,
+      // so only transactions in the packed form are unpacked by workers
+      auto resolver = make_resolver(chain->chaindb(), abi_serializer_max_time_ms);
+      for( size_t i = 0; i < params.size(); ++i ) {
+         const auto& vo = params[i];
+         if( vo.contains("packed_trx") && vo["packed_trx"].is_string() && !vo["packed_trx"].as_string().empty() ) {
+            continue;
+         }
+         auto store = [&](const fc::exception_ptr& e) { batch->errors[i] = e; };
+         try {
+            auto ptrx = std::make_shared<packed_transaction>();
+            try {
+               abi_serializer::from_variant(vo, *ptrx, resolver, abi_serializer_max_time_ms);
+            } EOS_RETHROW_EXCEPTIONS(chain::packed_transaction_type_exception, "Invalid packed transaction")
+            batch->packed[i] = std::move(ptrx);
+         } CATCH_AND_CALL(store);
       }
-   };
 
-   plugin->push_transaction(params->at(index), wrapped_next);
+      for( size_t i = 0; i < params.size(); ++i ) {
+         boost::asio::post( chain->get_thread_pool(), [this, batch, i, checks, vo = params[i]]() {
+            auto store = [&](const fc::exception_ptr& e) { batch->errors[i] = e; };
+            if( !batch->errors[i] ) {
+               try {
+                  auto ptrx = std::move(batch->packed[i]);
+                  if( !ptrx ) {
+                     ptrx = std::make_shared<packed_transaction>();
+                     auto no_abi = [](const account_name&) -> fc::optional<abi_serializer> { return fc::optional<abi_serializer>(); };
+                     try {
+                        abi_serializer::from_variant(vo, *ptrx, no_abi, checks.abi_serializer_max_time);
+                     } EOS_RETHROW_EXCEPTIONS(chain::packed_transaction_type_exception, "Invalid packed transaction")
+                  }
+                  auto trx = std::make_shared<transaction_metadata>(ptrx);
+                  batch->trxs[i] = trx;
+                  checks.validate(*ptrx);
+                  trx->recover_keys(checks.chain_id, checks.max_recovery_time);
+               } CATCH_AND_CALL(store);
+            }
+
+            if( --batch->pending_checks == 0 ) {
+               app().post(priority::low, [this, batch]() {
+                  push_checked_transactions(batch);
+               });
+            }
+         });
+      }
+   } CATCH_AND_CALL(next);
 }
 
-void chain_plugin_impl::push_transactions(const push_transactions_params& params, next_function<push_transactions_results> next) {
-   try {
-      EOS_ASSERT( params.size() <= 1000, too_many_tx_at_once, "Attempt to push too many transactions at once" );
-      auto params_copy = std::make_shared<push_transactions_params>(params.begin(), params.end());
-      auto result = std::make_shared<push_transactions_results>();
-      result->reserve(params.size());
+void chain_plugin_impl::push_checked_transactions(const std::shared_ptr<push_batch>& batch) {
+   auto complete = [batch](size_t i, const fc::exception_ptr& e) {
+      const auto& trx = batch->trxs[i];
+      batch->results[i] = push_transaction_results{
+         trx ? trx->id : transaction_id_type(), fc::mutable_variant_object( "error", e->to_detail_string() ) };
+      if( --batch->pending_results == 0 ) {
+         batch->next(std::move(batch->results));
+      }
+   };
 
-      push_recurse(this, 0, params_copy, result, next);
+   std::vector<std::pair<transaction_metadata_ptr, next_function<transaction_trace_ptr>>> queue;
+   std::vector<size_t> queued;
+   queue.reserve(batch->trxs.size());
+   queued.reserve(batch->trxs.size());
+   for( size_t i = 0; i < batch->trxs.size(); ++i ) {
+      if( !batch->errors[i] && !chain->skip_trx_checks() ) {
+         // TaPoS is checked here because it reads the block summary from the chaindb
+         auto store = [&](const fc::exception_ptr& e) { batch->errors[i] = e; };
+         try {
+            chain->validate_tapos(batch->trxs[i]->packed_trx->get_signed_transaction());
+         } CATCH_AND_CALL(store);
+      }
+      if( batch->errors[i] ) {
+         complete(i, batch->errors[i]);
+         continue;
+      }
 
-   } CATCH_AND_CALL(next);
+      queued.push_back(i);
+      queue.emplace_back(batch->trxs[i], [this, batch, i, complete](const fc::static_variant<fc::exception_ptr, transaction_trace_ptr>& result) {
+         if( result.contains<fc::exception_ptr>() ) {
+            complete(i, result.get<fc::exception_ptr>());
+            return;
+         }
+
+         const auto& trx_trace_ptr = result.get<transaction_trace_ptr>();
+         auto store = [&](const fc::exception_ptr& e) { complete(i, e); };
+         try {
+            fc::variant output;
+            try {
+               output = chain->to_variant_with_abi( *trx_trace_ptr, abi_serializer_max_time_ms );
+            } catch( chain::abi_exception& ) {
+               output = *trx_trace_ptr;
+            }
+
+            batch->results[i] = push_transaction_results{trx_trace_ptr->id, output};
+            if( --batch->pending_results == 0 ) {
+               batch->next(std::move(batch->results));
+            }
+         } CATCH_AND_CALL(store);
+      });
+   }
+
+   if( !queue.empty() ) {
+      auto fail = [&](const fc::exception_ptr& e) {
+         for( auto i : queued ) complete(i, e);
+      };
+      try {
+         incoming_transaction_batch_async_method(queue, true);
+      } CATCH_AND_CALL(fail);
+   }
 }
 
 void chain_plugin_impl::validate() const {
@@ -394,10 +585,26 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
    cfg.add_options()
          ("blocks-dir", bpo::value<bfs::path>()->default_value("blocks"),
           "the location of the blocks directory (absolute path or relative to application data dir)")
+         ("blocks-log-segment-size", bpo::value<uint32_t>()->default_value(0),
+          "Number of blocks in a closed segment of the block log (0 - keep all blocks in one file)")
+         ("blocks-log-compression", bpo::bool_switch()->default_value(false),
+          "Compress closed segments of the block log in background (requires blocks-log-segment-size)")
+         ("blocks-log-chunk-size", bpo::value<uint32_t>()->default_value(block_log_config().blocks_per_chunk),
+          "Number of blocks in an independently compressed chunk of the block log")
+         ("blocks-log-retained-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Remove closed segments of the block log which contain only blocks older than this number of blocks (0 - keep all blocks)")
+         ("blocks-archive-dir", bpo::value<bfs::path>(),
+          "the location of the directory to move closed segments of the block log to (absolute path or relative to application data dir)")
          ("checkpoint", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("wasm-runtime", bpo::value<eosio::chain::wasm_interface::vm_type>()->value_name("wavm/wabt"), "Override default WASM runtime")
          ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_ms),
           "Override default maximum ABI serialization time allowed in ms")
+         ("abi-registry-size-mb", bpo::value<uint32_t>()->default_value(16),
+          "Maximum size (in MiB) of serialized ABIs whose parsed form is kept in memory after the first access to a contract (0 - disable)")
+         ("api-cache-endpoint", bpo::value<vector<string>>()->composing(),
+          "URL of a read-only chain API endpoint (e.g. /v1/chain/get_account) whose responses are cached until the next block, can be specified multiple times")
+         ("api-cache-size-mb", bpo::value<uint32_t>()->default_value(64),
+          "Maximum size (in MiB) of cached chain API responses")
          ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024  * 1024)), "Maximum size (in MiB) of the chain state database")
          ("chain-state-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the chain state database drops below this size (in MiB).")
          ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024  * 1024)), "Maximum size (in MiB) of the reversible blocks database")
@@ -427,6 +634,20 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Connection address to chaindb")
          ("chaindb_sys_name", bpo::value<string>()->default_value("_CYBERWAY_"),
           "Prefix for database names")
+         ("cache-system-budget-mb", bpo::value<uint64_t>()->default_value(0),
+          "Budget of the chaindb cache for tables of the system contract except stake and resource tables (0 - only the common RAM limit is applied)")
+         ("cache-stake-budget-mb", bpo::value<uint64_t>()->default_value(0),
+          "Budget of the chaindb cache for stake and resource tables (0 - only the common RAM limit is applied)")
+         ("cache-contract-budget-mb", bpo::value<uint64_t>()->default_value(0),
+          "Default budget of the chaindb cache for tables of each contract (0 - only the common RAM limit is applied)")
+         ("cache-contract-budget", bpo::value<vector<string>>()->composing()->multitoken(),
+          "Budget of the chaindb cache for tables of the contract as account:size-in-mb, overrides cache-contract-budget-mb (may specify multiple times)")
+         ("chaindb-resident-table", bpo::value<vector<string>>()->composing()->multitoken(),
+          "Table as code:table which is kept in RAM by the chaindb driver, so reading of it doesn't touch the database, e.g. :permission for the permission table of the chain, its index fields should be of integer, name, symbol, string, bool or time types (may specify multiple times)")
+         ("cache-manifest-rows", bpo::value<uint32_t>()->default_value(config::default_cache_manifest_rows),
+          "Number of the most recently used rows of the chaindb cache which are saved to the manifest and loaded to the cache on startup (0 - disable warm-up)")
+         ("cache-manifest-interval", bpo::value<uint32_t>()->default_value(config::default_cache_manifest_interval),
+          "Number of blocks between saves of the chaindb cache manifest (0 - save only on shutdown)")
          ("genesis-data", bpo::value<bfs::path>(),
           "The location of the Genesis state file (absolute path or relative to the current directory)")
          ("trusted-producer", bpo::value<vector<string>>()->composing(),
@@ -466,6 +687,13 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "clear chain state database and block log")
          ("truncate-at-block", bpo::value<uint32_t>()->default_value(0),
           "stop hard replay / block log recovery at this block number (if set to non-zero number)")
+         ("replay-profile-file", bpo::value<bfs::path>(),
+          "profile the replay and write per-block phase timings and per-action histograms to this JSON file, "
+          "nodeos exits after the replay (requires --replay-blockchain, --hard-replay-blockchain or --snapshot)")
+         ("replay-profile-first-block", bpo::value<uint32_t>()->default_value(0),
+          "first block to profile, earlier blocks are replayed without profiling")
+         ("replay-profile-last-block", bpo::value<uint32_t>()->default_value(0),
+          "last block to profile, the replay stops after it (if set to non-zero number)")
          ("import-reversible-blocks", bpo::value<bfs::path>(),
           "replace reversible block database with blocks imported from specified file and then exit")
          ("export-reversible-blocks", bpo::value<bfs::path>(),
@@ -581,7 +809,39 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->chain_config->abi_serializer_max_time_ms = my->abi_serializer_max_time_ms;
       }
 
+      if( options.count("abi-registry-size-mb") ) {
+         cyberway::chaindb::abi_registry::instance().set_max_size(
+            size_t(options.at("abi-registry-size-mb").as<uint32_t>()) * 1024 * 1024);
+      }
+
+      if( options.count("api-cache-size-mb") ) {
+         my->api_cache.set_max_size(size_t(options.at("api-cache-size-mb").as<uint32_t>()) * 1024 * 1024);
+      }
+
+      if( options.count("api-cache-endpoint") ) {
+         for( const auto& url: options.at("api-cache-endpoint").as<vector<string>>() ) {
+            my->api_cache.enable(url);
+         }
+      }
+
       my->chain_config->blocks_dir = my->blocks_dir;
+      my->chain_config->blocks_log.segment_size = options.at( "blocks-log-segment-size" ).as<uint32_t>();
+      my->chain_config->blocks_log.compression = options.at( "blocks-log-compression" ).as<bool>();
+      my->chain_config->blocks_log.blocks_per_chunk = options.at( "blocks-log-chunk-size" ).as<uint32_t>();
+      EOS_ASSERT( !my->chain_config->blocks_log.compression || my->chain_config->blocks_log.segment_size > 0,
+                  plugin_config_exception, "blocks-log-compression requires blocks-log-segment-size" );
+      EOS_ASSERT( my->chain_config->blocks_log.blocks_per_chunk > 0, plugin_config_exception,
+                  "blocks-log-chunk-size must be greater than 0" );
+      my->chain_config->blocks_log.retained_blocks = options.at( "blocks-log-retained-blocks" ).as<uint32_t>();
+      if( options.count( "blocks-archive-dir" )) {
+         auto bad = options.at( "blocks-archive-dir" ).as<bfs::path>();
+         if( bad.is_relative())
+            my->chain_config->blocks_log.archive_dir = app().data_dir() / bad;
+         else
+            my->chain_config->blocks_log.archive_dir = bad;
+      }
+      EOS_ASSERT( my->chain_config->blocks_log.segment_size > 0 || my->chain_config->blocks_log.retained_blocks == 0,
+                  plugin_config_exception, "blocks-log-retained-blocks requires blocks-log-segment-size" );
       my->chain_config->state_dir = app().data_dir() / config::default_state_dir_name;
       my->chain_config->read_only = my->readonly;
 
@@ -604,6 +864,9 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                      "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size) );
       }
 
+      my->chain_config->cache_manifest_rows = options.at( "cache-manifest-rows" ).as<uint32_t>();
+      my->chain_config->cache_manifest_interval = options.at( "cache-manifest-interval" ).as<uint32_t>();
+
       my->chain_config->sig_cpu_bill_pct = options.at("signature-cpu-billable-pct").as<uint32_t>();
       EOS_ASSERT( my->chain_config->sig_cpu_bill_pct >= 0 && my->chain_config->sig_cpu_bill_pct <= 100, plugin_config_exception,
                   "signature-cpu-billable-pct must be 0 - 100, ${pct}", ("pct", my->chain_config->sig_cpu_bill_pct) );
@@ -734,6 +997,25 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          wlog("The --import-reversible-blocks option should be used by itself.");
       }
 
+      if( options.count( "replay-profile-file" )) {
+         EOS_ASSERT( options.at( "replay-blockchain" ).as<bool>() || options.at( "hard-replay-blockchain" ).as<bool>() ||
+                     options.count( "snapshot" ), plugin_config_exception,
+                     "--replay-profile-file requires --replay-blockchain, --hard-replay-blockchain or --snapshot" );
+
+         auto p = options.at( "replay-profile-file" ).as<bfs::path>();
+         if( p.is_relative()) {
+            p = bfs::current_path() / p;
+         }
+         my->chain_config->replay_profile_file = p;
+         my->chain_config->replay_profile_first_block = options.at( "replay-profile-first-block" ).as<uint32_t>();
+         my->chain_config->replay_profile_last_block = options.at( "replay-profile-last-block" ).as<uint32_t>();
+
+         EOS_ASSERT( !my->chain_config->replay_profile_last_block ||
+                     my->chain_config->replay_profile_first_block <= my->chain_config->replay_profile_last_block,
+                     plugin_config_exception,
+                     "--replay-profile-first-block should not be greater than --replay-profile-last-block" );
+      }
+
       if (options.count( "snapshot" )) {
 
          my->snapshot_path = options.at( "snapshot" ).as<bfs::path>();
@@ -747,8 +1029,9 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                         "--snapshot is incompatible with --genesis-json and --genesis-timestamp as the snapshot contains genesis information");
 
          auto forkdb_path = my->chain_config->state_dir / config::forkdb_filename;
+         auto forkdb_log_path = my->chain_config->state_dir / config::forkdb_log_filename;
 
-         EOS_ASSERT( !fc::exists(forkdb_path ),
+         EOS_ASSERT( !fc::exists(forkdb_path) && !fc::exists(forkdb_log_path),
             plugin_config_exception,
             "Snapshot can only be used to initialize an empty database." );
 
@@ -838,6 +1121,37 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       }
       my->chain.emplace( *my->chain_config );
 
+      {
+         cyberway::chaindb::cache_budget_config budgets;
+         budgets.system_size   = options.at( "cache-system-budget-mb" ).as<uint64_t>() * 1024 * 1024;
+         budgets.stake_size    = options.at( "cache-stake-budget-mb" ).as<uint64_t>() * 1024 * 1024;
+         budgets.contract_size = options.at( "cache-contract-budget-mb" ).as<uint64_t>() * 1024 * 1024;
+
+         if( options.count( "cache-contract-budget" )) {
+            for( const auto& budget: options.at( "cache-contract-budget" ).as<vector<string>>() ) {
+               auto pos = budget.find( ':' );
+               EOS_ASSERT( pos != string::npos, plugin_config_exception,
+                           "Invalid cache-contract-budget '${budget}', expected account:size-in-mb", ("budget", budget) );
+               auto code = account_name( budget.substr( 0, pos ) );
+               budgets.contract_sizes[code.value] = std::stoull( budget.substr( pos + 1 ) ) * 1024 * 1024;
+            }
+         }
+
+         my->chain->chaindb().get_cache_map().set_budgets( std::move(budgets) );
+      }
+
+      if( options.count( "chaindb-resident-table" )) {
+         cyberway::chaindb::resident_table_set tables;
+         for( const auto& table: options.at( "chaindb-resident-table" ).as<vector<string>>() ) {
+            auto pos = table.find( ':' );
+            EOS_ASSERT( pos != string::npos, plugin_config_exception,
+                        "Invalid chaindb-resident-table '${table}', expected code:table", ("table", table) );
+            tables.emplace( account_name( table.substr( 0, pos ) ).value, table_name( table.substr( pos + 1 ) ).value );
+         }
+
+         my->chain->chaindb().get_driver().set_resident_tables( std::move(tables) );
+      }
+
       if ( options.at("skip-bad-blocks-check").as<bool>() ) {
          my->chain->skip_bad_blocks_check();
       }
@@ -882,6 +1196,7 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
             } );
 
       my->accepted_block_connection = my->chain->accepted_block.connect( [this]( const block_state_ptr& blk ) {
+         my->api_cache.invalidate();
          my->accepted_block_channel.publish( priority::high, blk );
       } );
 
@@ -896,6 +1211,10 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
       my->applied_transaction_connection = my->chain->applied_transaction.connect(
             [this]( const transaction_trace_ptr& trace ) {
+               // speculative state is visible to the API, so cached responses are stale after each transaction
+               if( my->chain->get_read_mode() == db_read_mode::SPECULATIVE ) {
+                  my->api_cache.invalidate();
+               }
                my->applied_transaction_channel.publish( priority::low, trace );
             } );
 
@@ -910,10 +1229,14 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 void chain_plugin::init_request_handler() {
     auto& http_plugin = app().get_plugin<eosio::http_plugin>();
 
-    http_plugin.add_api({
+    // only read-only endpoints can go through the response cache
+    http_plugin.add_api(my->api_cache.wrap({
         CREATE_READ_HANDLER((*my), get_info, 200),
         CREATE_READ_HANDLER((*my), get_block, 200),
-        CREATE_READ_HANDLER((*my), get_block_header_state, 200),
+        CREATE_READ_HANDLER((*my), get_block_header_state, 200)
+    }));
+
+    http_plugin.add_api({
         CREATE_WRIGHT_HANDLER((*my), push_block, push_block_results, 202),
         CREATE_WRIGHT_HANDLER((*my), push_transaction, push_transaction_results, 202),
         CREATE_WRIGHT_HANDLER((*my), push_transactions, push_transactions_results, 202)
@@ -932,7 +1255,14 @@ void chain_plugin::plugin_startup()
          auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
 
          auto reader = std::make_unique<istream_snapshot_reader>(infile);
-         my->chain->startup(shutdown, std::move(reader));
+         try {
+            my->chain->startup(shutdown, std::move(reader));
+         } catch (...) {
+            // the fork database written by the failed start would reject the retry as a non-empty database
+            my->chain->fork_db().close();
+            fc::remove(my->chain_config->state_dir / config::forkdb_log_filename);
+            throw;
+         }
 
          infile.close();
       } else {
@@ -942,6 +1272,11 @@ void chain_plugin::plugin_startup()
       my->chain_id.emplace( my->chain->get_chain_id());
       ilog("Chain_plugin received chain_id: ${id}", ("id", my->chain_id->str()));
 
+      if (!my->chain_config->replay_profile_file.empty()) {
+         ilog("replay profiling is finished, exiting");
+         app().quit();
+      }
+
       if (my->revert_to_lib) {
          auto lib = std::max(my->chain->last_irreversible_block_num(), uint32_t(1));
          ilog("revert chain from block ${head} to ${lib}", ("head", my->chain->head_block_num())("lib", lib));
@@ -1209,6 +1544,10 @@ fc::microseconds chain_plugin::get_abi_serializer_max_time() const {
     return my->abi_serializer_max_time_ms;
 }
 
+response_cache& chain_plugin::get_response_cache() {
+    return my->api_cache;
+}
+
 void chain_plugin::log_guard_exception(const chain::guard_exception&e ) const {
    if (e.code() == chain::database_guard_exception::code_value) {
       elog("Shutting down to avoid corrupting the database. Fix problem and restart the process! Details: ${details}",
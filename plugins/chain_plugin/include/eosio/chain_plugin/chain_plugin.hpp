@@ -27,6 +27,7 @@
 #include <fc/static_variant.hpp>
 
 #include <eosio/http_plugin/http_plugin.hpp>
+#include <eosio/plugins_common/response_cache.hpp>
 
 namespace fc { class variant; }
 
@@ -75,6 +76,9 @@ public:
 
    fc::microseconds get_abi_serializer_max_time() const;
 
+   // responses of read-only API calls, shared by the chain API handlers
+   response_cache& get_response_cache();
+
    void handle_guard_exception(const chain::guard_exception& e) const;
 
    static void handle_db_exhaustion();
@@ -6,6 +6,9 @@
 #include <fc/io/json.hpp>
 #include <eosio/db_size_api_plugin/db_size_api_plugin.hpp>
 
+#include <cyberway/chaindb/controller.hpp>
+#include <cyberway/chaindb/cache_map.hpp>
+
 namespace eosio {
 
 static appbase::abstract_plugin& _db_size_api_plugin = app().register_plugin<db_size_api_plugin>();
@@ -36,16 +39,20 @@ void db_size_api_plugin::plugin_startup() {
 }
 
 db_size_stats db_size_api_plugin::get() {
-   const chainbase::database& db = app().get_plugin<chain_plugin>().chain().db();
+   const auto& cache = app().get_plugin<chain_plugin>().chain().chaindb().get_cache_map();
    db_size_stats ret;
 
-   ret.free_bytes = db.get_segment_manager()->get_free_memory();
-   ret.size = db.get_segment_manager()->get_size();
-   ret.used_bytes = ret.size - ret.free_bytes;
+   ret.cache_hits = cache.stats().hits;
+   ret.cache_misses = cache.stats().misses;
+
+   const auto usage = cache.usage();
+   ret.size = usage.limit;
+   ret.used_bytes = usage.used;
+   ret.free_bytes = usage.limit > usage.used ? usage.limit - usage.used : 0;
 
-   chainbase::database::database_index_row_count_multiset indices = db.row_count_per_index();
-   for(const auto& i : indices)
-      ret.indices.emplace_back(db_size_index_count{i.second, i.first});
+   for(const auto& b : usage.budgets) {
+      ret.budgets.emplace_back(db_size_cache_budget{b.budget, account_name(b.code), b.limit, b.used, b.evicted_rows});
+   }
 
    return ret;
 }
@@ -13,16 +13,22 @@ namespace eosio {
 
 using namespace appbase;
 
-struct db_size_index_count {
-   string   index;
-   uint64_t row_count;
+struct db_size_cache_budget {
+   string       budget;  ///< system, stake or contract
+   account_name code;    ///< for budgets of contracts
+   uint64_t     limit;   ///< 0 - only the common limit is applied
+   uint64_t     used_bytes;
+   uint64_t     evicted_rows;
 };
 
+/// usage of the chaindb cache
 struct db_size_stats {
-   uint64_t                    free_bytes;
-   uint64_t                    used_bytes;
-   uint64_t                    size;
-   vector<db_size_index_count> indices;
+   uint64_t                     free_bytes;
+   uint64_t                     used_bytes;
+   uint64_t                     size;
+   uint64_t                     cache_hits;
+   uint64_t                     cache_misses;
+   vector<db_size_cache_budget> budgets;
 };
 
 class db_size_api_plugin : public plugin<db_size_api_plugin> {
@@ -48,5 +54,5 @@ private:
 
 }
 
-FC_REFLECT( eosio::db_size_index_count, (index)(row_count) )
-FC_REFLECT( eosio::db_size_stats, (free_bytes)(used_bytes)(size)(indices) )
\ No newline at end of file
+FC_REFLECT( eosio::db_size_cache_budget, (budget)(code)(limit)(used_bytes)(evicted_rows) )
+FC_REFLECT( eosio::db_size_stats, (free_bytes)(used_bytes)(size)(cache_hits)(cache_misses)(budgets) )
\ No newline at end of file
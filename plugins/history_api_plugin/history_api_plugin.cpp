@@ -25,7 +25,7 @@ void history_api_plugin::plugin_initialize(const variables_map&) {}
           try { \
              if (body.empty()) body = "{}"; \
              auto result = api_handle.call_name(fc::json::from_string(body).as<api_namespace::call_name ## _params>()); \
-             cb(200, fc::json::to_string(result)); \
+             http_plugin::send_response(200, result, cb); \
           } catch (...) { \
              http_plugin::handle_exception(#api_name, #call_name, body, cb); \
           } \
@@ -25,6 +25,8 @@
 #include <thread>
 #include <memory>
 #include <regex>
+#include <streambuf>
+#include <ostream>
 
 namespace eosio {
 
@@ -117,6 +119,46 @@ namespace eosio {
 
           static const long timeout_open_handshake = 0;
       };
+
+      /**
+       * Output buffer for JSON responses: the serializer writes into a fixed chunk
+       * which is appended to the response body each time it fills up.
+       */
+      class bounded_body_buffer : public std::streambuf {
+      public:
+         bounded_body_buffer( string& body, size_t limit )
+         : body(body), limit(limit) {
+            setp( chunk, chunk + sizeof(chunk) );
+         }
+
+      protected:
+         int_type overflow( int_type ch ) override {
+            flush_chunk();
+            if( !traits_type::eq_int_type( ch, traits_type::eof() ) ) {
+               *pptr() = traits_type::to_char_type( ch );
+               pbump( 1 );
+            }
+            return traits_type::not_eof( ch );
+         }
+
+         int sync() override {
+            flush_chunk();
+            return 0;
+         }
+
+      private:
+         void flush_chunk() {
+            size_t size = pptr() - pbase();
+            EOS_ASSERT( !limit || body.size() + size <= limit, chain::http_response_too_large,
+                        "Response exceeds the limit of ${limit} bytes", ("limit", limit) );
+            body.append( pbase(), size );
+            setp( chunk, chunk + sizeof(chunk) );
+         }
+
+         string&      body;
+         const size_t limit;
+         char         chunk[4096];
+      };
    }
 
    using websocket_server_type = websocketpp::server<detail::asio_with_stub_log<websocketpp::transport::asio::basic_socket::endpoint>>;
@@ -126,6 +168,7 @@ namespace eosio {
    using io_work_t = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
 
    static bool verbose_http_errors = false;
+   static size_t max_response_body_size = 0;
 
    class http_plugin_impl {
       public:
@@ -420,6 +463,8 @@ namespace eosio {
              "Specify if Access-Control-Allow-Credentials: true should be returned on each request.")
             ("max-body-size", bpo::value<uint32_t>()->default_value(1024*1024),
              "The maximum body size in bytes allowed for incoming RPC requests")
+            ("max-response-body-size", bpo::value<uint32_t>()->default_value(64*1024*1024),
+             "The maximum body size in bytes of RPC responses, serialization is aborted once it is exceeded; 0 for no limit")
             ("http-max-bytes-in-flight-mb", bpo::value<uint32_t>()->default_value(500),
              "Maximum size in megabytes http_plugin should use for processing http requests. 503 error response when exceeded." )
             ("verbose-http-errors", bpo::bool_switch()->default_value(false),
@@ -502,6 +547,7 @@ namespace eosio {
          }
 
          my->max_body_size = options.at( "max-body-size" ).as<uint32_t>();
+         max_response_body_size = options.at( "max-response-body-size" ).as<uint32_t>();
          verbose_http_errors = options.at( "verbose-http-errors" ).as<bool>();
 
          my->thread_pool_size = options.at( "http-threads" ).as<uint16_t>();
@@ -633,6 +679,11 @@ namespace eosio {
          } catch (chain::unsatisfied_authorization& e) {
             error_results results{401, "UnAuthorized", error_results::error_info(e, verbose_http_errors)};
             cb( 401, fc::json::to_string( results ));
+         } catch (chain::http_response_too_large& e) {
+            error_results results{400, "Response Too Large", error_results::error_info(e, verbose_http_errors)};
+            cb( 400, fc::json::to_string( results ));
+            elog( "Response of ${api}.${call} exceeds the limit of ${limit} bytes",
+                  ("api", api_name)( "call", call_name )( "limit", max_response_body_size ));
          } catch (chain::tx_duplicate& e) {
             error_results results{409, "Conflict", error_results::error_info(e, verbose_http_errors)};
             cb( 409, fc::json::to_string( results ));
@@ -665,6 +716,19 @@ namespace eosio {
       }
    }
 
+   void http_plugin::send_response( int code, const fc::variant& result, url_response_callback& cb ) {
+      string body;
+      {
+         detail::bounded_body_buffer buffer( body, max_response_body_size );
+         std::ostream out( &buffer );
+         // rethrow http_response_too_large from the buffer instead of just setting badbit
+         out.exceptions( std::ios::badbit );
+         fc::json::to_stream( out, result, fc::json::default_generator );
+         out.flush();
+      }
+      cb( code, std::move( body ));
+   }
+
    bool http_plugin::is_on_loopback() const {
       return (!my->listen_endpoint || my->listen_endpoint->address().is_loopback()) && (!my->https_listen_endpoint || my->https_listen_endpoint->address().is_loopback());
    }
@@ -5,6 +5,7 @@
 #pragma once
 #include <appbase/application.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/variant.hpp>
 
 #include <fc/reflect/reflect.hpp>
 
@@ -89,6 +90,20 @@ namespace eosio {
         // standard exception handling for api handlers
         static void handle_exception( const char *api_name, const char *call_name, const string& body, url_response_callback cb );
 
+        /**
+         * Serializes the result as JSON straight into the response body and passes it to the callback.
+         * The body is written in chunks and the max-response-body-size limit is checked after each one,
+         * so an oversized response fails with http_response_too_large without being fully rendered.
+         * The result itself is still a complete fc::variant built by the caller, and the body is sent
+         * with Content-Length, so the peak memory of a large response isn't reduced by this.
+         */
+        static void send_response( int code, const fc::variant& result, url_response_callback& cb );
+
+        template<typename T>
+        static void send_response( int code, const T& result, url_response_callback& cb ) {
+           send_response( code, fc::variant( result ), cb );
+        }
+
         bool is_on_loopback() const;
         bool is_secure() const;
 
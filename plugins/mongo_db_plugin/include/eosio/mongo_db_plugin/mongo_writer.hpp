@@ -0,0 +1,115 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+
+#include <bsoncxx/document/value.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace eosio {
+
+enum class mongo_collection: uint8_t {
+   block_states,
+   blocks,
+   trans,
+   trans_traces,
+   action_traces,
+   accounts,
+   pub_keys,
+   account_controls,
+   count
+};
+
+/**
+ * Executes write operations on a group of collections in its own thread.
+ *
+ * Operations are executed in the order of pushing by the executor which is made in the writer thread.
+ * When the executor can't keep up, operations above the in-memory limit are spilled to a file used as
+ * a ring buffer, the pushing thread is blocked only while the spilled operations don't leave room for
+ * the next one. An exception of the executor stops the writer, push() and wait_idle() throw after it.
+ */
+class mongo_writer {
+public:
+   enum class op_kind: uint8_t {
+      insert,
+      update,
+      upsert,
+      remove
+   };
+
+   struct operation {
+      op_kind                  kind;
+      mongo_collection         collection;
+      bsoncxx::document::value filter;
+      bsoncxx::document::value doc;
+   };
+
+   /// executes all given operations
+   using executor = std::function<void( std::deque<operation>& )>;
+
+   static operation insert_op( mongo_collection, bsoncxx::document::value doc );
+   static operation update_op( mongo_collection, bsoncxx::document::value filter, bsoncxx::document::value update,
+                               bool upsert );
+   static operation remove_op( mongo_collection, bsoncxx::document::value filter );
+
+   explicit mongo_writer( std::string name );
+   ~mongo_writer();
+
+   /// @param make_executor is called in the writer thread before executing any operation
+   void start( std::function<executor()> make_executor, size_t max_queue_size,
+               const boost::filesystem::path& spill_dir, uint64_t max_spill_size );
+   /// executes all pushed operations and stops the thread
+   void stop();
+
+   /// @return number of the operation, operations are numbered from 1 in the order of pushing
+   uint64_t push( operation op );
+   /// waits until all pushed operations are executed
+   void wait_idle();
+   /// @return number of the executed operations, including the failed ones
+   uint64_t executed_ops() const { return executed; }
+
+private:
+   static constexpr size_t max_unspill_count = 1000;
+
+   void run( const std::function<executor()>& make_executor );
+
+   static uint64_t spill_size( const operation& op );
+   void spill( const operation& op, uint64_t size );
+   /// reads the given number of spilled operations, returns their size in the file
+   uint64_t unspill( std::deque<operation>& ops, size_t count );
+
+   const std::string name;
+   size_t            max_queue_size = 0;
+   uint64_t          max_spill_size = 0;
+
+   std::deque<operation>   queue;
+   boost::filesystem::path spill_path;
+   std::ofstream           spill_out;           // written by pushing thread under the lock
+   std::ifstream           spill_in;            // read by writer thread without the lock
+   uint64_t                spill_write_pos = 0;
+   uint64_t                spill_read_pos = 0;  // used only by writer thread
+   uint64_t                spill_used = 0;
+   size_t                  spilled_ops = 0;
+   uint64_t                pushed = 0;
+   std::atomic<uint64_t>   executed{0};
+
+   std::mutex              mtx;
+   std::condition_variable condition;
+   std::thread             thread;
+   bool                    busy = false;
+   bool                    done = false;
+   bool                    failed = false;
+};
+
+} // namespace eosio
@@ -3,6 +3,7 @@
  *  @copyright defined in eos/LICENSE
  */
 #include <eosio/mongo_db_plugin/mongo_db_plugin.hpp>
+#include <eosio/mongo_db_plugin/mongo_writer.hpp>
 #include <eosio/chain/eosio_contract.hpp>
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
@@ -15,8 +16,11 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/chrono.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/signals2/connection.hpp>
 
+#include <array>
+#include <condition_variable>
 #include <queue>
 #include <thread>
 #include <mutex>
@@ -29,6 +33,7 @@
 #include <mongocxx/client.hpp>
 #include <mongocxx/instance.hpp>
 #include <mongocxx/pool.hpp>
+#include <mongocxx/exception/bulk_write_exception.hpp>
 #include <mongocxx/exception/operation_exception.hpp>
 #include <mongocxx/exception/logic_error.hpp>
 
@@ -48,6 +53,8 @@ using chain::packed_transaction;
 
 static appbase::abstract_plugin& _mongo_db_plugin = app().register_plugin<mongo_db_plugin>();
 
+namespace bfs = boost::filesystem;
+
 struct filter_entry {
    name receiver;
    name action;
@@ -89,14 +96,14 @@ public:
    void _process_accepted_block( const chain::block_state_ptr& );
    void process_irreversible_block(const chain::block_state_ptr&);
    void _process_irreversible_block(const chain::block_state_ptr&);
+   bsoncxx::document::value block_filter( uint32_t block_num, const std::string& block_id_str ) const;
 
    optional<abi_serializer> get_abi_serializer( account_name n );
    template<typename T> fc::variant to_variant_with_abi( const T& obj );
 
    void purge_abi_cache();
 
-   bool add_action_trace( mongocxx::bulk_write& bulk_action_traces, const chain::action_trace& atrace,
-                          const chain::transaction_trace_ptr& t,
+   void add_action_trace( const chain::action_trace& atrace, const chain::transaction_trace_ptr& t,
                           bool executed, const std::chrono::milliseconds& now,
                           bool& write_ttrace );
 
@@ -142,13 +149,19 @@ public:
 
    // consum thread
    mongocxx::collection _accounts;
-   mongocxx::collection _trans;
-   mongocxx::collection _trans_traces;
-   mongocxx::collection _action_traces;
-   mongocxx::collection _block_states;
-   mongocxx::collection _blocks;
-   mongocxx::collection _pub_keys;
-   mongocxx::collection _account_controls;
+
+   // writers, each collection is written by one of them
+   mongo_writer blocks_writer{"blocks"};             // blocks, block_states
+   mongo_writer trans_writer{"transactions"};        // transactions
+   mongo_writer traces_writer{"traces"};             // transaction_traces, action_traces
+   mongo_writer accounts_writer{"accounts"};         // accounts, pub_keys, account_controls
+
+   size_t writer_queue_size = 0;
+   bfs::path spill_dir;
+   uint64_t max_spill_size = 0;
+
+   // blocks pushed to blocks_writer and not yet irreversible
+   std::set<std::pair<uint32_t, block_id_type>> queued_blocks;
 
    size_t max_queue_size = 0;
    int queue_sleep_time = 0;
@@ -187,6 +200,14 @@ public:
 
    abi_cache_index_t abi_cache_index;
 
+   struct pending_abi {
+      uint64_t op_num = 0;   // number of the accounts_writer operation which writes the abi
+      abi_def  abi;
+   };
+
+   // abis set by the operations which can be not written yet, used instead of the ones read from mongodb
+   std::map<account_name, pending_abi> pending_abis;
+
    static const action_name newaccount;
    static const action_name setabi;
    static const action_name updateauth;
@@ -396,13 +417,6 @@ void mongo_db_plugin_impl::consume_blocks() {
       auto& mongo_conn = *mongo_client;
 
       _accounts = mongo_conn[db_name][accounts_col];
-      _trans = mongo_conn[db_name][trans_col];
-      _trans_traces = mongo_conn[db_name][trans_traces_col];
-      _action_traces = mongo_conn[db_name][action_traces_col];
-      _blocks = mongo_conn[db_name][blocks_col];
-      _block_states = mongo_conn[db_name][block_states_col];
-      _pub_keys = mongo_conn[db_name][pub_keys_col];
-      _account_controls = mongo_conn[db_name][account_controls_col];
 
       while (true) {
          std::unique_lock<std::mutex> lock(mtx);
@@ -513,19 +527,18 @@ void mongo_db_plugin_impl::consume_blocks() {
 
 namespace {
 
-auto find_account( mongocxx::collection& accounts, const account_name& name ) {
-   using bsoncxx::builder::basic::make_document;
-   using bsoncxx::builder::basic::kvp;
-   return accounts.find_one( make_document( kvp( "name", name.to_string())));
-}
-
-auto find_block( mongocxx::collection& blocks, const string& id ) {
-   using bsoncxx::builder::basic::make_document;
-   using bsoncxx::builder::basic::kvp;
-
-   mongocxx::options::find options;
-   options.projection( make_document( kvp( "_id", 1 )) ); // only return _id
-   return blocks.find_one( make_document( kvp( "block_id", id )), options);
+const std::string& collection_name( mongo_collection c ) {
+   static const std::array<std::string, size_t(mongo_collection::count)> names = {{
+      mongo_db_plugin_impl::block_states_col,
+      mongo_db_plugin_impl::blocks_col,
+      mongo_db_plugin_impl::trans_col,
+      mongo_db_plugin_impl::trans_traces_col,
+      mongo_db_plugin_impl::action_traces_col,
+      mongo_db_plugin_impl::accounts_col,
+      mongo_db_plugin_impl::pub_keys_col,
+      mongo_db_plugin_impl::account_controls_col
+   }};
+   return names.at( size_t( c ));
 }
 
 void handle_mongo_exception( const std::string& desc, int line_num ) {
@@ -580,6 +593,119 @@ bsoncxx::oid make_custom_oid() {
 
 } // anonymous namespace
 
+namespace {
+
+constexpr size_t max_bulk_size = 1000;
+
+bool same_fields( const bsoncxx::document::view& a, const bsoncxx::document::view& b ) {
+   auto ai = a.begin(), bi = b.begin();
+   for( ; ai != a.end() && bi != b.end(); ++ai, ++bi ) {
+      if( ai->key() != bi->key() ) return false;
+   }
+   return ai == a.end() && bi == b.end();
+}
+
+/// @return number of the first operations, which can be executed in any order
+size_t unordered_size( const std::deque<mongo_writer::operation>& ops ) {
+   const auto& first = ops.front();
+   if( first.kind == mongo_writer::op_kind::insert ) {
+      size_t size = 1;
+      for( ; size < ops.size() && size < max_bulk_size && ops[size].collection == first.collection &&
+             ops[size].kind == first.kind; ++size );
+      return size;
+   }
+
+   // all filters are equality matches, so filters on the same fields with different values select different documents
+   std::set<std::string> filters;
+   size_t size = 0;
+   for( ; size < ops.size() && size < max_bulk_size && ops[size].collection == first.collection &&
+          ops[size].kind == first.kind && same_fields( first.filter.view(), ops[size].filter.view() ); ++size ) {
+      const auto filter = ops[size].filter.view();
+      if( !filters.emplace( reinterpret_cast<const char*>( filter.data() ), filter.length() ).second ) break;
+   }
+   return size;
+}
+
+/// logs the failed operations of the bulk write, @return false if the failure isn't caused by them
+bool log_write_errors( const mongocxx::bulk_write_exception& e, const std::deque<mongo_writer::operation>& ops, size_t size ) {
+   if( !e.raw_server_error() ) return false;
+
+   const auto reply = e.raw_server_error()->view();
+   const auto concern_errors = reply["writeConcernErrors"];
+   if( concern_errors && concern_errors.type() == bsoncxx::type::k_array && !concern_errors.get_array().value.empty() ) {
+      return false;
+   }
+   const auto write_errors = reply["writeErrors"];
+   if( !write_errors || write_errors.type() != bsoncxx::type::k_array || write_errors.get_array().value.empty() ) {
+      return false;
+   }
+
+   const auto& collection = collection_name( ops.front().collection );
+   for( const auto& error : write_errors.get_array().value ) {
+      const auto err = error.get_document().view();
+      const auto index = size_t( err["index"].get_int32().value );
+      const auto message = err["errmsg"] ? err["errmsg"].get_utf8().value.to_string() : std::string();
+      elog( "mongo write to ${c} failed, code ${code}, ${what}", ("c", collection)("code", err["code"].get_int32().value)("what", message) );
+      if( index < size ) {
+         elog( "  filter: ${f}, doc: ${d}", ("f", bsoncxx::to_json( ops[index].filter.view() ))("d", bsoncxx::to_json( ops[index].doc.view() )) );
+      }
+   }
+   return true;
+}
+
+/// executes the operations in bulk writes, a failed operation doesn't stop others
+void execute_bulks( mongocxx::database& db, std::deque<mongo_writer::operation>& ops ) {
+   using op_kind = mongo_writer::op_kind;
+
+   while( !ops.empty() ) {
+      const auto collection = ops.front().collection;
+      const auto size = unordered_size( ops );
+
+      mongocxx::options::bulk_write bulk_opts;
+      bulk_opts.ordered( false );
+      auto bulk = db[collection_name( collection )].create_bulk_write( bulk_opts );
+
+      for( size_t i = 0; i < size; ++i ) {
+         auto& op = ops[i];
+         switch( op.kind ) {
+            case op_kind::insert:
+               bulk.append( mongocxx::model::insert_one{op.doc.view()} );
+               break;
+            case op_kind::update:
+            case op_kind::upsert: {
+               mongocxx::model::update_one update{op.filter.view(), op.doc.view()};
+               update.upsert( op.kind == op_kind::upsert );
+               bulk.append( update );
+               break;
+            }
+            case op_kind::remove:
+               bulk.append( mongocxx::model::delete_many{op.filter.view()} );
+               break;
+         }
+      }
+
+      try {
+         if( !bulk.execute() ) {
+            EOS_ASSERT( false, chain::mongo_db_insert_fail, "Bulk write to ${c} failed", ("c", collection_name( collection )) );
+         }
+      } catch( mongocxx::bulk_write_exception& e ) {
+         // the rest of the unordered bulk is written, only the failed operations are lost
+         if( !log_write_errors( e, ops, size ) ) {
+            handle_mongo_exception( "bulk write to " + collection_name( collection ), __LINE__ );
+         }
+      } catch( ... ) {
+         handle_mongo_exception( "bulk write to " + collection_name( collection ), __LINE__ );
+      }
+      ops.erase( ops.begin(), ops.begin() + size );
+   }
+}
+
+} // anonymous namespace
+
+////////////
+// mongo_db_plugin_impl
+////////////
+
 void mongo_db_plugin_impl::purge_abi_cache() {
    if( abi_cache_index.size() < abi_cache_size ) return;
 
@@ -606,69 +732,80 @@ optional<abi_serializer> mongo_db_plugin_impl::get_abi_serializer( account_name
             return itr->serializer;
          }
 
-         auto account = _accounts.find_one( make_document( kvp("name", n.to_string())) );
-         if(account) {
+         abi_def abi;
+         auto pending = pending_abis.find( n );
+         if( pending != pending_abis.end() && pending->second.op_num > accounts_writer.executed_ops() ) {
+            // the abi isn't written yet, so mongodb has the previous one
+            abi = pending->second.abi;
+         } else {
+            if( pending != pending_abis.end() ) {
+               pending_abis.erase( pending );
+            }
+            auto account = _accounts.find_one( make_document( kvp("name", n.to_string())) );
+            if( !account ) {
+               return optional<abi_serializer>();
+            }
             auto view = account->view();
-            abi_def abi;
-            if( view.find( "abi" ) != view.end()) {
-               try {
-                  abi = fc::json::from_string( bsoncxx::to_json( view["abi"].get_document())).as<abi_def>();
-               } catch (...) {
-                  ilog( "Unable to convert account abi to abi_def for ${n}", ( "n", n ));
-                  return optional<abi_serializer>();
-               }
+            if( view.find( "abi" ) == view.end()) {
+               return optional<abi_serializer>();
+            }
+            try {
+               abi = fc::json::from_string( bsoncxx::to_json( view["abi"].get_document())).as<abi_def>();
+            } catch (...) {
+               ilog( "Unable to convert account abi to abi_def for ${n}", ( "n", n ));
+               return optional<abi_serializer>();
+            }
+         }
 
-               purge_abi_cache(); // make room if necessary
-               abi_cache entry;
-               entry.account = n;
-               entry.last_accessed = fc::time_point::now();
-               abi_serializer abis;
-               if( n == chain::config::system_account_name ) {
-                  // redefine eosio setabi.abi from bytes to abi_def
-                  // Done so that abi is stored as abi_def in mongo instead of as bytes
-                  auto itr = std::find_if( abi.structs.begin(), abi.structs.end(),
-                                           []( const auto& s ) { return s.name == "setabi"; } );
-                  if( itr != abi.structs.end() ) {
-                     auto itr2 = std::find_if( itr->fields.begin(), itr->fields.end(),
-                                               []( const auto& f ) { return f.name == "abi"; } );
-                     if( itr2 != itr->fields.end() ) {
-                        if( itr2->type == "bytes" ) {
-                           itr2->type = "abi_def";
-                           // unpack setabi.abi as abi_def instead of as bytes
-                           abis.add_specialized_unpack_pack( "abi_def",
-                                 std::make_pair<abi_serializer::unpack_function, abi_serializer::pack_function>(
-                                       []( fc::datastream<const char*>& stream, bool is_array, bool is_optional ) -> fc::variant {
-                                          EOS_ASSERT( !is_array && !is_optional, chain::mongo_db_exception, "unexpected abi_def");
-                                          chain::bytes temp;
-                                          fc::raw::unpack( stream, temp );
-                                          return fc::variant( fc::raw::unpack<abi_def>( temp ) );
-                                       },
-                                       []( const fc::variant& var, fc::datastream<char*>& ds, bool is_array, bool is_optional ) {
-                                          EOS_ASSERT( false, chain::mongo_db_exception, "never called" );
-                                       }
-                                 ) );
-                        }
-                     }
+         purge_abi_cache(); // make room if necessary
+         abi_cache entry;
+         entry.account = n;
+         entry.last_accessed = fc::time_point::now();
+         abi_serializer abis;
+         if( n == chain::config::system_account_name ) {
+            // redefine eosio setabi.abi from bytes to abi_def
+            // Done so that abi is stored as abi_def in mongo instead of as bytes
+            auto itr = std::find_if( abi.structs.begin(), abi.structs.end(),
+                                     []( const auto& s ) { return s.name == "setabi"; } );
+            if( itr != abi.structs.end() ) {
+               auto itr2 = std::find_if( itr->fields.begin(), itr->fields.end(),
+                                         []( const auto& f ) { return f.name == "abi"; } );
+               if( itr2 != itr->fields.end() ) {
+                  if( itr2->type == "bytes" ) {
+                     itr2->type = "abi_def";
+                     // unpack setabi.abi as abi_def instead of as bytes
+                     abis.add_specialized_unpack_pack( "abi_def",
+                           std::make_pair<abi_serializer::unpack_function, abi_serializer::pack_function>(
+                                 []( fc::datastream<const char*>& stream, bool is_array, bool is_optional ) -> fc::variant {
+                                    EOS_ASSERT( !is_array && !is_optional, chain::mongo_db_exception, "unexpected abi_def");
+                                    chain::bytes temp;
+                                    fc::raw::unpack( stream, temp );
+                                    return fc::variant( fc::raw::unpack<abi_def>( temp ) );
+                                 },
+                                 []( const fc::variant& var, fc::datastream<char*>& ds, bool is_array, bool is_optional ) {
+                                    EOS_ASSERT( false, chain::mongo_db_exception, "never called" );
+                                 }
+                           ) );
                   }
                }
-               // mongo does not like empty json keys
-               // make abi_serializer use empty_name instead of "" for the action data
-               for( auto& s : abi.structs ) {
-                  if( s.name.empty() ) {
-                     s.name = "empty_struct_name";
-                  }
-                  for( auto& f : s.fields ) {
-                     if( f.name.empty() ) {
-                        f.name = "empty_field_name";
-                     }
-                  }
+            }
+         }
+         // mongo does not like empty json keys
+         // make abi_serializer use empty_name instead of "" for the action data
+         for( auto& s : abi.structs ) {
+            if( s.name.empty() ) {
+               s.name = "empty_struct_name";
+            }
+            for( auto& f : s.fields ) {
+               if( f.name.empty() ) {
+                  f.name = "empty_field_name";
                }
-               abis.set_abi( abi, abi_serializer_max_time );
-               entry.serializer.emplace( std::move( abis ) );
-               abi_cache_index.insert( entry );
-               return entry.serializer;
             }
          }
+         abis.set_abi( abi, abi_serializer_max_time );
+         entry.serializer.emplace( std::move( abis ) );
+         abi_cache_index.insert( entry );
+         return entry.serializer;
       } FC_CAPTURE_AND_LOG((n))
    }
    return optional<abi_serializer>();
@@ -805,22 +942,12 @@ void mongo_db_plugin_impl::_process_accepted_transaction( const chain::transacti
 
    trans_doc.append( kvp( "createdAt", b_date{now} ) );
 
-   try {
-      mongocxx::options::update update_opts{};
-      update_opts.upsert( true );
-      if( !_trans.update_one( make_document( kvp( "trx_id", trx_id_str ) ),
-                              make_document( kvp( "$set", trans_doc.view() ) ), update_opts ) ) {
-         EOS_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert trans ${id}", ("id", trx_id) );
-      }
-   } catch( ... ) {
-      handle_mongo_exception( "trans insert", __LINE__ );
-   }
-
+   trans_writer.push( mongo_writer::update_op( mongo_collection::trans, make_document( kvp( "trx_id", trx_id_str ) ),
+                                               make_document( kvp( "$set", trans_doc.view() ) ), true ) );
 }
 
-bool
-mongo_db_plugin_impl::add_action_trace( mongocxx::bulk_write& bulk_action_traces, const chain::action_trace& atrace,
-                                        const chain::transaction_trace_ptr& t,
+void
+mongo_db_plugin_impl::add_action_trace( const chain::action_trace& atrace, const chain::transaction_trace_ptr& t,
                                         bool executed, const std::chrono::milliseconds& now,
                                         bool& write_ttrace )
 {
@@ -831,7 +958,6 @@ mongo_db_plugin_impl::add_action_trace( mongocxx::bulk_write& bulk_action_traces
       update_account( atrace.act );
    }
 
-   bool added = false;
    const bool in_filter = (store_action_traces || store_transaction_traces) && start_block_reached &&
                     filter_include( atrace.receipt.receiver, atrace.act.name, atrace.act.authorization );
    write_ttrace |= in_filter;
@@ -863,16 +989,12 @@ mongo_db_plugin_impl::add_action_trace( mongocxx::bulk_write& bulk_action_traces
       }
       action_traces_doc.append( kvp( "createdAt", b_date{now} ) );
 
-      mongocxx::model::insert_one insert_op{action_traces_doc.view()};
-      bulk_action_traces.append( insert_op );
-      added = true;
+      traces_writer.push( mongo_writer::insert_op( mongo_collection::action_traces, action_traces_doc.extract() ) );
    }
 
    for( const auto& iline_atrace : atrace.inline_traces ) {
-      added |= add_action_trace( bulk_action_traces, iline_atrace, t, executed, now, write_ttrace );
+      add_action_trace( iline_atrace, t, executed, now, write_ttrace );
    }
-
-   return added;
 }
 
 
@@ -885,16 +1007,12 @@ void mongo_db_plugin_impl::_process_applied_transaction( const chain::transactio
    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
          std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
-   mongocxx::options::bulk_write bulk_opts;
-   bulk_opts.ordered(false);
-   mongocxx::bulk_write bulk_action_traces = _action_traces.create_bulk_write(bulk_opts);
-   bool write_atraces = false;
    bool write_ttrace = false; // filters apply to transaction_traces as well
    bool executed = t->receipt.valid() && t->receipt->status == chain::transaction_receipt_header::executed;
 
    for( const auto& atrace : t->action_traces ) {
       try {
-         write_atraces |= add_action_trace( bulk_action_traces, atrace, t, executed, now, write_ttrace );
+         add_action_trace( atrace, t, executed, now, write_ttrace );
       } catch(...) {
          handle_mongo_exception("add action traces", __LINE__);
       }
@@ -924,30 +1042,11 @@ void mongo_db_plugin_impl::_process_applied_transaction( const chain::transactio
          }
          trans_traces_doc.append( kvp( "createdAt", b_date{now} ) );
 
-         try {
-            if( !_trans_traces.insert_one( trans_traces_doc.view() ) ) {
-               EOS_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert trans ${id}", ("id", t->id) );
-            }
-         } catch( ... ) {
-            handle_mongo_exception( "trans_traces insert: " + json, __LINE__ );
-         }
+         traces_writer.push( mongo_writer::insert_op( mongo_collection::trans_traces, trans_traces_doc.extract() ) );
       } catch( ... ) {
          handle_mongo_exception( "trans_traces serialization: " + t->id.str(), __LINE__ );
       }
    }
-
-   // insert action_traces
-   if( write_atraces ) {
-      try {
-         if( !bulk_action_traces.execute() ) {
-            EOS_ASSERT( false, chain::mongo_db_insert_fail,
-                        "Bulk action traces insert failed for transaction trace: ${id}", ("id", t->id) );
-         }
-      } catch( ... ) {
-         handle_mongo_exception( "action traces insert", __LINE__ );
-      }
-   }
-
 }
 
 void mongo_db_plugin_impl::_process_accepted_block( const chain::block_state_ptr& bs ) {
@@ -956,9 +1055,6 @@ void mongo_db_plugin_impl::_process_accepted_block( const chain::block_state_ptr
    using bsoncxx::builder::basic::kvp;
    using bsoncxx::builder::basic::make_document;
 
-   mongocxx::options::update update_opts{};
-   update_opts.upsert( true );
-
    auto block_num = bs->block_num;
    if( block_num % 1000 == 0 )
       ilog( "block_num: ${b}", ("b", block_num) );
@@ -993,21 +1089,8 @@ void mongo_db_plugin_impl::_process_accepted_block( const chain::block_state_ptr
       }
       block_state_doc.append( kvp( "createdAt", b_date{now} ) );
 
-      try {
-         if( update_blocks_via_block_num ) {
-            if( !_block_states.update_one( make_document( kvp( "block_num", b_int32{static_cast<int32_t>(block_num)} ) ),
-                                           make_document( kvp( "$set", block_state_doc.view() ) ), update_opts ) ) {
-               EOS_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert block_state ${num}", ("num", block_num) );
-            }
-         } else {
-            if( !_block_states.update_one( make_document( kvp( "block_id", block_id_str ) ),
-                                           make_document( kvp( "$set", block_state_doc.view() ) ), update_opts ) ) {
-               EOS_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert block_state ${bid}", ("bid", block_id) );
-            }
-         }
-      } catch( ... ) {
-         handle_mongo_exception( "block_states insert: " + json, __LINE__ );
-      }
+      blocks_writer.push( mongo_writer::update_op( mongo_collection::block_states, block_filter( block_num, block_id_str ),
+                                                   make_document( kvp( "$set", block_state_doc.view() ) ), true ) );
    }
 
    if( store_blocks ) {
@@ -1033,24 +1116,25 @@ void mongo_db_plugin_impl::_process_accepted_block( const chain::block_state_ptr
       }
       block_doc.append( kvp( "createdAt", b_date{now} ) );
 
-      try {
-         if( update_blocks_via_block_num ) {
-            if( !_blocks.update_one( make_document( kvp( "block_num", b_int32{static_cast<int32_t>(block_num)} ) ),
-                                     make_document( kvp( "$set", block_doc.view() ) ), update_opts ) ) {
-               EOS_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert block ${num}", ("num", block_num) );
-            }
-         } else {
-            if( !_blocks.update_one( make_document( kvp( "block_id", block_id_str ) ),
-                                     make_document( kvp( "$set", block_doc.view() ) ), update_opts ) ) {
-               EOS_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert block ${bid}", ("bid", block_id) );
-            }
-         }
-      } catch( ... ) {
-         handle_mongo_exception( "blocks insert: " + json, __LINE__ );
-      }
+      blocks_writer.push( mongo_writer::update_op( mongo_collection::blocks, block_filter( block_num, block_id_str ),
+                                                   make_document( kvp( "$set", block_doc.view() ) ), true ) );
+   }
+
+   if( store_blocks || store_block_states ) {
+      queued_blocks.emplace( block_num, block_id );
    }
 }
 
+bsoncxx::document::value mongo_db_plugin_impl::block_filter( uint32_t block_num, const std::string& block_id_str ) const {
+   using bsoncxx::builder::basic::kvp;
+   using bsoncxx::builder::basic::make_document;
+
+   if( update_blocks_via_block_num ) {
+      return make_document( kvp( "block_num", bsoncxx::types::b_int32{static_cast<int32_t>(block_num)} ) );
+   }
+   return make_document( kvp( "block_id", block_id_str ) );
+}
+
 void mongo_db_plugin_impl::_process_irreversible_block(const chain::block_state_ptr& bs)
 {
    using namespace bsoncxx::types;
@@ -1065,43 +1149,33 @@ void mongo_db_plugin_impl::_process_irreversible_block(const chain::block_state_
    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
          std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
-   if( store_blocks ) {
-      auto ir_block = find_block( _blocks, block_id_str );
-      if( !ir_block ) {
+   const auto block_num = bs->block->block_num();
+
+   if( store_blocks || store_block_states ) {
+      // the block is written by the blocks writer before its update as they are executed in order
+      if( !queued_blocks.count( std::make_pair( block_num, block_id ) ) ) {
          _process_accepted_block( bs );
-         ir_block = find_block( _blocks, block_id_str );
-         if( !ir_block ) return; // should never happen
       }
+      queued_blocks.erase( queued_blocks.begin(), queued_blocks.lower_bound( std::make_pair( block_num + 1, block_id_type() ) ) );
+   }
 
-      auto update_doc = make_document( kvp( "$set", make_document( kvp( "irreversible", b_bool{true} ),
-                                                                   kvp( "validated", b_bool{bs->validated} ),
-                                                                   kvp( "updatedAt", b_date{now} ) ) ) );
+   auto make_update_doc = [&]() {
+      return make_document( kvp( "$set", make_document( kvp( "irreversible", b_bool{true} ),
+                                                        kvp( "validated", b_bool{bs->validated} ),
+                                                        kvp( "updatedAt", b_date{now} ) ) ) );
+   };
 
-      _blocks.update_one( make_document( kvp( "_id", ir_block->view()["_id"].get_oid() ) ), update_doc.view() );
+   if( store_blocks ) {
+      blocks_writer.push( mongo_writer::update_op( mongo_collection::blocks, make_document( kvp( "block_id", block_id_str ) ),
+                                                   make_update_doc(), false ) );
    }
 
    if( store_block_states ) {
-      auto ir_block = find_block( _block_states, block_id_str );
-      if( !ir_block ) {
-         _process_accepted_block( bs );
-         ir_block = find_block( _block_states, block_id_str );
-         if( !ir_block ) return; // should never happen
-      }
-
-      auto update_doc = make_document( kvp( "$set", make_document( kvp( "irreversible", b_bool{true} ),
-                                                                   kvp( "validated", b_bool{bs->validated} ),
-                                                                   kvp( "updatedAt", b_date{now} ) ) ) );
-
-      _block_states.update_one( make_document( kvp( "_id", ir_block->view()["_id"].get_oid() ) ), update_doc.view() );
+      blocks_writer.push( mongo_writer::update_op( mongo_collection::block_states, make_document( kvp( "block_id", block_id_str ) ),
+                                                   make_update_doc(), false ) );
    }
 
    if( store_transactions ) {
-      const auto block_num = bs->block->block_num();
-      bool transactions_in_block = false;
-      mongocxx::options::bulk_write bulk_opts;
-      bulk_opts.ordered( false );
-      auto bulk = _trans.create_bulk_write( bulk_opts );
-
       for( const auto& receipt : bs->block->transactions ) {
          string trx_id_str;
          if( receipt.trx.contains<packed_transaction>() ) {
@@ -1119,20 +1193,8 @@ void mongo_db_plugin_impl::_process_irreversible_block(const chain::block_state_
                                                                       kvp( "block_num", b_int32{static_cast<int32_t>(block_num)} ),
                                                                       kvp( "updatedAt", b_date{now} ) ) ) );
 
-         mongocxx::model::update_one update_op{make_document( kvp( "trx_id", trx_id_str ) ), update_doc.view()};
-         update_op.upsert( false );
-         bulk.append( update_op );
-         transactions_in_block = true;
-      }
-
-      if( transactions_in_block ) {
-         try {
-            if( !bulk.execute() ) {
-               EOS_ASSERT( false, chain::mongo_db_insert_fail, "Bulk transaction insert failed for block: ${bid}", ("bid", block_id) );
-            }
-         } catch( ... ) {
-            handle_mongo_exception( "bulk transaction insert", __LINE__ );
-         }
+         trans_writer.push( mongo_writer::update_op( mongo_collection::trans, make_document( kvp( "trx_id", trx_id_str ) ),
+                                                     std::move( update_doc ), false ) );
       }
    }
 }
@@ -1144,10 +1206,6 @@ void mongo_db_plugin_impl::add_pub_keys( const vector<chain::key_weight>& keys,
    using bsoncxx::builder::basic::make_document;
    using namespace bsoncxx::types;
 
-   if( keys.empty()) return;
-
-   mongocxx::bulk_write bulk = _pub_keys.create_bulk_write();
-
    for( const auto& pub_key_weight : keys ) {
       auto find_doc = bsoncxx::builder::basic::document();
 
@@ -1158,19 +1216,8 @@ void mongo_db_plugin_impl::add_pub_keys( const vector<chain::key_weight>& keys,
       auto update_doc = make_document( kvp( "$set", make_document( bsoncxx::builder::concatenate_doc{find_doc.view()},
                                                                    kvp( "createdAt", b_date{now} ))));
 
-      mongocxx::model::update_one insert_op{find_doc.view(), update_doc.view()};
-      insert_op.upsert(true);
-      bulk.append( insert_op );
-   }
-
-   try {
-      if( !bulk.execute()) {
-         EOS_ASSERT( false, chain::mongo_db_insert_fail,
-                     "Bulk pub_keys insert failed for account: ${a}, permission: ${p}",
-                     ("a", name)( "p", permission ));
-      }
-   } catch (...) {
-      handle_mongo_exception( "pub_keys insert", __LINE__ );
+      accounts_writer.push( mongo_writer::update_op( mongo_collection::pub_keys, find_doc.extract(),
+                                                     std::move( update_doc ), true ) );
    }
 }
 
@@ -1179,17 +1226,9 @@ void mongo_db_plugin_impl::remove_pub_keys( const account_name& name, const perm
    using bsoncxx::builder::basic::kvp;
    using bsoncxx::builder::basic::make_document;
 
-   try {
-      auto result = _pub_keys.delete_many( make_document( kvp( "account", name.to_string()),
-                                                         kvp( "permission", permission.to_string())));
-      if( !result ) {
-         EOS_ASSERT( false, chain::mongo_db_update_fail,
-                     "pub_keys delete failed for account: ${a}, permission: ${p}",
-                     ("a", name)( "p", permission ));
-      }
-   } catch (...) {
-      handle_mongo_exception( "pub_keys delete", __LINE__ );
-   }
+   accounts_writer.push( mongo_writer::remove_op( mongo_collection::pub_keys,
+                                                  make_document( kvp( "account", name.to_string()),
+                                                                 kvp( "permission", permission.to_string()))));
 }
 
 void mongo_db_plugin_impl::add_account_control( const vector<chain::permission_level_weight>& controlling_accounts,
@@ -1200,10 +1239,6 @@ void mongo_db_plugin_impl::add_account_control( const vector<chain::permission_l
    using bsoncxx::builder::basic::make_document;
    using namespace bsoncxx::types;
 
-   if( controlling_accounts.empty()) return;
-
-   mongocxx::bulk_write bulk = _account_controls.create_bulk_write();
-
    for( const auto& controlling_account : controlling_accounts ) {
       auto find_doc = bsoncxx::builder::basic::document();
 
@@ -1213,21 +1248,8 @@ void mongo_db_plugin_impl::add_account_control( const vector<chain::permission_l
 
       auto update_doc = make_document( kvp( "$set", make_document( bsoncxx::builder::concatenate_doc{find_doc.view()},
                                                                    kvp( "createdAt", b_date{now} ))));
-
-
-      mongocxx::model::update_one insert_op{find_doc.view(), update_doc.view()};
-      insert_op.upsert(true);
-      bulk.append( insert_op );
-   }
-
-   try {
-      if( !bulk.execute()) {
-         EOS_ASSERT( false, chain::mongo_db_insert_fail,
-                     "Bulk account_controls insert failed for account: ${a}, permission: ${p}",
-                     ("a", name)( "p", permission ));
-      }
-   } catch (...) {
-      handle_mongo_exception( "account_controls insert", __LINE__ );
+      accounts_writer.push( mongo_writer::update_op( mongo_collection::account_controls, find_doc.extract(),
+                                                     std::move( update_doc ), true ) );
    }
 }
 
@@ -1236,40 +1258,23 @@ void mongo_db_plugin_impl::remove_account_control( const account_name& name, con
    using bsoncxx::builder::basic::kvp;
    using bsoncxx::builder::basic::make_document;
 
-   try {
-      auto result = _account_controls.delete_many( make_document( kvp( "controlled_account", name.to_string()),
-                                                                  kvp( "controlled_permission", permission.to_string())));
-      if( !result ) {
-         EOS_ASSERT( false, chain::mongo_db_update_fail,
-                     "account_controls delete failed for account: ${a}, permission: ${p}",
-                     ("a", name)( "p", permission ));
-      }
-   } catch (...) {
-      handle_mongo_exception( "account_controls delete", __LINE__ );
-   }
+   accounts_writer.push( mongo_writer::remove_op( mongo_collection::account_controls,
+                                                  make_document( kvp( "controlled_account", name.to_string()),
+                                                                 kvp( "controlled_permission", permission.to_string()))));
 }
 
 namespace {
 
-void create_account( mongocxx::collection& accounts, const name& name, std::chrono::milliseconds& now ) {
+void create_account( mongo_writer& accounts, const name& name, std::chrono::milliseconds& now ) {
    using namespace bsoncxx::types;
    using bsoncxx::builder::basic::kvp;
    using bsoncxx::builder::basic::make_document;
 
-   mongocxx::options::update update_opts{};
-   update_opts.upsert( true );
-
    const string name_str = name.to_string();
-   auto update = make_document(
-         kvp( "$set", make_document( kvp( "name", name_str),
-                                     kvp( "createdAt", b_date{now} ))));
-   try {
-      if( !accounts.update_one( make_document( kvp( "name", name_str )), update.view(), update_opts )) {
-         EOS_ASSERT( false, chain::mongo_db_update_fail, "Failed to insert account ${n}", ("n", name));
-      }
-   } catch (...) {
-      handle_mongo_exception( "create_account", __LINE__ );
-   }
+   accounts.push( mongo_writer::update_op( mongo_collection::accounts, make_document( kvp( "name", name_str )),
+                                           make_document( kvp( "$set", make_document( kvp( "name", name_str),
+                                                                                      kvp( "createdAt", b_date{now} )))),
+                                           true ) );
 }
 
 }
@@ -1289,7 +1294,7 @@ void mongo_db_plugin_impl::update_account(const chain::action& act)
                std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()} );
          auto newacc = act.data_as<chain::newaccount>();
 
-         create_account( _accounts, newacc.name, now );
+         create_account( accounts_writer, newacc.name, now );
 
          add_pub_keys( newacc.owner.keys, newacc.name, owner, now );
          add_account_control( newacc.owner.accounts, newacc.name, owner, now );
@@ -1317,32 +1322,34 @@ void mongo_db_plugin_impl::update_account(const chain::action& act)
 
          abi_cache_index.erase( setabi.account );
 
-         auto account = find_account( _accounts, setabi.account );
-         if( !account ) {
-            create_account( _accounts, setabi.account, now );
-            account = find_account( _accounts, setabi.account );
-         }
-         if( account ) {
-            abi_def abi_def = fc::raw::unpack<chain::abi_def>( setabi.abi );
-            const string json_str = fc::json::to_string( abi_def );
-
-            try{
-               auto update_from = make_document(
-                     kvp( "$set", make_document( kvp( "abi", bsoncxx::from_json( json_str )),
-                                                 kvp( "updatedAt", b_date{now} ))));
-
-               try {
-                  if( !_accounts.update_one( make_document( kvp( "_id", account->view()["_id"].get_oid())),
-                                             update_from.view())) {
-                     EOS_ASSERT( false, chain::mongo_db_update_fail, "Failed to udpdate account ${n}", ("n", setabi.account));
-                  }
-               } catch( ... ) {
-                  handle_mongo_exception( "account update", __LINE__ );
+         abi_def abi_def = fc::raw::unpack<chain::abi_def>( setabi.abi );
+         const string json_str = fc::json::to_string( abi_def );
+         const string name_str = setabi.account.to_string();
+
+         try{
+            // creates the account if it doesn't exist
+            auto update_from = make_document(
+                  kvp( "$set", make_document( kvp( "name", name_str ),
+                                              kvp( "abi", bsoncxx::from_json( json_str )),
+                                              kvp( "updatedAt", b_date{now} ))),
+                  kvp( "$setOnInsert", make_document( kvp( "createdAt", b_date{now} ))));
+
+            const auto op_num = accounts_writer.push( mongo_writer::update_op( mongo_collection::accounts,
+                                                                               make_document( kvp( "name", name_str )),
+                                                                               std::move( update_from ), true ) );
+
+            const auto executed = accounts_writer.executed_ops();
+            for( auto itr = pending_abis.begin(); itr != pending_abis.end(); ) {
+               if( itr->second.op_num <= executed ) {
+                  itr = pending_abis.erase( itr );
+               } else {
+                  ++itr;
                }
-            } catch( bsoncxx::exception& e ) {
-               elog( "Unable to convert abi JSON to MongoDB JSON: ${e}", ("e", e.what()));
-               elog( "  JSON: ${j}", ("j", json_str));
             }
+            pending_abis[setabi.account] = pending_abi{op_num, std::move( abi_def )};
+         } catch( bsoncxx::exception& e ) {
+            elog( "Unable to convert abi JSON to MongoDB JSON: ${e}", ("e", e.what()));
+            elog( "  JSON: ${j}", ("j", json_str));
          }
       }
    } catch( fc::exception& e ) {
@@ -1363,6 +1370,11 @@ mongo_db_plugin_impl::~mongo_db_plugin_impl() {
 
          consume_thread.join();
 
+         blocks_writer.stop();
+         trans_writer.stop();
+         traces_writer.stop();
+         accounts_writer.stop();
+
          mongo_pool.reset();
       } catch( std::exception& e ) {
          elog( "Exception on mongo_db_plugin shutdown of consume thread: ${e}", ("e", e.what()));
@@ -1468,7 +1480,18 @@ void mongo_db_plugin_impl::init() {
       handle_mongo_exception( "mongo init", __LINE__ );
    }
 
-   ilog("starting db plugin thread");
+   ilog("starting db plugin threads");
+
+   bfs::create_directories( spill_dir );
+   auto make_executor = [this]() -> mongo_writer::executor {
+      auto client = std::make_shared<mongocxx::pool::entry>( mongo_pool->acquire() );
+      auto db = (**client)[db_name];
+      return [client, db]( std::deque<mongo_writer::operation>& ops ) mutable { execute_bulks( db, ops ); };
+   };
+   blocks_writer.start( make_executor, writer_queue_size, spill_dir, max_spill_size );
+   trans_writer.start( make_executor, writer_queue_size, spill_dir, max_spill_size );
+   traces_writer.start( make_executor, writer_queue_size, spill_dir, max_spill_size );
+   accounts_writer.start( make_executor, writer_queue_size, spill_dir, max_spill_size );
 
    consume_thread = std::thread([this] { consume_blocks(); });
 
@@ -1493,6 +1516,12 @@ void mongo_db_plugin::set_program_options(options_description& cli, options_desc
    cfg.add_options()
          ("mongodb-queue-size,q", bpo::value<uint32_t>()->default_value(1024),
          "The target queue size between nodeos and MongoDB plugin thread.")
+         ("mongodb-writer-queue-size", bpo::value<uint32_t>()->default_value(16384),
+         "The number of operations kept in memory by each MongoDB writer thread, the rest are spilled to disk.")
+         ("mongodb-spill-dir", bpo::value<bfs::path>()->default_value("mongodb-spill"),
+         "The location of the files for operations spilled by MongoDB writer threads (absolute path or relative to application data dir).")
+         ("mongodb-spill-size-mb", bpo::value<uint64_t>()->default_value(1024),
+         "Maximum size (in MiB) of the spill file of each MongoDB writer thread, the node is blocked while it has no room for the next operation.")
          ("mongodb-abi-cache-size", bpo::value<uint32_t>()->default_value(2048),
           "The maximum size of the abi cache for serializing data.")
          ("mongodb-wipe", bpo::bool_switch()->default_value(false),
@@ -1548,6 +1577,14 @@ void mongo_db_plugin::plugin_initialize(const variables_map& options)
          if( options.count( "mongodb-queue-size" )) {
             my->max_queue_size = options.at( "mongodb-queue-size" ).as<uint32_t>();
          }
+         my->writer_queue_size = options.at( "mongodb-writer-queue-size" ).as<uint32_t>();
+         EOS_ASSERT( my->writer_queue_size > 0, chain::plugin_config_exception, "mongodb-writer-queue-size > 0 required" );
+         my->spill_dir = options.at( "mongodb-spill-dir" ).as<bfs::path>();
+         if( my->spill_dir.is_relative()) {
+            my->spill_dir = app().data_dir() / my->spill_dir;
+         }
+         my->max_spill_size = options.at( "mongodb-spill-size-mb" ).as<uint64_t>() * 1024 * 1024;
+
          if( options.count( "mongodb-abi-cache-size" )) {
             my->abi_cache_size = options.at( "mongodb-abi-cache-size" ).as<uint32_t>();
             EOS_ASSERT( my->abi_cache_size > 0, chain::plugin_config_exception, "mongodb-abi-cache-size > 0 required" );
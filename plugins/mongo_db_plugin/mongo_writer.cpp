@@ -0,0 +1,243 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <eosio/mongo_db_plugin/mongo_writer.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <bsoncxx/builder/basic/document.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace eosio {
+
+namespace bfs = boost::filesystem;
+
+mongo_writer::operation mongo_writer::insert_op( mongo_collection c, bsoncxx::document::value doc ) {
+   return operation{op_kind::insert, c, bsoncxx::builder::basic::make_document(), std::move( doc )};
+}
+
+mongo_writer::operation mongo_writer::update_op( mongo_collection c, bsoncxx::document::value filter,
+                                                 bsoncxx::document::value update, bool upsert ) {
+   return operation{upsert ? op_kind::upsert : op_kind::update, c, std::move( filter ), std::move( update )};
+}
+
+mongo_writer::operation mongo_writer::remove_op( mongo_collection c, bsoncxx::document::value filter ) {
+   return operation{op_kind::remove, c, std::move( filter ), bsoncxx::builder::basic::make_document()};
+}
+
+mongo_writer::mongo_writer( std::string name )
+: name( std::move( name )) {
+}
+
+mongo_writer::~mongo_writer() {
+   stop();
+}
+
+void mongo_writer::start( std::function<executor()> make_executor, size_t max_queue_size,
+                          const bfs::path& spill_dir, uint64_t max_spill_size ) {
+   this->max_queue_size = max_queue_size;
+   this->max_spill_size = max_spill_size;
+
+   spill_path = spill_dir / (name + ".spill");
+   spill_out.open( spill_path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+   // unbuffered, so reading never returns stale data of the overwritten part of the ring
+   spill_in.rdbuf()->pubsetbuf( nullptr, 0 );
+   spill_in.open( spill_path.generic_string(), std::ios::in | std::ios::binary );
+   EOS_ASSERT( spill_out.is_open() && spill_in.is_open(), chain::plugin_config_exception,
+               "Unable to open mongodb spill file ${f}", ("f", spill_path.generic_string()) );
+
+   thread = std::thread( [this, make_executor = std::move( make_executor )] { run( make_executor ); } );
+}
+
+void mongo_writer::stop() {
+   if( !thread.joinable() ) return;
+
+   {
+      std::unique_lock<std::mutex> lock( mtx );
+      done = true;
+   }
+   condition.notify_all();
+   thread.join();
+
+   spill_out.close();
+   spill_in.close();
+   boost::system::error_code ec;
+   bfs::remove( spill_path, ec );
+}
+
+uint64_t mongo_writer::push( operation op ) {
+   std::unique_lock<std::mutex> lock( mtx );
+   auto check_state = [&] {
+      EOS_ASSERT( !done, chain::mongo_db_exception, "MongoDB ${n} writer is ${s}",
+                  ("n", name)("s", failed ? "stopped on failure" : "stopped") );
+   };
+   check_state();
+
+   if( spilled_ops > 0 || queue.size() >= max_queue_size ) {
+      const auto size = spill_size( op );
+      if( size <= max_spill_size ) {
+         if( spill_used + size > max_spill_size ) {
+            wlog( "mongodb ${n} writer spill file is full, size: ${s}", ("n", name)("s", spill_used) );
+            condition.wait( lock, [&] { return spill_used + size <= max_spill_size || done; } );
+            check_state();
+         }
+         spill( op, size );
+         const auto num = ++pushed;
+         lock.unlock();
+         condition.notify_all();
+         return num;
+      }
+
+      // can't be spilled at all, it is kept in memory after the spilled operations
+      wlog( "mongodb ${n} writer operation exceeds spill file size, size: ${s}", ("n", name)("s", size) );
+      condition.wait( lock, [&] { return spilled_ops == 0 || done; } );
+      check_state();
+   }
+
+   queue.emplace_back( std::move( op ));
+   const auto num = ++pushed;
+   lock.unlock();
+   condition.notify_all();
+   return num;
+}
+
+void mongo_writer::wait_idle() {
+   std::unique_lock<std::mutex> lock( mtx );
+   condition.wait( lock, [&] { return queue.empty() && spilled_ops == 0 && !busy; } );
+   EOS_ASSERT( !failed, chain::mongo_db_exception, "MongoDB ${n} writer is stopped on failure", ("n", name) );
+}
+
+uint64_t mongo_writer::spill_size( const operation& op ) {
+   return 2 + op.filter.view().length() + op.doc.view().length();
+}
+
+void mongo_writer::spill( const operation& op, const uint64_t size ) {
+   auto write = [&]( const char* data, uint64_t length ) {
+      while( length > 0 ) {
+         const auto part = std::min( length, max_spill_size - spill_write_pos );
+         spill_out.seekp( spill_write_pos );
+         spill_out.write( data, part );
+         data += part;
+         length -= part;
+         spill_write_pos = (spill_write_pos + part) % max_spill_size;
+      }
+   };
+   auto write_doc = [&]( const bsoncxx::document::value& doc ) {
+      const auto view = doc.view();
+      // bson document starts with its length
+      write( reinterpret_cast<const char*>( view.data() ), view.length() );
+   };
+
+   const char header[] = { char( op.kind ), char( op.collection ) };
+   write( header, sizeof( header ));
+   write_doc( op.filter );
+   write_doc( op.doc );
+   spill_out.flush();
+   EOS_ASSERT( spill_out.good(), chain::mongo_db_exception,
+               "Failed to write mongodb spill file ${f}", ("f", spill_path.generic_string()) );
+
+   spill_used += size;
+   ++spilled_ops;
+}
+
+uint64_t mongo_writer::unspill( std::deque<operation>& ops, size_t count ) {
+   uint64_t size = 0;
+   auto read = [&]( char* data, uint64_t length ) {
+      size += length;
+      while( length > 0 ) {
+         const auto part = std::min( length, max_spill_size - spill_read_pos );
+         spill_in.seekg( spill_read_pos );
+         spill_in.read( data, part );
+         data += part;
+         length -= part;
+         spill_read_pos = (spill_read_pos + part) % max_spill_size;
+      }
+   };
+   auto read_doc = [&]() {
+      uint32_t length = 0;
+      read( reinterpret_cast<char*>( &length ), sizeof( length ));
+      std::vector<uint8_t> data( std::max<uint32_t>( length, sizeof( length )));
+      memcpy( data.data(), &length, sizeof( length ));
+      read( reinterpret_cast<char*>( data.data() + sizeof( length )), data.size() - sizeof( length ));
+      return bsoncxx::document::value( bsoncxx::document::view( data.data(), data.size() ));
+   };
+
+   for( ; count > 0; --count ) {
+      char header[2];
+      read( header, sizeof( header ));
+      auto filter = read_doc();
+      auto doc = read_doc();
+      EOS_ASSERT( spill_in.good(), chain::mongo_db_exception,
+                  "Failed to read mongodb spill file ${f}", ("f", spill_path.generic_string()) );
+      ops.push_back( operation{op_kind( header[0] ), mongo_collection( header[1] ), std::move( filter ), std::move( doc )} );
+   }
+   return size;
+}
+
+void mongo_writer::run( const std::function<executor()>& make_executor ) {
+   bool ok = false;
+   try {
+      auto execute = make_executor();
+
+      std::deque<operation> ops;
+      while( true ) {
+         std::unique_lock<std::mutex> lock( mtx );
+         busy = false;
+         condition.notify_all();
+         condition.wait( lock, [&] { return !queue.empty() || spilled_ops > 0 || done; } );
+
+         size_t unspill_count = 0;
+         if( !queue.empty() ) {
+            // operations in memory are older than the spilled ones
+            ops = std::move( queue );
+            queue.clear();
+         } else if( spilled_ops > 0 ) {
+            unspill_count = std::min( spilled_ops, max_unspill_count );
+         } else {
+            break;
+         }
+         busy = true;
+         lock.unlock();
+
+         if( unspill_count > 0 ) {
+            // push() writes only behind the unread operations, so the file is read without the lock
+            const auto size = unspill( ops, unspill_count );
+            lock.lock();
+            spilled_ops -= unspill_count;
+            spill_used -= size;
+            lock.unlock();
+         }
+         condition.notify_all();
+
+         const auto count = ops.size();
+         execute( ops );
+         ops.clear();
+         executed += count;
+      }
+      ok = true;
+      ilog( "mongo_db_plugin ${n} writer shutdown gracefully", ("n", name) );
+   } catch (fc::exception& e) {
+      elog("FC Exception in mongodb ${n} writer ${e}", ("n", name)("e", e.to_string()));
+   } catch (std::exception& e) {
+      elog("STD Exception in mongodb ${n} writer ${e}", ("n", name)("e", e.what()));
+   } catch (...) {
+      elog("Unknown exception in mongodb ${n} writer", ("n", name));
+   }
+
+   std::unique_lock<std::mutex> lock( mtx );
+   busy = false;
+   done = true;
+   failed = !ok;
+   queue.clear();
+   spilled_ops = 0;
+   spill_used = 0;
+   condition.notify_all();
+}
+
+} // namespace eosio
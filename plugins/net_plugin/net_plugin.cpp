@@ -156,6 +156,9 @@ namespace eosio {
    constexpr auto     def_txn_expire_wait = std::chrono::seconds(3);
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 100;
+   constexpr auto     def_sync_fetch_peers = 4;
+   constexpr auto     def_sync_buffer_size = def_sync_fetch_span * 10;
+   constexpr auto     def_sync_backoff_period = fc::seconds(30);
 
    constexpr auto     message_header_size = 4;
    constexpr uint32_t signed_block_which = 7;        // see protocol net_message
@@ -369,6 +372,7 @@ namespace eosio {
       go_away_reason         no_retry = no_reason;
       block_id_type          fork_head;
       uint32_t               fork_head_num = 0;
+      fc::time_point         sync_backoff_until;  // peer timed out on a sync range, prefer other peers until this time
       optional<request_message> last_req;
       bool                   persistent;
       fc::time_point         reconnect_after = fc::time_point();
@@ -507,19 +511,48 @@ namespace eosio {
          in_sync
       };
 
+      /// range of blocks requested from a single peer during lib catchup
+      struct sync_range {
+         uint32_t       start = 0;
+         uint32_t       end = 0;
+         uint32_t       next = 0;        ///< next block expected from the peer
+         connection_ptr source;          ///< empty if the range waits for a new peer
+         time_point     requested;
+      };
+
+      /// block received ahead of the next block expected by the controller
+      struct sync_pending_block {
+         connection_ptr   source;
+         signed_block_ptr block;
+      };
+
       uint32_t       sync_known_lib_num;
       uint32_t       sync_last_requested_num;
       uint32_t       sync_next_expected_num;
       uint32_t       sync_req_span;
-      connection_ptr source;
+      uint32_t       sync_max_peers;
+      uint32_t       sync_buffer_size;
+      connection_ptr source;           ///< last selected peer, start point of the round-robin selection
       stages         state;
 
+      std::map<uint32_t, sync_range>         ranges;    ///< in-flight ranges ordered by start block
+      std::map<uint32_t, sync_pending_block> pending;   ///< reorder buffer ordered by block num
+
       chain_plugin* chain_plug = nullptr;
 
       constexpr auto stage_str(stages s );
 
+      std::map<uint32_t, sync_range>::iterator find_range(const connection_ptr& c);
+      bool is_sync_candidate(const connection_ptr& c, uint32_t start, bool allow_backoff);
+      connection_ptr select_source(const connection_ptr& c, uint32_t start);
+      void request_range(sync_range& range, const connection_ptr& c);
+      void release_range(const connection_ptr& c);
+      void track_range_block(const connection_ptr& c, uint32_t blk_num);
+      void reset_ranges();
+      void apply_pending();
+
    public:
-      explicit sync_manager(uint32_t span);
+      sync_manager(uint32_t span, uint32_t max_peers, uint32_t buffer_size);
       void set_state(stages s);
       bool sync_required();
       void send_handshakes();
@@ -529,6 +562,7 @@ namespace eosio {
       void start_sync(const connection_ptr& c, uint32_t target);
       void reassign_fetch(const connection_ptr& c, go_away_reason reason);
       void verify_catchup(const connection_ptr& c, uint32_t num, const block_id_type& id);
+      bool defer_block(const connection_ptr& c, const signed_block_ptr& blk, uint32_t blk_num);
       void rejected_block(const connection_ptr& c, uint32_t blk_num);
       void recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num);
       void recv_handshake(const connection_ptr& c, const handshake_message& msg);
@@ -1265,11 +1299,13 @@ namespace eosio {
 
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t req_span )
+    sync_manager::sync_manager( uint32_t req_span, uint32_t max_peers, uint32_t buffer_size )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_req_span( req_span )
+      ,sync_max_peers( max_peers )
+      ,sync_buffer_size( buffer_size )
       ,source()
       ,state(in_sync)
    {
@@ -1307,13 +1343,14 @@ namespace eosio {
    void sync_manager::reset_lib_num(const connection_ptr& c) {
       if(state == in_sync) {
          source.reset();
+         reset_ranges();
       }
       if( c->current() ) {
          if( c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num) {
             sync_known_lib_num =c->last_handshake_recv.last_irreversible_block_num;
          }
-      } else if( c == source ) {
-         sync_last_requested_num = 0;
+      } else if( find_range(c) != ranges.end() ) {
+         release_range(c);
          request_next_chunk();
       }
    }
@@ -1326,86 +1363,175 @@ namespace eosio {
               chain_plug->chain().fork_db_head_block_num() < sync_last_requested_num );
    }
 
-   void sync_manager::request_next_chunk( const connection_ptr& conn ) {
-      uint32_t head_block = chain_plug->chain().fork_db_head_block_num();
+   std::map<uint32_t, sync_manager::sync_range>::iterator sync_manager::find_range(const connection_ptr& c) {
+      if (!c) {
+         return ranges.end();
+      }
+      return std::find_if(ranges.begin(), ranges.end(), [&](const auto& r) { return r.second.source == c; });
+   }
 
-      if (head_block < sync_last_requested_num && source && source->current()) {
-         fc_ilog(logger, "ignoring request, head is ${h} last req = ${r} source is ${p}",
-                  ("h",head_block)("r",sync_last_requested_num)("p",source->peer_name()));
-         return;
+   bool sync_manager::is_sync_candidate(const connection_ptr& c, uint32_t start, bool allow_backoff) {
+      if (!c || !c->current() || find_range(c) != ranges.end()) {
+         return false;
       }
+      if (!allow_backoff && c->sync_backoff_until > time_point::now()) {
+         return false;
+      }
+      // skip peers which reported that they don't have the range yet
+      return c->last_handshake_recv.head_num == 0 || c->last_handshake_recv.head_num >= start;
+   }
 
+   connection_ptr sync_manager::select_source(const connection_ptr& conn, uint32_t start) {
       /* ----------
        * next chunk provider selection criteria
        * a provider is supplied and able to be used, use it.
-       * otherwise select the next available from the list, round-robin style.
+       * otherwise select the next idle one from the list, round-robin style,
+       * peers which recently failed to provide a range are used only if nobody else is available.
        */
+      for (auto allow_backoff: {false, true}) {
+         if (is_sync_candidate(conn, start, allow_backoff)) {
+            source = conn;
+            return source;
+         }
 
-      if (conn && conn->current() ) {
-         source = conn;
-      }
-      else {
-         if (my_impl->connections.size() == 1) {
-            if (!source) {
-               source = *my_impl->connections.begin();
+         auto& conns = my_impl->connections;
+         if (conns.empty()) {
+            return connection_ptr();
+         }
+
+         auto cptr = conns.begin();
+         // do we remember the previous source? start from the next one after it
+         if (source) {
+            auto itr = conns.find(source);
+            if (itr != conns.end() && ++itr != conns.end()) {
+               cptr = itr;
             }
          }
-         else {
-            // init to a linear array search
-            auto cptr = my_impl->connections.begin();
-            auto cend = my_impl->connections.end();
-            // do we remember the previous source?
-            if (source) {
-               //try to find it in the list
-               cptr = my_impl->connections.find(source);
-               cend = cptr;
-               if (cptr == my_impl->connections.end()) {
-                  //not there - must have been closed! cend is now connections.end, so just flatten the ring.
-                  source.reset();
-                  cptr = my_impl->connections.begin();
-               } else {
-                  //was found - advance the start to the next. cend is the old source.
-                  if (++cptr == my_impl->connections.end() && cend != my_impl->connections.end() ) {
-                     cptr = my_impl->connections.begin();
-                  }
-               }
+
+         auto cstart_it = cptr;
+         do {
+            if (is_sync_candidate(*cptr, start, allow_backoff)) {
+               source = *cptr;
+               return source;
+            }
+            if (++cptr == conns.end()) {
+               cptr = conns.begin();
             }
+         } while (cptr != cstart_it);
+      }
+      return connection_ptr();
+   }
 
-            //scan the list of peers looking for another able to provide sync blocks.
-            auto cstart_it = cptr;
-            do {
-               //select the first one which is current and break out.
-               if((*cptr)->current()) {
-                  source = *cptr;
-                  break;
-               }
-               if(++cptr == my_impl->connections.end())
-                     cptr = my_impl->connections.begin();
-            } while(cptr != cstart_it);
-            // no need to check the result, either source advanced or the whole list was checked and the old source is reused.
+   void sync_manager::request_range(sync_range& range, const connection_ptr& c) {
+      fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
+              ("n",c->peer_name())("s",range.next)("e",range.end));
+      range.source = c;
+      range.requested = time_point::now();
+      c->request_sync_blocks(range.next, range.end);
+   }
+
+   void sync_manager::release_range(const connection_ptr& c) {
+      auto itr = find_range(c);
+      if (itr != ranges.end()) {
+         fc_dlog(logger, "range ${s} to ${e} released by ${p}, next block ${n}",
+                 ("s",itr->second.start)("e",itr->second.end)("n",itr->second.next)("p",c->peer_name()));
+         itr->second.source.reset();
+      }
+   }
+
+   void sync_manager::track_range_block(const connection_ptr& c, uint32_t blk_num) {
+      auto itr = find_range(c);
+      if (itr == ranges.end() || itr->second.next != blk_num) {
+         return;
+      }
+
+      auto& range = itr->second;
+      ++range.next;
+      if (range.next > range.end) {
+         fc_dlog(logger, "range ${s} to ${e} received from ${p} in ${t} ms",
+                 ("s",range.start)("e",range.end)("p",c->peer_name())
+                 ("t",(time_point::now() - range.requested).count() / 1000));
+         ranges.erase(itr);
+      } else {
+         c->sync_wait();
+      }
+   }
+
+   void sync_manager::reset_ranges() {
+      for (auto& r: ranges) {
+         if (r.second.source && r.second.source->current()) {
+            r.second.source->cancel_sync(benign_other);
          }
       }
+      ranges.clear();
+      pending.clear();
+      sync_last_requested_num = 0;
+   }
 
-      // verify there is an available source
-      if (!source || !source->current() ) {
-         fc_elog( logger, "Unable to continue syncing at this time");
-         sync_known_lib_num = chain_plug->chain().last_irreversible_block_num();
-         sync_last_requested_num = 0;
-         set_state(in_sync); // probably not, but we can't do anything else
+   void sync_manager::apply_pending() {
+      auto itr = pending.find(sync_next_expected_num);
+      if (itr == pending.end()) {
          return;
       }
 
-      if( sync_last_requested_num != sync_known_lib_num ) {
-         uint32_t start = sync_next_expected_num;
+      auto blk = std::move(itr->second);
+      pending.erase(itr);
+      // the controller receives blocks through the application queue to let it interleave with the network
+      app().post(priority::medium, [blk = std::move(blk)]() {
+         my_impl->handle_message(blk.source, blk.block);
+      });
+   }
+
+   void sync_manager::request_next_chunk( const connection_ptr& conn ) {
+      bool starved = false;
+
+      // ranges lost by their peers go first, they block applying of buffered blocks
+      for (auto& r: ranges) {
+         auto& range = r.second;
+         if (range.source) {
+            continue;
+         }
+         auto c = select_source(conn, range.next);
+         if (!c) {
+            starved = true;
+            break;
+         }
+         request_range(range, c);
+      }
+
+      while (!starved && ranges.size() < sync_max_peers && sync_last_requested_num < sync_known_lib_num) {
+         uint32_t start = std::max(sync_last_requested_num + 1, sync_next_expected_num);
          uint32_t end = start + sync_req_span - 1;
          if( end > sync_known_lib_num )
             end = sync_known_lib_num;
-         if( end > 0 && end >= start ) {
-            fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
-                    ("n",source->peer_name())("s",start)("e",end));
-            source->request_sync_blocks(start, end);
-            sync_last_requested_num = end;
+         // the reorder buffer limits how far the download can go ahead of the controller
+         if( end >= sync_next_expected_num + sync_buffer_size )
+            end = sync_next_expected_num + sync_buffer_size - 1;
+         if( end == 0 || end < start ) {
+            break;
+         }
+
+         auto c = select_source(conn, start);
+         if (!c) {
+            starved = true;
+            break;
          }
+
+         auto& range = ranges[start];
+         range.start = start;
+         range.next = start;
+         range.end = end;
+         request_range(range, c);
+         sync_last_requested_num = end;
+      }
+
+      // verify there is an available source
+      bool has_source = std::any_of(ranges.begin(), ranges.end(), [](const auto& r) { return !!r.second.source; });
+      if (starved && !has_source) {
+         fc_elog( logger, "Unable to continue syncing at this time");
+         sync_known_lib_num = chain_plug->chain().last_irreversible_block_num();
+         reset_ranges();
+         set_state(in_sync); // probably not, but we can't do anything else
       }
    }
 
@@ -1446,9 +1572,10 @@ namespace eosio {
       fc_ilog(logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
               ( "cc",sync_last_requested_num)("ne",sync_next_expected_num)("p",c->peer_name()));
 
-      if (c == source) {
+      if (find_range(c) != ranges.end()) {
          c->cancel_sync(reason);
-         sync_last_requested_num = 0;
+         c->sync_backoff_until = time_point::now() + def_sync_backoff_period;
+         release_range(c);
          request_next_chunk();
       }
    }
@@ -1583,11 +1710,36 @@ namespace eosio {
       }
    }
 
+   bool sync_manager::defer_block(const connection_ptr& c, const signed_block_ptr& blk, uint32_t blk_num) {
+      if (state != lib_catchup || blk_num <= sync_next_expected_num) {
+         return false;
+      }
+
+      auto itr = find_range(c);
+      if (itr == ranges.end()) {
+         // the range was reassigned to another peer, blocks still in flight from this one are ignored
+         fc_dlog(logger, "ignoring block ${bn} from ${p} without requested range",("bn",blk_num)("p",c->peer_name()));
+         return true;
+      }
+      if (itr->second.next != blk_num) {
+         fc_ilog(logger, "expected block ${ne} but got ${bn} from ${p}",("ne",itr->second.next)("bn",blk_num)("p",c->peer_name()));
+         my_impl->close(c);
+         return true;
+      }
+
+      fc_dlog(logger, "buffering block ${bn} from ${p}, next expected ${ne}",
+              ("bn",blk_num)("p",c->peer_name())("ne",sync_next_expected_num));
+      pending.emplace(blk_num, sync_pending_block{c, blk});
+      track_range_block(c, blk_num);
+      request_next_chunk();
+      return true;
+   }
+
    void sync_manager::rejected_block(const connection_ptr& c, uint32_t blk_num) {
       if (state != in_sync ) {
          fc_ilog(logger, "block ${bn} not accepted from ${p}",("bn",blk_num)("p",c->peer_name()));
-         sync_last_requested_num = 0;
          source.reset();
+         reset_ranges();
          my_impl->close(c);
          set_state(in_sync);
          send_handshakes();
@@ -1596,6 +1748,11 @@ namespace eosio {
    void sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num) {
       fc_dlog(logger, "got block ${bn} from ${p}",("bn",blk_num)("p",c->peer_name()));
       if (state == lib_catchup) {
+         if (blk_num < sync_next_expected_num) {
+            // already applied block, received again from the peer which got a reassigned range
+            track_range_block(c, blk_num);
+            return;
+         }
          if (blk_num != sync_next_expected_num) {
             fc_ilog(logger, "expected block ${ne} but got ${bn}",("ne",sync_next_expected_num)("bn",blk_num));
             my_impl->close(c);
@@ -1607,6 +1764,7 @@ namespace eosio {
          fc_dlog(logger, "sync_manager in head_catchup state");
          set_state(in_sync);
          source.reset();
+         reset_ranges();
 
          block_id_type null_id;
          for (const auto& cp : my_impl->connections) {
@@ -1629,15 +1787,19 @@ namespace eosio {
       else if (state == lib_catchup) {
          if( blk_num == sync_known_lib_num ) {
             fc_dlog( logger, "All caught up with last known last irreversible block resending handshake");
+            reset_ranges();
             set_state(in_sync);
             send_handshakes();
          }
-         else if (blk_num == sync_last_requested_num) {
-            request_next_chunk();
-         }
          else {
-            fc_dlog(logger,"calling sync_wait on connection ${p}",("p",c->peer_name()));
-            c->sync_wait();
+            // a buffered block was already counted in the range of its peer
+            track_range_block(c, blk_num);
+            request_next_chunk();
+            apply_pending();
+            if (find_range(c) != ranges.end()) {
+               fc_dlog(logger,"calling sync_wait on connection ${p}",("p",c->peer_name()));
+               c->sync_wait();
+            }
          }
       }
    }
@@ -2673,6 +2835,10 @@ namespace eosio {
          fc_elog( logger,"Caught an unknown exception trying to recall blockID" );
       }
 
+      if( sync_master->defer_block(c, msg, blk_num) ) {
+         return;
+      }
+
       dispatcher->recv_block(c, blk_id, blk_num);
       fc::microseconds age( fc::time_point::now() - msg->timestamp);
       peer_ilog(c, "received signed_block : #${n} block age in secs = ${age}",
@@ -3047,6 +3213,8 @@ namespace eosio {
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+         ( "sync-fetch-peers", bpo::value<uint32_t>()->default_value(def_sync_fetch_peers), "number of peers to retrieve chunks from concurrently during synchronization")
+         ( "sync-buffer-size", bpo::value<uint32_t>()->default_value(def_sync_buffer_size), "maximum number of blocks received ahead of the chain head during synchronization")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable expirimental socket read watermark optimization")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
@@ -3074,7 +3242,16 @@ namespace eosio {
          my->network_version_match = options.at( "network-version-match" ).as<bool>();
          my->address_exchange = options.at( "p2p-address-exchange" ).as<bool>();
 
-         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>()));
+         auto sync_fetch_span = options.at( "sync-fetch-span" ).as<uint32_t>();
+         auto sync_fetch_peers = options.at( "sync-fetch-peers" ).as<uint32_t>();
+         auto sync_buffer_size = options.at( "sync-buffer-size" ).as<uint32_t>();
+         EOS_ASSERT( sync_fetch_span > 0, chain::plugin_config_exception,
+                     "sync-fetch-span ${num} must be greater than 0", ("num", sync_fetch_span) );
+         EOS_ASSERT( sync_fetch_peers > 0, chain::plugin_config_exception,
+                     "sync-fetch-peers ${num} must be greater than 0", ("num", sync_fetch_peers) );
+         EOS_ASSERT( sync_buffer_size >= sync_fetch_span, chain::plugin_config_exception,
+                     "sync-buffer-size ${num} must be not less than sync-fetch-span", ("num", sync_buffer_size) );
+         my->sync_master.reset( new sync_manager( sync_fetch_span, sync_fetch_peers, sync_buffer_size ));
          my->dispatcher.reset( new dispatch_manager );
 
          my->connector_period = std::chrono::seconds( options.at( "connection-cleanup-period" ).as<int>());
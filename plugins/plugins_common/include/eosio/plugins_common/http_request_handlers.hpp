@@ -6,7 +6,7 @@
           try { \
              if (body.empty()) body = "{}"; \
              auto result = object.method(fc::json::from_string(body).as<method ## _params>()); \
-             cb(http_response_code, fc::json::to_string(result)); \
+             http_plugin::send_response(http_response_code, result, cb); \
           } catch (...) { \
              http_plugin::handle_exception(#api_name, #method, body, cb); \
           } \
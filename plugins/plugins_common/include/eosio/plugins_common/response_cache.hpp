@@ -0,0 +1,54 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+#include <eosio/http_plugin/http_plugin.hpp>
+
+namespace eosio {
+
+   /**
+    * Cache of serialized responses of read-only API calls.
+    *
+    * Caching is enabled per URL. A response is keyed by the URL and the request body, and it is
+    * valid until the next call of invalidate(), which the chain_plugin does on each accepted block
+    * (and on each applied transaction in the speculative mode). The total size of cached
+    * responses is bounded, the oldest entries are dropped first.
+    *
+    * All methods must be called from the application thread.
+    */
+   class response_cache {
+   public:
+      void set_max_size(size_t size) { max_size = size; }
+      void enable(const std::string& url) { enabled_urls.insert(url); }
+      bool is_enabled(const std::string& url) const { return max_size && enabled_urls.count(url); }
+
+      void invalidate();
+
+      /// wraps handlers of enabled URLs so that their successful responses are cached
+      api_description wrap(api_description api);
+
+      size_t size() const { return entries.size(); }
+
+   private:
+      using cache_key = std::pair<std::string, std::string>;
+
+      struct cache_entry {
+         std::string response;
+         std::list<cache_key>::iterator order;
+      };
+
+      void store(const std::string& url, const std::string& body, const std::string& response);
+      void erase_oldest();
+
+      std::set<std::string>           enabled_urls;
+      std::map<cache_key,cache_entry> entries;
+      std::list<cache_key>            order;
+      uint64_t                        generation = 0;
+      size_t                          used_size = 0;
+      size_t                          max_size = 0;
+   };
+
+} // namespace eosio
@@ -0,0 +1,64 @@
+#include <eosio/plugins_common/response_cache.hpp>
+
+namespace eosio {
+
+    void response_cache::invalidate() {
+        ++generation;
+        entries.clear();
+        order.clear();
+        used_size = 0;
+    }
+
+    api_description response_cache::wrap(api_description api) {
+        for (auto& call: api) {
+            if (!is_enabled(call.first)) {
+                continue;
+            }
+
+            ilog("cache responses of ${c}", ("c", call.first));
+            call.second = [this, handler = std::move(call.second)](string url, string body, url_response_callback cb) {
+                auto itr = entries.find(cache_key(url, body));
+                if (itr != entries.end()) {
+                    cb(200, itr->second.response);
+                    return;
+                }
+
+                handler(url, body, [this, gen = generation, url, body, cb = std::move(cb)](int code, string response) {
+                    // the response could be produced after the state was changed
+                    if (code == 200 && gen == generation) {
+                        store(url, body, response);
+                    }
+                    cb(code, std::move(response));
+                });
+            };
+        }
+        return api;
+    }
+
+    void response_cache::store(const std::string& url, const std::string& body, const std::string& response) {
+        auto size = url.size() + body.size() + response.size();
+        if (size > max_size) {
+            return;
+        }
+        while (used_size + size > max_size) {
+            erase_oldest();
+        }
+
+        cache_key key(url, body);
+        auto order_itr = order.insert(order.end(), key);
+        auto res = entries.emplace(std::move(key), cache_entry{response, order_itr});
+        if (!res.second) {
+            order.erase(order_itr);
+            return;
+        }
+        used_size += size;
+    }
+
+    void response_cache::erase_oldest() {
+        auto itr = entries.find(order.front());
+        used_size -= itr->first.first.size() + itr->first.second.size() + itr->second.response.size();
+        entries.erase(itr);
+        order.pop_front();
+    }
+
+} // namespace eosio
@@ -7,6 +7,7 @@
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/snapshot.hpp>
 
@@ -151,6 +152,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       incoming::methods::block_sync::method_type::handle        _incoming_block_sync_provider;
       incoming::methods::transaction_async::method_type::handle _incoming_transaction_async_provider;
+      incoming::methods::transaction_batch_async::method_type::handle _incoming_transaction_batch_async_provider;
 
       transaction_id_with_expiry_index                         _blacklisted_transactions;
 
@@ -356,6 +358,53 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          });
       }
 
+      using transaction_batch = std::vector<std::pair<transaction_metadata_ptr, next_function<transaction_trace_ptr>>>;
+
+      void on_incoming_transaction_batch_async(const transaction_batch& trxs, bool persist_until_expired) {
+         chain::controller& chain = chain_plug->chain();
+         const auto& cfg = chain.get_global_properties().configuration;
+         std::vector<signing_keys_future_type> futures;
+         futures.reserve(trxs.size());
+         bool ready = true;
+         for( const auto& t : trxs ) {
+            futures.emplace_back( transaction_metadata::start_recover_keys( t.first, *_thread_pool,
+                  chain.get_chain_id(), fc::microseconds( cfg.max_transaction_usage[chain::resource_limits::CPU] ) ) );
+            ready = ready && futures.back().wait_for( std::chrono::seconds(0) ) == std::future_status::ready;
+         }
+
+         auto process = [self = this, batch = std::make_shared<const transaction_batch>(trxs), persist_until_expired]() {
+            self->process_incoming_transaction_batch_async( batch, 0, persist_until_expired );
+         };
+
+         // keys are usually recovered by the caller, so the batch goes to the main thread at once
+         if( ready ) {
+            app().post(priority::low, std::move(process));
+            return;
+         }
+         boost::asio::post( *_thread_pool, [futures = std::move(futures), process = std::move(process)]() {
+            for( const auto& future : futures ) {
+               if( future.valid() )
+                  future.wait();
+            }
+            app().post(priority::low, std::move(process));
+         });
+      }
+
+      static constexpr size_t incoming_transaction_batch_chunk = 16;
+
+      // a batch is applied by small chunks, the rest is posted again to let other tasks of the main thread run
+      void process_incoming_transaction_batch_async(const std::shared_ptr<const transaction_batch>& trxs, size_t start, bool persist_until_expired) {
+         const auto end = std::min(trxs->size(), start + incoming_transaction_batch_chunk);
+         for( auto i = start; i < end; ++i ) {
+            process_incoming_transaction_async( (*trxs)[i].first, persist_until_expired, (*trxs)[i].second );
+         }
+         if( end < trxs->size() ) {
+            app().post(priority::low, [self = this, trxs, end, persist_until_expired]() {
+               self->process_incoming_transaction_batch_async( trxs, end, persist_until_expired );
+            });
+         }
+      }
+
       void process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
          chain::controller& chain = chain_plug->chain();
          if (!chain.pending_block_state()) {
@@ -720,6 +769,10 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       return my->on_incoming_transaction_async(trx, persist_until_expired, next );
    });
 
+   my->_incoming_transaction_batch_async_provider = app().get_method<incoming::methods::transaction_batch_async>().register_provider([this](const producer_plugin_impl::transaction_batch& trxs, bool persist_until_expired) -> void {
+      return my->on_incoming_transaction_batch_async(trxs, persist_until_expired );
+   });
+
 } FC_LOG_AND_RETHROW() }
 
 void producer_plugin::plugin_startup()
@@ -1307,14 +1360,11 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
                );
             }
             time_point pending_block_time = chain.pending_block_time();
-            const auto sch_idx = chain.chaindb().get_index<chain::generated_transaction_object,by_delay>();
-            // TODO: Removed by CyberWay
-            // const auto scheduled_trxs_size = sch_idx.size();
-            int scheduled_trxs_size = 0;
-            for(auto sch_itr = sch_idx.begin(); sch_itr.is_valid(); ++sch_itr ) {
-               ++scheduled_trxs_size;
-               if( sch_itr->delay_until > pending_block_time) break;    // not scheduled yet
-               if( sch_itr->published >= pending_block_time ) {
+            auto& scheduler = chain.get_mutable_deferred_scheduler();
+            const auto ready_trxs = scheduler.get_ready( pending_block_time );
+            const auto scheduled_trxs_size = ready_trxs.size();
+            for( const auto& sch: ready_trxs ) {
+               if( sch->published >= pending_block_time ) {
                   continue; // do not allow schedule and execute in same block
                }
                if( scheduled_trx_deadline <= fc::time_point::now() ) {
@@ -1322,7 +1372,7 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
                   break;
                }
 
-               auto trx_id = sch_itr->trx_id;
+               const auto& trx_id = sch->trx_id;
                if (blacklist_by_id.find(trx_id) != blacklist_by_id.end()) {
                   continue;
                }
@@ -1345,8 +1395,8 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
                   break;
                }
 
-               if( !sch_itr.is_valid() ) {
-                  // transaction was changed
+               if( !scheduler.is_scheduled( trx_id ) ) {
+                  // transaction was retired or cancelled
                   continue;
                }
 
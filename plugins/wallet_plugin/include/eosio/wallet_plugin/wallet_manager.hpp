@@ -6,6 +6,7 @@
 #include <eosio/chain/transaction.hpp>
 #include <eosio/wallet_plugin/wallet_api.hpp>
 #include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <chrono>
@@ -43,7 +44,12 @@ public:
    /// @see wallet_manager::set_timeout(const std::chrono::seconds& t)
    /// @param secs The timeout in seconds.
    void set_timeout(int64_t secs) { set_timeout(std::chrono::seconds(secs)); }
-      
+
+   /// Set the number of threads used by sign_transactions.
+   /// Without threads all transactions of the batch are signed in the calling thread.
+   /// @param num the number of threads, 0 disables the thread pool.
+   void set_signing_threads(uint16_t num);
+
    /// Sign transaction with the private keys specified via their public keys.
    /// Use chain_controller::get_required_keys to determine which keys are needed for txn.
    /// @param txn the transaction to sign.
@@ -54,6 +60,18 @@ public:
    chain::signed_transaction sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys,
                                              const chain::chain_id_type& id);
 
+   /// Transaction with the public keys of the private keys to sign it with.
+   using signing_request = std::pair<chain::signed_transaction, flat_set<public_key_type>>;
+
+   /// Sign a batch of transactions.
+   /// All keys are resolved before signing, so nothing is signed if some key is missing.
+   /// Transactions signed only by keys of soft wallets are signed in parallel, see set_signing_threads.
+   /// @param txns the transactions to sign with the public keys of the corresponding private keys for each one.
+   /// @param id the chain_id to sign transactions with.
+   /// @return txns signed, in the same order
+   /// @throws fc::exception if corresponding private keys not found in unlocked wallets
+   std::vector<chain::signed_transaction> sign_transactions(const std::vector<signing_request>& txns,
+                                                            const chain::chain_id_type& id);
 
    /// Sign digest with the private keys specified via their public keys.
    /// @param digest the digest to sign.
@@ -134,6 +152,17 @@ private:
    /// Calls lock_all() if timeout has passed.
    void check_timeout();
 
+   /// @return wallet which holds the private key of the public key, or nullptr if no unlocked wallet has it.
+   /// The index of keys is built on the first call after the set of keys of unlocked wallets is changed.
+   wallet_api* find_key_wallet(const public_key_type& key);
+
+   /// Signs with the wallet found in the index of keys, falls back to all unlocked wallets if it doesn't sign.
+   /// @return signature, or empty if no unlocked wallet signs the digest with the key
+   fc::optional<chain::signature_type> try_sign_digest(const chain::digest_type& digest, const public_key_type& key);
+
+   /// Drops the index of keys, should be called on each change of keys of unlocked wallets.
+   void reset_key_index() { key_index_valid = false; }
+
 private:
    using timepoint_t = std::chrono::time_point<std::chrono::system_clock>;
    std::map<std::string, std::unique_ptr<wallet_api>> wallets;
@@ -142,6 +171,9 @@ private:
    boost::filesystem::path dir = ".";
    boost::filesystem::path lock_path = dir / "wallet.lock";
    std::unique_ptr<boost::interprocess::file_lock> wallet_dir_lock;
+   std::map<public_key_type, wallet_api*> key_index; ///< keys of unlocked wallets, the first wallet in order of names wins
+   bool key_index_valid = false;
+   std::unique_ptr<boost::asio::thread_pool> signing_thread_pool;
 
    void start_lock_watch(std::shared_ptr<boost::asio::deadline_timer> t);
    void initialize_lock();
@@ -7,6 +7,8 @@
 #include <eosio/wallet_plugin/wallet.hpp>
 #include <eosio/wallet_plugin/se_wallet.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
+#include <fc/scoped_exit.hpp>
 #include <boost/algorithm/string.hpp>
 namespace eosio {
 namespace wallet {
@@ -48,6 +50,13 @@ void wallet_manager::set_timeout(const std::chrono::seconds& t) {
              ("t", t.count())("now", now.time_since_epoch().count())("timeout_time", timeout_time.time_since_epoch().count()));
 }
 
+void wallet_manager::set_signing_threads(uint16_t num) {
+   signing_thread_pool.reset();
+   if (num > 0) {
+      signing_thread_pool = std::make_unique<boost::asio::thread_pool>(num);
+   }
+}
+
 void wallet_manager::check_timeout() {
    if (timeout_time != timepoint_t::max()) {
       const auto& now = std::chrono::system_clock::now();
@@ -88,6 +97,7 @@ std::string wallet_manager::create(const std::string& name) {
       wallets.erase(it);
    }
    wallets.emplace(name, std::move(wallet));
+   reset_key_index();
 
    return password;
 }
@@ -112,6 +122,7 @@ void wallet_manager::open(const std::string& name) {
       wallets.erase(it);
    }
    wallets.emplace(name, std::move(wallet));
+   reset_key_index();
 }
 
 std::vector<std::string> wallet_manager::list_wallets() {
@@ -162,6 +173,7 @@ void wallet_manager::lock_all() {
          i.second->lock();
       }
    }
+   reset_key_index();
 }
 
 void wallet_manager::lock(const std::string& name) {
@@ -174,6 +186,7 @@ void wallet_manager::lock(const std::string& name) {
       return;
    }
    w->lock();
+   reset_key_index();
 }
 
 void wallet_manager::unlock(const std::string& name, const std::string& password) {
@@ -187,6 +200,7 @@ void wallet_manager::unlock(const std::string& name, const std::string& password
       return;
    }
    w->unlock(password);
+   reset_key_index();
 }
 
 void wallet_manager::import_key(const std::string& name, const std::string& wif_key) {
@@ -199,6 +213,7 @@ void wallet_manager::import_key(const std::string& name, const std::string& wif_
       EOS_THROW(chain::wallet_locked_exception, "Wallet is locked: ${w}", ("w", name));
    }
    w->import_key(wif_key);
+   reset_key_index();
 }
 
 void wallet_manager::remove_key(const std::string& name, const std::string& password, const std::string& key) {
@@ -212,6 +227,7 @@ void wallet_manager::remove_key(const std::string& name, const std::string& pass
    }
    w->check_password(password); //throws if bad password
    w->remove_key(key);
+   reset_key_index();
 }
 
 string wallet_manager::create_key(const std::string& name, const std::string& key_type) {
@@ -225,46 +241,109 @@ string wallet_manager::create_key(const std::string& name, const std::string& ke
    }
 
    string upper_key_type = boost::to_upper_copy<std::string>(key_type);
-   return w->create_key(upper_key_type);
+   auto key = w->create_key(upper_key_type);
+   reset_key_index();
+   return key;
 }
 
 chain::signed_transaction
 wallet_manager::sign_transaction(const chain::signed_transaction& txn, const flat_set<public_key_type>& keys, const chain::chain_id_type& id) {
    check_timeout();
    chain::signed_transaction stxn(txn);
+   const auto digest = stxn.sig_digest(id, stxn.context_free_data);
 
    for (const auto& pk : keys) {
-      bool found = false;
-      for (const auto& i : wallets) {
-         if (!i.second->is_locked()) {
-            fc::optional<signature_type> sig = i.second->try_sign_digest(stxn.sig_digest(id, stxn.context_free_data), pk);
-            if (sig) {
-               stxn.signatures.push_back(*sig);
-               found = true;
-               break; // inner for
-            }
-         }
-      }
-      if (!found) {
+      fc::optional<signature_type> sig = try_sign_digest(digest, pk);
+      if (!sig) {
          EOS_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
       }
+      stxn.signatures.push_back(*sig);
    }
 
    return stxn;
 }
 
+std::vector<chain::signed_transaction>
+wallet_manager::sign_transactions(const std::vector<signing_request>& txns, const chain::chain_id_type& id) {
+   check_timeout();
+
+   using key_wallets = std::vector<std::pair<public_key_type, wallet_api*>>;
+
+   std::vector<chain::signed_transaction> result;
+   std::vector<key_wallets> signers;
+   result.reserve(txns.size());
+   signers.reserve(txns.size());
+
+   for (const auto& t : txns) {
+      key_wallets kws;
+      kws.reserve(t.second.size());
+      for (const auto& pk : t.second) {
+         auto w = find_key_wallet(pk);
+         if (!w) {
+            EOS_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+         }
+         kws.emplace_back(pk, w);
+      }
+      result.emplace_back(t.first);
+      signers.emplace_back(std::move(kws));
+   }
+
+   auto sign = [&id](chain::signed_transaction& stxn, const key_wallets& kws) {
+      const auto digest = stxn.sig_digest(id, stxn.context_free_data);
+      for (const auto& kw : kws) {
+         fc::optional<signature_type> sig = kw.second->try_sign_digest(digest, kw.first);
+         if (!sig) {
+            EOS_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", kw.first));
+         }
+         stxn.signatures.push_back(*sig);
+      }
+   };
+
+   // soft wallets keep keys in memory and don't change them while the batch is signed,
+   // other wallets (SecureEnclave, YubiHSM) talk to devices and are used only from this thread
+   auto is_soft = [](const key_wallets& kws) {
+      return std::all_of(kws.begin(), kws.end(), [](const auto& kw) {
+         return dynamic_cast<soft_wallet*>(kw.second) != nullptr;
+      });
+   };
+
+   std::vector<std::future<void>> tasks;
+   auto wait_tasks = fc::make_scoped_exit([&tasks]() {
+      // tasks refer to the result, they should be finished even on an exception
+      for (auto& f : tasks) {
+         if (f.valid()) f.wait();
+      }
+   });
+
+   std::vector<size_t> sequential;
+   for (size_t i = 0; i < result.size(); ++i) {
+      if (signing_thread_pool && result.size() > 1 && is_soft(signers[i])) {
+         tasks.emplace_back(chain::async_thread_pool(*signing_thread_pool, [&sign, &stxn = result[i], &kws = signers[i]]() {
+            sign(stxn, kws);
+         }));
+      } else {
+         sequential.push_back(i);
+      }
+   }
+
+   for (auto i : sequential) {
+      sign(result[i], signers[i]);
+   }
+   for (auto& f : tasks) {
+      f.get();
+   }
+
+   return result;
+}
+
 chain::signature_type
 wallet_manager::sign_digest(const chain::digest_type& digest, const public_key_type& key) {
    check_timeout();
 
    try {
-      for (const auto& i : wallets) {
-         if (!i.second->is_locked()) {
-            fc::optional<signature_type> sig = i.second->try_sign_digest(digest, key);
-            if (sig)
-               return *sig;
-         }
-      }
+      fc::optional<signature_type> sig = try_sign_digest(digest, key);
+      if (sig)
+         return *sig;
    } FC_LOG_AND_RETHROW();
 
    EOS_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", key));
@@ -274,6 +353,46 @@ void wallet_manager::own_and_use_wallet(const string& name, std::unique_ptr<wall
    if(wallets.find(name) != wallets.end())
       EOS_THROW(wallet_exception, "Tried to use wallet name that already exists.");
    wallets.emplace(name, std::move(wallet));
+   reset_key_index();
+}
+
+wallet_api* wallet_manager::find_key_wallet(const public_key_type& key) {
+   if (!key_index_valid) {
+      key_index.clear();
+      for (const auto& i : wallets) {
+         if (!i.second->is_locked()) {
+            for (const auto& k : i.second->list_public_keys()) {
+               key_index.emplace(k, i.second.get());
+            }
+         }
+      }
+      key_index_valid = true;
+   }
+
+   auto itr = key_index.find(key);
+   if (itr == key_index.end()) {
+      return nullptr;
+   }
+   return itr->second;
+}
+
+fc::optional<signature_type> wallet_manager::try_sign_digest(const chain::digest_type& digest, const public_key_type& key) {
+   auto w = find_key_wallet(key);
+   if (w) {
+      fc::optional<signature_type> sig = w->try_sign_digest(digest, key);
+      if (sig)
+         return sig;
+   }
+
+   // the indexed wallet can refuse to sign (e.g. a device wallet lost its key), try all unlocked wallets as before
+   for (const auto& i : wallets) {
+      if (!i.second->is_locked() && i.second.get() != w) {
+         fc::optional<signature_type> sig = i.second->try_sign_digest(digest, key);
+         if (sig)
+            return sig;
+      }
+   }
+   return fc::optional<signature_type>();
 }
 
 void wallet_manager::start_lock_watch(std::shared_ptr<boost::asio::deadline_timer> t)
@@ -0,0 +1,420 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#include <eosio/chain/config.hpp>
+#include <eosio/chain/transaction_object.hpp>
+
+#include <cyberway/chaindb/controller.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace eosio::chain;
+using cyberway::chaindb::chaindb_controller;
+using cyberway::chaindb::chaindb_session;
+using cyberway::chaindb::chaindb_type;
+using cyberway::chaindb::primary_key_t;
+namespace bfs = boost::filesystem;
+namespace bpo = boost::program_options;
+using bpo::options_description;
+using bpo::variables_map;
+
+/**
+ * Latencies of single operations of a workload.
+ *
+ * All samples are kept, so percentiles are exact, the workloads are sized to make it cheap.
+ */
+class latency_stats {
+public:
+   template<typename Op>
+   void measure(Op&& op) {
+      auto start = std::chrono::steady_clock::now();
+      op();
+      add(std::chrono::steady_clock::now() - start);
+   }
+
+   void add(std::chrono::steady_clock::duration d) {
+      samples_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+   }
+
+   fc::variant to_variant() {
+      std::sort(samples_.begin(), samples_.end());
+      uint64_t total = 0;
+      for (auto ns: samples_) total += ns;
+
+      auto percentile = [&](uint32_t p) -> uint64_t {
+         if (samples_.empty()) return 0;
+         return samples_[std::min<size_t>(samples_.size() - 1, samples_.size() * p / 100)];
+      };
+
+      return fc::mutable_variant_object()
+         ("ops",            samples_.size())
+         ("total_ns",       total)
+         ("ops_per_sec",    total ? double(samples_.size()) * 1e9 / double(total) : 0.0)
+         ("p50_ns",         percentile(50))
+         ("p90_ns",         percentile(90))
+         ("p99_ns",         percentile(99))
+         ("max_ns",         samples_.empty() ? 0 : samples_.back());
+   }
+
+private:
+   std::vector<uint64_t> samples_;
+};
+
+struct bench_config {
+   string                    address;
+   string                    sys_name;
+   uint64_t                  seed            = 0;
+   uint32_t                  records         = 0;
+   uint32_t                  operations      = 0;
+   uint32_t                  ops_per_revision = 0;
+   uint32_t                  scan_length     = 0;
+   uint32_t                  undo_depth      = 0;
+   uint64_t                  cache_ram_size  = 0;
+   std::vector<uint32_t>     flush_sizes;
+   std::vector<string>       workloads;
+};
+
+/**
+ * Runs the workloads against one chaindb driver.
+ *
+ * Workloads use the table of transaction_object: it is a system table with a primary and
+ * two secondary indexes, and its rows are small, so the numbers reflect the costs of chaindb
+ * itself and not of the (de)serialization of large objects.
+ */
+class chaindb_bench {
+public:
+   chaindb_bench(const bench_config& cfg, chaindb_type type)
+   : cfg_(cfg), chaindb_(type, cfg.address, cfg.sys_name), rnd_(cfg.seed) {
+   }
+
+   fc::variant run() {
+      // initialize_db() drops the existing database, so it is dropped both before and after the run
+      chaindb_.initialize_db();
+      chaindb_.set_revision(1);
+
+      fc::mutable_variant_object results;
+      try {
+         for (auto& name: cfg_.workloads) {
+            ilog("running workload '${w}'", ("w", name));
+            results(name, run_workload(name));
+         }
+      } catch (...) {
+         chaindb_.drop_db();
+         throw;
+      }
+
+      chaindb_.drop_db();
+      return results;
+   }
+
+private:
+   fc::variant run_workload(const string& name) {
+      if (name == "insert")         return insert();
+      if (name == "point-lookup")   return point_lookup();
+      if (name == "range-scan")     return range_scan();
+      if (name == "mixed")          return mixed();
+      if (name == "undo")           return undo();
+      if (name == "cache-pressure") return cache_pressure();
+      if (name == "flush")          return flush();
+      EOS_THROW(fc::invalid_arg_exception, "Unknown workload '${w}'", ("w", name));
+   }
+
+   transaction_id_type next_trx_id() {
+      auto n = trx_counter_++;
+      return fc::sha256::hash(reinterpret_cast<const char*>(&n), sizeof(n));
+   }
+
+   primary_key_t random_pk() {
+      return pks_[std::uniform_int_distribution<size_t>(0, pks_.size() - 1)(rnd_)];
+   }
+
+   void emplace_row() {
+      auto& obj = chaindb_.emplace<transaction_object>([&](transaction_object& o) {
+         o.trx_id     = next_trx_id();
+         o.expiration = time_point_sec(static_cast<uint32_t>(trx_counter_));
+      });
+      pks_.push_back(obj.id._id);
+   }
+
+   /** Every revision is pushed, flushed and committed, like a block which becomes irreversible at once */
+   template<typename Op>
+   void in_revisions(uint32_t count, Op&& op) {
+      for (uint32_t done = 0; done < count;) {
+         auto session = chaindb_.start_undo_session(true);
+         auto end = std::min(count, done + cfg_.ops_per_revision);
+         for (; done < end; ++done) {
+            op();
+         }
+         session.push();
+         chaindb_.apply_all_changes();
+         chaindb_.commit_revision(session.revision());
+      }
+   }
+
+   void ensure_records() {
+      if (pks_.size() < cfg_.records) {
+         in_revisions(cfg_.records - pks_.size(), [&]{ emplace_row(); });
+      }
+   }
+
+   fc::variant insert() {
+      latency_stats stats;
+      in_revisions(cfg_.records, [&]{ stats.measure([&]{ emplace_row(); }); });
+      return stats.to_variant();
+   }
+
+   fc::variant point_lookup() {
+      ensure_records();
+      latency_stats by_pk, by_id;
+      for (uint32_t i = 0; i < cfg_.operations; ++i) {
+         auto pk = random_pk();
+         const transaction_object* obj = nullptr;
+         by_pk.measure([&]{ obj = chaindb_.find<transaction_object>(pk); });
+         EOS_ASSERT(obj, fc::assert_exception, "Row ${pk} not found", ("pk", pk));
+
+         auto trx_id = obj->trx_id;
+         by_id.measure([&]{ obj = chaindb_.find<transaction_object, by_trx_id>(trx_id); });
+      }
+      return fc::mutable_variant_object()
+         ("primary",   by_pk.to_variant())
+         ("secondary", by_id.to_variant());
+   }
+
+   fc::variant range_scan() {
+      ensure_records();
+      latency_stats primary, secondary;
+      auto table = chaindb_.get_table<transaction_object>();
+      auto index = chaindb_.get_index<transaction_object, by_trx_id>();
+      for (uint32_t i = 0; i < cfg_.operations / cfg_.scan_length + 1; ++i) {
+         auto pk = random_pk();
+         primary.measure([&]{
+            auto itr = table.lower_bound(pk);
+            for (uint32_t n = 0; n < cfg_.scan_length && table.end() != itr; ++n, ++itr) {}
+         });
+
+         auto trx_id = next_trx_id();
+         secondary.measure([&]{
+            auto itr = index.lower_bound(trx_id);
+            for (uint32_t n = 0; n < cfg_.scan_length && index.end() != itr; ++n, ++itr) {}
+         });
+      }
+      return fc::mutable_variant_object()
+         ("scan_length", cfg_.scan_length)
+         ("primary",     primary.to_variant())
+         ("secondary",   secondary.to_variant());
+   }
+
+   /** 50% updates, 25% inserts, 25% removes */
+   fc::variant mixed() {
+      ensure_records();
+      latency_stats inserts, updates, removes;
+      in_revisions(cfg_.operations, [&]{
+         auto kind = std::uniform_int_distribution<uint32_t>(0, 3)(rnd_);
+         if (kind == 0 || pks_.size() < 2) {
+            inserts.measure([&]{ emplace_row(); });
+         } else if (kind == 1) {
+            auto pos = std::uniform_int_distribution<size_t>(0, pks_.size() - 1)(rnd_);
+            auto pk  = pks_[pos];
+            pks_[pos] = pks_.back();
+            pks_.pop_back();
+            removes.measure([&]{ chaindb_.erase<transaction_object>(pk); });
+         } else {
+            auto pk = random_pk();
+            updates.measure([&]{
+               auto& obj = chaindb_.get<transaction_object>(pk);
+               chaindb_.modify(obj, [&](transaction_object& o) { o.expiration += 1; });
+            });
+         }
+      });
+      return fc::mutable_variant_object()
+         ("insert", inserts.to_variant())
+         ("update", updates.to_variant())
+         ("remove", removes.to_variant());
+   }
+
+   void modify_random_rows(uint32_t count) {
+      for (uint32_t i = 0; i < count; ++i) {
+         auto& obj = chaindb_.get<transaction_object>(random_pk());
+         chaindb_.modify(obj, [&](transaction_object& o) { o.expiration += 1; });
+      }
+   }
+
+   /** Nested sessions of undo-depth updates: start, squash into the parent, undo the parent */
+   fc::variant undo() {
+      ensure_records();
+      latency_stats start, squash, undo;
+      for (uint32_t i = 0; i < cfg_.operations / cfg_.undo_depth + 1; ++i) {
+         fc::optional<chaindb_session> parent;
+         start.measure([&]{ parent = chaindb_.start_undo_session(true); });
+         modify_random_rows(cfg_.undo_depth);
+
+         {
+            fc::optional<chaindb_session> child;
+            start.measure([&]{ child = chaindb_.start_undo_session(true); });
+            modify_random_rows(cfg_.undo_depth);
+            squash.measure([&]{ child->squash(); });
+         }
+
+         undo.measure([&]{ parent->undo(); });
+      }
+      return fc::mutable_variant_object()
+         ("undo_depth", cfg_.undo_depth)
+         ("start",      start.to_variant())
+         ("squash",     squash.to_variant())
+         ("undo",       undo.to_variant());
+   }
+
+   /** Random lookups over all rows with the cache limited to cache-ram-size */
+   fc::variant cache_pressure() {
+      ensure_records();
+      chaindb_.set_subjective_ram(cfg_.cache_ram_size, cfg_.cache_ram_size / 2, 0);
+
+      latency_stats lookups;
+      in_revisions(cfg_.operations, [&]{
+         auto pk = random_pk();
+         lookups.measure([&]{
+            auto& obj = chaindb_.get<transaction_object>(pk);
+            chaindb_.modify(obj, [&](transaction_object& o) { o.expiration += 1; });
+         });
+      });
+      chaindb_.set_subjective_ram(config::default_ram_size, config::default_reserved_ram_size, 0);
+
+      return fc::mutable_variant_object()
+         ("cache_ram_size", cfg_.cache_ram_size)
+         ("lookup",         lookups.to_variant());
+   }
+
+   /** Latency of apply_all_changes() depending on the number of pending changes */
+   fc::variant flush() {
+      ensure_records();
+      fc::mutable_variant_object result;
+      for (auto size: cfg_.flush_sizes) {
+         latency_stats flushes;
+         for (uint32_t i = 0; i < std::max<uint32_t>(1, cfg_.operations / size); ++i) {
+            auto session = chaindb_.start_undo_session(true);
+            modify_random_rows(size);
+            session.push();
+            flushes.measure([&]{ chaindb_.apply_all_changes(); });
+            chaindb_.commit_revision(session.revision());
+         }
+         result(std::to_string(size), flushes.to_variant());
+      }
+      return result;
+   }
+
+   const bench_config&          cfg_;
+   chaindb_controller           chaindb_;
+   std::mt19937_64              rnd_;
+   std::vector<primary_key_t>   pks_;
+   uint64_t                     trx_counter_ = 0;
+};
+
+void set_program_options(options_description& cli, bench_config& cfg) {
+   cli.add_options()
+         ("chaindb_type", bpo::value<std::vector<chaindb_type>>()->composing()->multitoken()
+                             ->default_value({chaindb_type::MongoDB}, "MongoDB"),
+          "Type of chaindb driver to benchmark (may specify multiple times)")
+         ("chaindb_address", bpo::value<string>(&cfg.address)->default_value("mongodb://127.0.0.1:27017"),
+          "Connection address to chaindb")
+         ("chaindb_sys_name", bpo::value<string>(&cfg.sys_name)->default_value("_CYBERWAY_BENCH_"),
+          "Name of the system database to benchmark in. It is DROPPED before and after the run, "
+          "so never point it to the database of a node.")
+         ("workload,w", bpo::value<std::vector<string>>(&cfg.workloads)->composing()->multitoken()
+                           ->default_value({"insert", "point-lookup", "range-scan", "mixed", "undo", "cache-pressure", "flush"},
+                                           "all"),
+          "Workloads to run: insert, point-lookup, range-scan, mixed, undo, cache-pressure, flush")
+         ("seed", bpo::value<uint64_t>(&cfg.seed)->default_value(42),
+          "Seed of the random generator, runs with the same seed execute the same operations")
+         ("records", bpo::value<uint32_t>(&cfg.records)->default_value(100000),
+          "Number of rows in the table")
+         ("operations", bpo::value<uint32_t>(&cfg.operations)->default_value(100000),
+          "Number of operations of each workload")
+         ("ops-per-revision", bpo::value<uint32_t>(&cfg.ops_per_revision)->default_value(1000),
+          "Number of changes in one undo revision")
+         ("scan-length", bpo::value<uint32_t>(&cfg.scan_length)->default_value(100),
+          "Number of rows in one range scan")
+         ("undo-depth", bpo::value<uint32_t>(&cfg.undo_depth)->default_value(100),
+          "Number of updates in one undo session")
+         ("cache-ram-size", bpo::value<uint64_t>(&cfg.cache_ram_size)->default_value(4*1024*1024),
+          "Size of RAM for the cache-pressure workload")
+         ("flush-size", bpo::value<std::vector<uint32_t>>(&cfg.flush_sizes)->composing()->multitoken()
+                           ->default_value({16, 256, 4096}, "16 256 4096"),
+          "Numbers of pending changes for the flush workload")
+         ("output-file,o", bpo::value<bfs::path>(),
+          "the file to write JSON results to. If not specified then output is to stdout.")
+         ("help", "Print this help message and exit.")
+         ;
+}
+
+int main(int argc, char** argv)
+{
+   options_description cli ("chaindb-bench command line options");
+   try {
+      bench_config cfg;
+      set_program_options(cli, cfg);
+      variables_map vmap;
+      bpo::store(bpo::parse_command_line(argc, argv, cli), vmap);
+      bpo::notify(vmap);
+      if (vmap.count("help") > 0) {
+        cli.print(std::cerr);
+        return 0;
+      }
+
+      EOS_ASSERT(cfg.records > 0 && cfg.operations > 0 && cfg.ops_per_revision > 0 &&
+                 cfg.scan_length > 0 && cfg.undo_depth > 0, fc::invalid_arg_exception,
+                 "records, operations, ops-per-revision, scan-length and undo-depth should be positive");
+      for (auto size: cfg.flush_sizes) {
+         EOS_ASSERT(size > 0, fc::invalid_arg_exception, "flush-size should be positive");
+      }
+
+      fc::mutable_variant_object drivers;
+      for (auto type: vmap.at("chaindb_type").as<std::vector<chaindb_type>>()) {
+         std::ostringstream name;
+         name << type;
+         ilog("benchmarking chaindb driver ${d}", ("d", name.str()));
+         drivers(name.str(), chaindb_bench(cfg, type).run());
+      }
+
+      auto result = fc::mutable_variant_object()
+         ("seed",             cfg.seed)
+         ("records",          cfg.records)
+         ("operations",       cfg.operations)
+         ("ops_per_revision", cfg.ops_per_revision)
+         ("drivers",          std::move(drivers));
+
+      auto json = fc::json::to_pretty_string(result);
+      if (vmap.count("output-file")) {
+         std::ofstream out(vmap.at("output-file").as<bfs::path>().generic_string());
+         out << json << std::endl;
+      } else {
+         std::cout << json << std::endl;
+      }
+   } catch( const fc::exception& e ) {
+      elog( "${e}", ("e", e.to_detail_string()));
+      return -1;
+   } catch( const boost::exception& e ) {
+      elog("${e}", ("e",boost::diagnostic_information(e)));
+      return -1;
+   } catch( const std::exception& e ) {
+      elog("${e}", ("e",e.what()));
+      return -1;
+   } catch( ... ) {
+      elog("unknown exception");
+      return -1;
+   }
+
+   return 0;
+}
@@ -3665,6 +3665,49 @@ int main( int argc, char** argv ) {
       std::cout << fc::json::to_pretty_string(v) << std::endl;
    });
 
+   // sign transactions in batch
+   string trxs_json_to_sign;
+   string batch_chain_id;
+   auto signTrxsWallet = wallet->add_subcommand("sign_transactions", localized("Sign a batch of transactions with keys from unlocked wallets"), false);
+   signTrxsWallet->add_option("transactions", trxs_json_to_sign,
+                              localized("The JSON string or filename defining the array of transactions to sign"), true)->required();
+   signTrxsWallet->add_option("-c,--chain-id", batch_chain_id, localized("The chain id that will be used to sign the transactions"));
+   signTrxsWallet->set_callback([&] {
+      auto trxs = json_from_file_or_string(trxs_json_to_sign).as<vector<signed_transaction>>();
+
+      chain_id_type chain_id = batch_chain_id.empty() ? get_info().chain_id : chain_id_type(batch_chain_id);
+
+      const auto& public_keys = call(wallet_url, wallet_public_keys);
+      fc::variants requests;
+      requests.reserve(trxs.size());
+      // required keys depend only on the actions and their authorizations,
+      //   so get_required_keys is called once per distinct set of them instead of once per transaction
+      std::map<string, fc::variant> required_keys_cache;
+      for (const auto& trx : trxs) {
+         fc::variants auths;
+         auths.reserve(trx.context_free_actions.size() + trx.actions.size());
+         for (const auto* acts : {&trx.context_free_actions, &trx.actions}) {
+            for (const auto& a : *acts) {
+               auths.emplace_back(fc::variants{fc::variant(a.account), fc::variant(a.name), fc::variant(a.authorization)});
+            }
+         }
+         auto auths_key = fc::json::to_string(auths);
+         auto itr = required_keys_cache.find(auths_key);
+         if (itr == required_keys_cache.end()) {
+            auto get_arg = fc::mutable_variant_object
+                    ("transaction", (transaction)trx)
+                    ("available_keys", public_keys);
+            const auto& required_keys = call(get_required_keys, get_arg);
+            itr = required_keys_cache.emplace(std::move(auths_key), required_keys["required_keys"]).first;
+         }
+         requests.emplace_back(fc::variants{fc::variant(trx), itr->second});
+      }
+
+      fc::variants sign_args = {fc::variant(requests), fc::variant(chain_id)};
+      const auto& v = call(wallet_url, wallet_sign_trxs, sign_args);
+      std::cout << fc::json::to_pretty_string(v) << std::endl;
+   });
+
    auto stopKeosd = wallet->add_subcommand("stop", localized("Stop keosd."), false);
    stopKeosd->set_callback([] {
       const auto& v = call(wallet_url, keosd_stop);
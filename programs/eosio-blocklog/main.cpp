@@ -27,11 +27,15 @@ struct blocklog {
    {}
 
    void read_log();
+   void convert_log();
    void set_program_options(options_description& cli);
    void initialize(const variables_map& options);
 
    bfs::path                        blocks_dir;
+   block_log_config                 blocks_config;
    bfs::path                        output_file;
+   bfs::path                        convert_dir;
+   block_log_config                 convert_config;
    uint32_t                         first_block;
    uint32_t                         last_block;
    bool                             no_pretty_print;
@@ -39,12 +43,13 @@ struct blocklog {
 };
 
 void blocklog::read_log() {
-   block_log block_logger(blocks_dir);
+   block_log block_logger(blocks_dir, blocks_config);
    const auto end = block_logger.read_head();
    EOS_ASSERT( end, block_log_exception, "No blocks found in block log" );
-   EOS_ASSERT( end->block_num() > 1, block_log_exception, "Only one block found in block log" );
+   EOS_ASSERT( end->block_num() > block_logger.first_block_num(), block_log_exception, "Only one block found in block log" );
 
-   ilog( "existing block log contains block num 1 through block num ${n}", ("n",end->block_num()) );
+   ilog( "existing block log contains block num ${f} through block num ${n}",
+         ("f",block_logger.first_block_num())("n",end->block_num()) );
 
    optional<chainbase::database> reversible_blocks;
    try {
@@ -85,7 +90,7 @@ void blocklog::read_log() {
 
    if (as_json_array)
       *out << "[";
-   uint32_t block_num = (first_block < 1) ? 1 : first_block;
+   uint32_t block_num = std::max(first_block, block_logger.first_block_num());
    signed_block_ptr next;
    fc::variant pretty_output;
    const fc::microseconds deadline = fc::seconds(10);
@@ -130,11 +135,46 @@ void blocklog::read_log() {
       *out << "]";
 }
 
+void blocklog::convert_log() {
+   EOS_ASSERT( !bfs::exists(convert_dir / "blocks.log"), block_log_exception,
+               "Block log already exists in '${dir}'", ("dir", convert_dir.generic_string()) );
+   bfs::create_directories(convert_dir);
+
+   block_log src(blocks_dir, blocks_config);
+   const auto end = src.read_head();
+   EOS_ASSERT( end, block_log_exception, "No blocks found in block log" );
+
+   const uint32_t start_num = std::max(first_block, src.first_block_num());
+   const uint32_t end_num = std::min(last_block, end->block_num());
+   uint32_t block_num = start_num;
+
+   ilog( "converting block num ${f} through block num ${l} to '${dir}'",
+         ("f",block_num)("l",end_num)("dir",convert_dir.generic_string()) );
+
+   block_log dst(convert_dir, convert_config);
+   for (; block_num <= end_num; ++block_num) {
+      auto next = src.read_block_by_num(block_num);
+      EOS_ASSERT( next, block_log_exception, "Block ${n} not found in block log", ("n",block_num) );
+      if (block_num == start_num) {
+         dst.reset(genesis_state(), next, block_num);
+      } else {
+         dst.append(next);
+      }
+      if (block_num % 100000 == 0) {
+         ilog( "converted ${n} of ${l}", ("n",block_num)("l",end_num) );
+      }
+   }
+   dst.flush();
+   ilog( "converted ${n} blocks", ("n",end_num - start_num + 1) );
+}
+
 void blocklog::set_program_options(options_description& cli)
 {
    cli.add_options()
          ("blocks-dir", bpo::value<bfs::path>()->default_value("blocks"),
           "the location of the blocks directory (absolute path or relative to the current directory)")
+         ("blocks-archive-dir", bpo::value<bfs::path>(),
+          "the location of the directory with archived segments of the block log (absolute path or relative to the current directory)")
          ("output-file,o", bpo::value<bfs::path>(),
           "the file to write the block log output to (absolute or relative path).  If not specified then output is to stdout.")
          ("first", bpo::value<uint32_t>(&first_block)->default_value(1),
@@ -145,6 +185,15 @@ void blocklog::set_program_options(options_description& cli)
           "Do not pretty print the output.  Useful if piping to jq to improve performance.")
          ("as-json-array", bpo::bool_switch(&as_json_array)->default_value(false),
           "Print out json blocks wrapped in json array (otherwise the output is free-standing json objects).")
+         ("convert-to", bpo::value<bfs::path>(),
+          "the blocks directory to write the converted block log to (absolute or relative path). "
+          "Blocks can be read from the raw or the compressed block log.")
+         ("segment-size", bpo::value<uint32_t>(&convert_config.segment_size)->default_value(0),
+          "the number of blocks in a closed segment of the converted block log (0 - one file for all blocks)")
+         ("compression", bpo::bool_switch(&convert_config.compression)->default_value(false),
+          "Compress closed segments of the converted block log (requires segment-size).")
+         ("chunk-size", bpo::value<uint32_t>(&convert_config.blocks_per_chunk)->default_value(block_log_config().blocks_per_chunk),
+          "the number of blocks in an independently compressed chunk of the converted block log")
          ("help", "Print this help message and exit.")
          ;
 
@@ -165,6 +214,22 @@ void blocklog::initialize(const variables_map& options) {
          else
             output_file = bld;
       }
+
+      if (options.count( "blocks-archive-dir" )) {
+         bld = options.at( "blocks-archive-dir" ).as<bfs::path>();
+         if( bld.is_relative())
+            blocks_config.archive_dir = bfs::current_path() / bld;
+         else
+            blocks_config.archive_dir = bld;
+      }
+
+      if (options.count( "convert-to" )) {
+         bld = options.at( "convert-to" ).as<bfs::path>();
+         if( bld.is_relative())
+            convert_dir = bfs::current_path() / bld;
+         else
+            convert_dir = bld;
+      }
    } FC_LOG_AND_RETHROW()
 
 }
@@ -185,7 +250,11 @@ int main(int argc, char** argv)
         return 0;
       }
       blog.initialize(vmap);
-      blog.read_log();
+      if (blog.convert_dir.empty()) {
+         blog.read_log();
+      } else {
+         blog.convert_log();
+      }
    } catch( const fc::exception& e ) {
       elog( "${e}", ("e", e.to_detail_string()));
       return -1;
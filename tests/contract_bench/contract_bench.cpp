@@ -0,0 +1,284 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <boost/test/unit_test.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/wasm_interface.hpp>
+
+#include <eosio.token/eosio.token.wast.hpp>
+#include <eosio.token/eosio.token.abi.hpp>
+
+#include <multi_index_test/multi_index_test.wast.hpp>
+#include <multi_index_test/multi_index_test.abi.hpp>
+
+#include <test_api/test_api.wast.hpp>
+#include <test_api/test_api_common.hpp>
+
+#include "test_softfloat_wasts.hpp"
+
+#include <fc/variant_object.hpp>
+#include <fc/io/json.hpp>
+
+/**
+ * Micro-benchmarks of contract execution.
+ *
+ * Each test case runs a canned workload on the WASM runtime selected by the --wavm/--wabt argument
+ * (as unit_test does) and reports the wall time of the executed actions, the cost of module
+ * instantiations and the number of calls of each intrinsic. Run it as:
+ *
+ *    contract_bench -- --wabt [--iterations=N] [--report=file.json]
+ *
+ * The results of all workloads are printed to stdout and written to the report file in JSON.
+ * It is built only with -DENABLE_CONTRACT_BENCH=ON, which also enables the intrinsic call counters.
+ */
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+using namespace fc;
+
+namespace {
+
+   constexpr uint32_t default_iterations = 100;
+
+   string get_argument(const string& prefix, const string& def) {
+      const auto& suite = boost::unit_test::framework::master_test_suite();
+      for (int i = 0; i < suite.argc; ++i) {
+         string arg = suite.argv[i];
+         if (boost::algorithm::starts_with(arg, prefix)) return arg.substr(prefix.size());
+      }
+      return def;
+   }
+
+   uint32_t get_iterations() {
+      return std::stoul(get_argument("--iterations=", std::to_string(default_iterations)));
+   }
+
+   /// results of all workloads, they are written by the global fixture at exit
+   fc::variants& bench_results() {
+      static fc::variants results;
+      return results;
+   }
+
+   struct bench_report {
+      ~bench_report() {
+         auto file = get_argument("--report=", "");
+         if (file.empty() || bench_results().empty()) return;
+
+         fc::json::save_to_file(bench_results(), file, true);
+         std::cout << "Report is written to '" << file << "'" << std::endl;
+      }
+   };
+
+   template<uint64_t NAME>
+   struct test_api_action {
+      static account_name get_account() {
+         return N(testapi);
+      }
+
+      static action_name get_name() {
+         return action_name(NAME);
+      }
+   };
+
+} // namespace
+
+FC_REFLECT_TEMPLATE((uint64_t T), test_api_action<T>, BOOST_PP_SEQ_NIL)
+
+BOOST_GLOBAL_FIXTURE(bench_report);
+
+class bench_tester: public tester {
+public:
+   bench_tester()
+   : iterations(get_iterations()) {
+      produce_blocks(2);
+   }
+
+   /**
+    * Runs the workload for the given number of iterations and records its statistics.
+    * @param push - pushes transactions of one iteration and returns their traces
+    * @param rollback - discards changes of each iteration, for workloads which can't be repeated on the same state
+    */
+   template<typename Push>
+   void run(const string& workload, Push&& push, bool rollback = false) {
+      auto& wasm = control->get_wasm_interface();
+      const auto stats = wasm.get_statistics();
+      const auto calls = wasm_interface::get_intrinsic_call_counts();
+
+      uint64_t actions = 0;
+      int64_t  action_us = 0;
+      int64_t  max_action_us = 0;
+
+      std::function<void(const action_trace&)> add_action = [&](const action_trace& act) {
+         ++actions;
+         action_us += act.elapsed.count();
+         max_action_us = std::max(max_action_us, act.elapsed.count());
+         for (const auto& inline_act: act.inline_traces) {
+            add_action(inline_act);
+         }
+      };
+
+      for (uint32_t i = 0; i < iterations; ++i) {
+         for (const auto& trace: push()) {
+            BOOST_REQUIRE_EQUAL(trace->receipt->status, transaction_receipt::executed);
+            for (const auto& act: trace->action_traces) {
+               add_action(act);
+            }
+         }
+         if (rollback) {
+            produce_empty_block();
+         } else {
+            produce_block();
+         }
+      }
+
+      const auto& end_stats = wasm.get_statistics();
+      fc::mutable_variant_object call_deltas;
+      for (const auto& c: wasm_interface::get_intrinsic_call_counts()) {
+         auto itr = calls.find(c.first);
+         auto delta = c.second - (itr != calls.end() ? itr->second : 0);
+         if (delta) call_deltas(c.first, delta);
+      }
+
+      fc::mutable_variant_object result;
+      result
+         ("workload", workload)
+         ("runtime", cfg.wasm_runtime)
+         ("iterations", iterations)
+         ("actions", actions)
+         ("action_us", action_us)
+         ("avg_action_us", actions ? double(action_us) / actions : 0.0)
+         ("max_action_us", max_action_us)
+         ("instantiations", end_stats.instantiations - stats.instantiations)
+         ("instantiation_us", (end_stats.instantiation_time - stats.instantiation_time).count())
+         ("intrinsic_calls", std::move(call_deltas));
+
+      std::cout << fc::json::to_pretty_string(result) << std::endl;
+      bench_results().emplace_back(std::move(result));
+   }
+
+   transaction_trace_ptr push_action(action act, const account_name& signer) {
+      signed_transaction trx;
+      trx.actions.emplace_back(std::move(act));
+      set_transaction_headers(trx);
+      trx.sign(get_private_key(signer, "active"), control->get_chain_id());
+      return push_transaction(trx);
+   }
+
+   const uint32_t iterations;
+};
+
+BOOST_AUTO_TEST_SUITE(contract_bench)
+
+BOOST_FIXTURE_TEST_CASE( token_transfer, bench_tester ) try {
+   create_accounts({config::token_account_name, N(alice), N(bob)});
+   set_code(config::token_account_name, eosio_token_wast);
+   set_abi(config::token_account_name, eosio_token_abi);
+   produce_block();
+
+   abi_serializer abi_ser(json::from_string(eosio_token_abi).as<abi_def>(), abi_serializer_max_time);
+   auto token_action = [&](const account_name& signer, const action_name& name, const variant_object& data) {
+      action act;
+      act.account = config::token_account_name;
+      act.name = name;
+      act.authorization = vector<permission_level>{{signer, config::active_name}};
+      act.data = abi_ser.variant_to_binary(abi_ser.get_action_type(name), data, abi_serializer_max_time);
+      return push_action(std::move(act), signer);
+   };
+
+   token_action(config::token_account_name, N(create), mutable_variant_object()
+      ("issuer",         config::token_account_name)
+      ("maximum_supply", "1000000000.0000 CUR"));
+   token_action(config::token_account_name, N(issue), mutable_variant_object()
+      ("to",       N(alice))
+      ("quantity", "1000000.0000 CUR")
+      ("memo",     ""));
+   produce_block();
+
+   run("token_transfer", [&]() {
+      return vector<transaction_trace_ptr>{
+         token_action(N(alice), N(transfer), mutable_variant_object()
+            ("from",     N(alice))
+            ("to",       N(bob))
+            ("quantity", "1.0000 CUR")
+            ("memo",     "bench")),
+         token_action(N(bob), N(transfer), mutable_variant_object()
+            ("from",     N(bob))
+            ("to",       N(alice))
+            ("quantity", "1.0000 CUR")
+            ("memo",     "bench"))
+      };
+   });
+} FC_LOG_AND_RETHROW()
+
+// The multi_index_test contract fills tables with the fixed primary keys, so each iteration is rolled back
+BOOST_FIXTURE_TEST_CASE( multi_index_scan, bench_tester ) try {
+   create_accounts({N(multitest)});
+   set_code(N(multitest), multi_index_test_wast);
+   set_abi(N(multitest), multi_index_test_abi);
+   produce_block();
+
+   abi_serializer abi_ser(json::from_string(multi_index_test_abi).as<abi_def>(), abi_serializer_max_time);
+   auto trigger = [&](uint32_t what) {
+      action act;
+      act.account = N(multitest);
+      act.name = N(trigger);
+      act.authorization = vector<permission_level>{{N(multitest), config::active_name}};
+      act.data = abi_ser.variant_to_binary("trigger", mutable_variant_object()("what", what), abi_serializer_max_time);
+      return act;
+   };
+
+   run("multi_index_scan", [&]() {
+      signed_transaction trx;
+      trx.actions.emplace_back(trigger(0));
+      trx.actions.emplace_back(trigger(1));
+      set_transaction_headers(trx);
+      trx.sign(get_private_key(N(multitest), "active"), control->get_chain_id());
+      return vector<transaction_trace_ptr>{push_transaction(trx)};
+   }, true);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( softfloat, bench_tester ) try {
+   create_accounts({N(floats), N(doubles)});
+   set_code(N(floats), f32_test_wast);
+   set_code(N(doubles), f64_test_wast);
+   produce_block();
+
+   auto float_action = [&](const account_name& account) {
+      action act;
+      act.account = account;
+      act.name = N();
+      act.authorization = vector<permission_level>{{account, config::active_name}};
+      return push_action(std::move(act), account);
+   };
+
+   run("softfloat", [&]() {
+      return vector<transaction_trace_ptr>{float_action(N(floats)), float_action(N(doubles))};
+   });
+} FC_LOG_AND_RETHROW()
+
+// Inline actions and notifications of the test_api contract: send_action dispatches an inline action,
+// require_notice_tests bounces notifications between testapi and acc5
+BOOST_FIXTURE_TEST_CASE( inline_and_notifications, bench_tester ) try {
+   create_accounts({N(testapi), N(acc5)});
+   set_code(N(testapi), test_api_wast);
+   set_code(N(acc5), test_api_wast);
+   produce_block();
+
+   auto test_api_call = [&](auto ac) {
+      return push_action(action(vector<permission_level>{{N(testapi), config::active_name}}, ac), N(testapi));
+   };
+
+   run("inline_and_notifications", [&]() {
+      return vector<transaction_trace_ptr>{
+         test_api_call(test_api_action<WASM_TEST_ACTION("test_transaction", "send_action")>{}),
+         test_api_call(test_api_action<WASM_TEST_ACTION("test_action", "require_notice_tests")>{})
+      };
+   });
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
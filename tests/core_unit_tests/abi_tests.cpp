@@ -28,6 +28,9 @@
 #include <large_nested.abi.hpp>
 
 #include <cyberway/chain/cyberway_contract_types.hpp>
+#include <cyberway/chaindb/abi_info.hpp>
+#include <cyberway/chaindb/table_info.hpp>
+#include <cyberway/chaindb/abi_registry.hpp>
 
 using namespace eosio;
 using namespace chain;
@@ -2758,4 +2761,125 @@ BOOST_AUTO_TEST_CASE(serialize_optional_struct_type)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(copy_abi_info)
+{
+   auto abi = R"({
+      "version": "cyberway::abi/1.1",
+      "structs": [
+         {"name": "record", "base": "", "fields": [
+            {"name": "id", "type": "uint64"},
+            {"name": "owner", "type": "name"}
+         ]},
+      ],
+      "tables": [
+         {"name": "records", "type": "record", "indexes": [
+            {"name": "primary", "unique": true, "orders": [{"field": "id", "order": "asc"}]},
+            {"name": "byowner", "unique": false, "orders": [{"field": "owner", "order": "asc"}]}
+         ]}
+      ]
+   })";
+
+   try {
+      using cyberway::chaindb::abi_info;
+      const account_name code = N(test);
+
+      std::map<const cyberway::chaindb::account_name_t, const abi_info> abies;
+      {
+         abi_info src(code, fc::json::from_string(abi).as<abi_def>());
+         // snapshots keep abi_info by value
+         abies.emplace(code.value, src);
+      }
+      const auto& info = abies.at(code.value);
+
+      auto table = info.find_table(N(records));
+      BOOST_REQUIRE(table);
+      auto index = info.find_index(*table, N(byowner));
+      BOOST_REQUIRE(index);
+      BOOST_CHECK_EQUAL(index, &table->indexes[1]);
+
+      cyberway::chaindb::index_info idx(code.value, code.value);
+      idx.table = table;
+      idx.index = index;
+      auto key = info.to_bytes(idx, fc::mutable_variant_object("owner", "alice"));
+      BOOST_CHECK_EQUAL(fc::raw::unpack<name>(key), N(alice));
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(abi_registry_limits)
+{
+   auto abi = R"({
+      "version": "cyberway::abi/1.1",
+      "structs": [
+         {"name": "record", "base": "", "fields": [
+            {"name": "id", "type": "uint64"}
+         ]},
+      ],
+      "tables": [
+         {"name": "records", "type": "record", "indexes": [
+            {"name": "primary", "unique": true, "orders": [{"field": "id", "order": "asc"}]}
+         ]}
+      ]
+   })";
+
+   try {
+      using cyberway::chaindb::abi_registry;
+      auto& registry = abi_registry::instance();
+      const auto default_size = registry.max_size();
+      auto restore = fc::make_scoped_exit([&]() {
+         registry.clear();
+         registry.set_max_size(default_size);
+      });
+      registry.clear();
+
+      auto def = fc::json::from_string(abi).as<abi_def>();
+      const auto packed = fc::raw::pack(def);
+      def.structs[0].fields.push_back({"owner", "name"});
+      const auto packed2 = fc::raw::pack(def);
+      BOOST_REQUIRE(packed.size() < packed2.size());
+
+      registry.set_max_size(packed.size() * 2);
+
+      // the same ABI of a contract is parsed once
+      auto alice = registry.get(N(alice), packed);
+      BOOST_CHECK(alice == registry.get(N(alice), packed));
+      BOOST_CHECK_EQUAL(registry.size(), 1u);
+
+      // an ABI is shared only by the same contract
+      auto bob = registry.get(N(bob), packed);
+      BOOST_CHECK(alice != bob);
+      BOOST_CHECK_EQUAL(registry.size(), 2u);
+      BOOST_CHECK_EQUAL(registry.used_size(), packed.size() * 2);
+
+      // bob is the least recently used one, so it is released on overflow
+      BOOST_CHECK(alice == registry.get(N(alice), packed));
+      auto carol = registry.get(N(carol), packed);
+      BOOST_CHECK_EQUAL(registry.size(), 2u);
+      BOOST_CHECK_EQUAL(registry.used_size(), packed.size() * 2);
+      BOOST_CHECK(alice == registry.get(N(alice), packed));
+      BOOST_CHECK(carol == registry.get(N(carol), packed));
+
+      // a released ABI is still valid for its holders
+      BOOST_CHECK(bob->find_table(N(records)));
+
+      // a new version of an ABI is another entry, it releases both old ones to fit
+      auto alice2 = registry.get(N(alice), packed2);
+      BOOST_CHECK(alice2 != alice);
+      BOOST_CHECK_EQUAL(registry.size(), 1u);
+      BOOST_CHECK_EQUAL(registry.used_size(), packed2.size());
+
+      // shrinking the limit releases entries
+      registry.set_max_size(packed.size());
+      BOOST_CHECK_EQUAL(registry.size(), 0u);
+      BOOST_CHECK_EQUAL(registry.used_size(), 0u);
+
+      // an ABI larger than the limit is parsed, but isn't kept
+      auto dave = registry.get(N(dave), packed2);
+      BOOST_CHECK(dave && dave->find_table(N(records)));
+      BOOST_CHECK_EQUAL(registry.size(), 0u);
+      BOOST_CHECK(dave != registry.get(N(dave), packed2));
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1525,6 +1525,11 @@ BOOST_FIXTURE_TEST_CASE(crypto_tests, TESTER) { try {
 
    CALL_TEST_FUNCTION( *this, "test_crypto", "assert_ripemd160_true", {} );
 
+   CALL_TEST_FUNCTION( *this, "test_crypto", "test_hash_batch", {} );
+
+   CALL_TEST_FUNCTION_AND_CHECK_EXCEPTION( *this, "test_crypto", "hash_batch_out_of_data", {},
+                                           crypto_api_exception, "hash segment is out of the data buffer" );
+
    BOOST_REQUIRE_EQUAL( validate(), true );
 } FC_LOG_AND_RETHROW() }
 
@@ -0,0 +1,185 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <cyberway/chaindb/controller.hpp>
+#include <cyberway/chaindb/cache_map.hpp>
+
+#include <eosio.token/eosio.token.wast.hpp>
+#include <eosio.token/eosio.token.abi.hpp>
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+using cyberway::chaindb::cache_budget_config;
+using cyberway::chaindb::cache_budget_usage;
+
+namespace {
+
+   const std::string eosio_token = name(config::token_account_name).to_string();
+
+   struct budget_tester : tester {
+      vector<account_name> users;
+
+      budget_tester() {
+         create_account(config::token_account_name);
+         set_code(config::token_account_name, eosio_token_wast);
+         set_abi(config::token_account_name, eosio_token_abi);
+
+         push_action(config::token_account_name, N(create), config::token_account_name, fc::mutable_variant_object()
+            ("issuer",         eosio_token)
+            ("maximum_supply", "1000000.0000 CUR")
+         );
+         push_action(config::token_account_name, N(issue), config::token_account_name, fc::mutable_variant_object()
+            ("to",       eosio_token)
+            ("quantity", "1000.0000 CUR")
+            ("memo",     "")
+         );
+
+         for (char c = 'a'; c <= 'z'; ++c) {
+            users.emplace_back(std::string("user") + c);
+         }
+         create_accounts(users);
+         for (auto& user: users) {
+            transfer(config::token_account_name, user, "1.0000 CUR");
+         }
+         produce_blocks(2);
+      }
+
+      void transfer(account_name from, account_name to, const std::string& quantity) {
+         push_action(config::token_account_name, N(transfer), from, fc::mutable_variant_object()
+            ("from",     from)
+            ("to",       to)
+            ("quantity", quantity)
+            ("memo",     "")
+         );
+      }
+
+      asset get_balance(account_name account) const {
+         return get_currency_balance(config::token_account_name, symbol(SY(4,CUR)), account);
+      }
+
+      const cyberway::chaindb::cache_map& cache() const {
+         return control->chaindb().get_cache_map();
+      }
+
+      cache_budget_usage get_usage(const std::string& budget, account_name code = account_name()) const {
+         for (auto& usage: cache().usage().budgets) {
+            if (usage.budget == budget && usage.code == code.value) {
+               return usage;
+            }
+         }
+         BOOST_FAIL("No usage of the budget " + budget + " " + code.to_string());
+         return {};
+      }
+   };
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cache_budget_tests)
+
+BOOST_FIXTURE_TEST_CASE( contract_budget, budget_tester ) try {
+   const auto usage = cache().usage();
+   BOOST_CHECK(usage.used > 0);
+   for (auto& budget: usage.budgets) {
+      BOOST_CHECK(budget.budget != "total");
+   }
+
+   const auto before = get_usage("contract", config::token_account_name);
+   BOOST_REQUIRE(before.used > 0);
+   BOOST_CHECK_EQUAL(before.limit, 0u);
+   BOOST_CHECK_EQUAL(before.evicted_rows, 0u);
+
+   // rows of the contract are evicted down to its budget, when the states are committed
+   cache_budget_config config;
+   config.contract_sizes[config::token_account_name] = before.used / 4;
+   cache().set_budgets(config);
+   produce_blocks(2);
+
+   const auto after = get_usage("contract", config::token_account_name);
+   BOOST_CHECK_EQUAL(after.limit, before.used / 4);
+   BOOST_CHECK(after.used <= after.limit);
+   BOOST_CHECK(after.evicted_rows > 0);
+
+   // other budgets aren't affected
+   BOOST_CHECK_EQUAL(get_usage("system").evicted_rows, 0u);
+   BOOST_CHECK_EQUAL(get_usage("stake").evicted_rows, 0u);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( default_contract_budget, budget_tester ) try {
+   const auto before = get_usage("contract", config::token_account_name);
+
+   // the designated budget of another contract doesn't limit the token contract
+   cache_budget_config config;
+   config.contract_sizes[N(other)] = 1;
+   cache().set_budgets(config);
+   produce_blocks(2);
+   BOOST_CHECK_EQUAL(get_usage("contract", config::token_account_name).evicted_rows, 0u);
+
+   // the default budget is used for contracts without designated budgets
+   config.contract_size = before.used / 2;
+   cache().set_budgets(config);
+   produce_blocks(2);
+
+   const auto after = get_usage("contract", config::token_account_name);
+   BOOST_CHECK_EQUAL(after.limit, before.used / 2);
+   BOOST_CHECK(after.used <= after.limit);
+   BOOST_CHECK(after.evicted_rows > 0);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( reload_evicted_rows, budget_tester ) try {
+   const auto before = get_usage("contract", config::token_account_name);
+
+   cache_budget_config config;
+   config.contract_sizes[config::token_account_name] = before.used / 4;
+   cache().set_budgets(config);
+   produce_blocks(2);
+   BOOST_REQUIRE(get_usage("contract", config::token_account_name).evicted_rows > 0);
+
+   // evicted rows are loaded from the database
+   const auto misses = cache().stats().misses;
+   for (auto& user: users) {
+      BOOST_CHECK_EQUAL(get_balance(user), asset::from_string("1.0000 CUR"));
+   }
+   BOOST_CHECK(cache().stats().misses > misses);
+
+   // and they are changed as any other rows
+   for (auto& user: users) {
+      transfer(user, config::token_account_name, "1.0000 CUR");
+   }
+   produce_blocks(2);
+
+   for (auto& user: users) {
+      BOOST_CHECK_EQUAL(get_balance(user), asset::from_string("0.0000 CUR"));
+   }
+   BOOST_CHECK_EQUAL(get_balance(config::token_account_name), asset::from_string("1000.0000 CUR"));
+
+   const auto after = get_usage("contract", config::token_account_name);
+   BOOST_CHECK(after.used <= after.limit);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( system_budget, budget_tester ) try {
+   const auto before = get_usage("system");
+   BOOST_REQUIRE(before.used > 0);
+
+   cache_budget_config config;
+   config.system_size = before.used / 4;
+   cache().set_budgets(config);
+   produce_blocks(2);
+
+   const auto after = get_usage("system");
+   BOOST_CHECK(after.used <= after.limit);
+   BOOST_CHECK(after.evicted_rows > 0);
+   BOOST_CHECK_EQUAL(get_usage("contract", config::token_account_name).evicted_rows, 0u);
+
+   // the chain works with evicted accounts
+   for (auto& user: users) {
+      BOOST_CHECK(control->chaindb().find<account_object>(user.value) != nullptr);
+   }
+   create_accounts({N(alice)});
+   transfer(users.front(), N(alice), "1.0000 CUR");
+   produce_blocks(2);
+   BOOST_CHECK_EQUAL(get_balance(N(alice)), asset::from_string("1.0000 CUR"));
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
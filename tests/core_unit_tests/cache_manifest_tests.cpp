@@ -0,0 +1,142 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <cyberway/chaindb/controller.hpp>
+#include <cyberway/chaindb/cache_map.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+using cyberway::chaindb::cache_hot_key;
+
+namespace {
+
+   struct manifest_tester : tester {
+      manifest_tester() {
+         create_accounts({N(alice), N(bob)});
+         produce_blocks(2);
+      }
+
+      fc::path manifest_path() const {
+         return cfg.state_dir / config::cache_manifest_filename;
+      }
+
+      vector<cache_hot_key> read_manifest() const {
+         string content;
+         fc::read_file_contents(manifest_path(), content);
+
+         fc::datastream<const char*> ds(content.data(), content.size());
+         uint32_t version = 0;
+         vector<cache_hot_key> keys;
+         fc::raw::unpack(ds, version);
+         fc::raw::unpack(ds, keys);
+         BOOST_CHECK_EQUAL(version, 1u);
+         return keys;
+      }
+
+      void reopen(uint32_t manifest_rows) {
+         close();
+         cfg.cache_manifest_rows = manifest_rows;
+         open(nullptr);
+      }
+
+      /// @return number of lookups of the account which missed the cache
+      uint64_t find_account_misses(account_name account) const {
+         auto& cache = control->chaindb().get_cache_map();
+         const auto misses = cache.stats().misses;
+         BOOST_CHECK(control->chaindb().find<account_object>(account.value) != nullptr);
+         return cache.stats().misses - misses;
+      }
+   };
+
+   bool has_key(const vector<cache_hot_key>& keys, account_name pk) {
+      return std::any_of(keys.begin(), keys.end(), [&](const auto& key) { return key.pk == pk.value; });
+   }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(cache_manifest_tests)
+
+BOOST_FIXTURE_TEST_CASE( save_on_shutdown, manifest_tester ) try {
+   close();
+
+   BOOST_REQUIRE(fc::exists(manifest_path()));
+   auto keys = read_manifest();
+   BOOST_CHECK(!keys.empty());
+   BOOST_CHECK(keys.size() <= cfg.cache_manifest_rows);
+   BOOST_CHECK(has_key(keys, N(alice)));
+   BOOST_CHECK(has_key(keys, N(bob)));
+
+   // the number of rows is limited
+   cfg.cache_manifest_rows = 2;
+   open(nullptr);
+   close();
+   BOOST_CHECK_EQUAL(read_manifest().size(), 2u);
+
+   open(nullptr);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( load_on_startup, manifest_tester ) try {
+   // without the manifest the rows are read from the database
+   reopen(0);
+   BOOST_CHECK_EQUAL(find_account_misses(N(alice)), 1u);
+
+   // the rows of the manifest are in the cache before any block
+   reopen(config::default_cache_manifest_rows);
+   BOOST_CHECK_EQUAL(find_account_misses(N(alice)), 0u);
+   BOOST_CHECK_EQUAL(find_account_misses(N(bob)), 0u);
+
+   produce_blocks(2);
+   BOOST_CHECK(control->chaindb().find<account_object>(N(alice)) != nullptr);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( periodic_save, manifest_tester ) try {
+   close();
+   fc::remove(manifest_path());
+   cfg.cache_manifest_interval = 2;
+   open(nullptr);
+
+   // the periodic manifest is written by the thread pool, the destructor waits for it and saves the final one
+   create_accounts({N(carol)});
+   produce_blocks(4);
+   close();
+
+   BOOST_REQUIRE(fc::exists(manifest_path()));
+   BOOST_CHECK(has_key(read_manifest(), N(carol)));
+   BOOST_CHECK(!fc::exists(manifest_path().generic_string() + ".async.tmp"));
+   BOOST_CHECK(!fc::exists(manifest_path().generic_string() + ".tmp"));
+
+   open(nullptr);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( broken_manifest, manifest_tester ) try {
+   close();
+
+   // a manifest of another version is ignored
+   {
+      auto data = fc::raw::pack(uint32_t(2));
+      std::ofstream out(manifest_path().generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc);
+      out.write(data.data(), data.size());
+   }
+   open(nullptr);
+   BOOST_CHECK_EQUAL(find_account_misses(N(alice)), 1u);
+
+   // as well as a truncated one
+   close();
+   {
+      auto data = fc::raw::pack(uint32_t(1));
+      data.push_back(char(100));
+      std::ofstream out(manifest_path().generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc);
+      out.write(data.data(), data.size());
+   }
+   open(nullptr);
+   BOOST_CHECK_EQUAL(find_account_misses(N(alice)), 1u);
+
+   produce_blocks(2);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -47,6 +47,89 @@ BOOST_AUTO_TEST_SUITE(database_tests)
       } FC_LOG_AND_RETHROW()
    }
 
+   // Undo and squash of states, which get nodes of the previously discarded states
+   BOOST_AUTO_TEST_CASE(undo_reused_nodes_test) {
+      try {
+         TESTER test;
+
+         auto& chaindb = test.control->chaindb();
+
+         auto version = [&](account_name n) -> int {
+            auto ptr = chaindb.find<account_object>(n.value);
+            return ptr ? ptr->vm_version : -1;
+         };
+         auto set_version = [&](account_name n, uint8_t v) {
+            chaindb.modify(chaindb.get<account_object>(n.value), [&](account_object& a) { a.vm_version = v; });
+         };
+         auto create = [&](account_name n, uint8_t v) {
+            chaindb.emplace<account_object>(n.value, [&](account_object& a) { a.vm_version = v; });
+         };
+         auto remove = [&](account_name n) {
+            chaindb.erase(chaindb.get<account_object>(n.value));
+         };
+
+         auto ses0 = chaindb.start_undo_session(true);
+         create(N(billy), 1);
+         create(N(bob), 1);
+
+         // each undone state gives its nodes to the next one
+         for (int i = 0; i < 3; ++i) {
+            auto ses = chaindb.start_undo_session(true);
+            set_version(N(billy), 2);
+            remove(N(bob));
+            create(N(carl), 2);
+            remove(N(carl));
+            create(N(carl), 3);
+            ses.undo();
+
+            BOOST_TEST(version(N(billy)) == 1);
+            BOOST_TEST(version(N(bob)) == 1);
+            BOOST_TEST(version(N(carl)) == -1);
+         }
+
+         // update, remove and insert after remove are squashed, then undone
+         {
+            auto ses1 = chaindb.start_undo_session(true);
+            set_version(N(billy), 3);
+            remove(N(bob));
+            create(N(bob), 3);
+            create(N(carl), 3);
+
+            auto ses2 = chaindb.start_undo_session(true);
+            set_version(N(carl), 5);
+            remove(N(billy));
+            set_version(N(bob), 5);
+            ses2.squash();
+
+            BOOST_TEST(version(N(billy)) == -1);
+            BOOST_TEST(version(N(bob)) == 5);
+            BOOST_TEST(version(N(carl)) == 5);
+
+            ses1.undo();
+            BOOST_TEST(version(N(billy)) == 1);
+            BOOST_TEST(version(N(bob)) == 1);
+            BOOST_TEST(version(N(carl)) == -1);
+         }
+
+         // rows of the squashed state are undone with the rows created before it
+         {
+            auto ses = chaindb.start_undo_session(true);
+            remove(N(billy));
+            create(N(billy), 7);
+            set_version(N(billy), 8);
+            create(N(carl), 8);
+            ses.squash();
+         }
+         BOOST_TEST(version(N(billy)) == 8);
+         BOOST_TEST(version(N(carl)) == 8);
+
+         ses0.undo();
+         BOOST_TEST(version(N(billy)) == -1);
+         BOOST_TEST(version(N(bob)) == -1);
+         BOOST_TEST(version(N(carl)) == -1);
+      } FC_LOG_AND_RETHROW()
+   }
+
    // Test the block fetching methods on database, fetch_bock_by_id, and fetch_block_by_number
    BOOST_AUTO_TEST_CASE(get_blocks) {
       try {
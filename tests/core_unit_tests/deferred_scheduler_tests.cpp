@@ -0,0 +1,210 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/deferred_transaction_scheduler.hpp>
+#include <eosio/chain/generated_transaction_object.hpp>
+
+#include <cyberway/chaindb/controller.hpp>
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+
+   /// checks that rows of the table are scheduled in the order of the by_delay index
+   void check_schedule( tester& t ) {
+      auto& scheduler = t.control->get_mutable_deferred_scheduler();
+
+      vector<transaction_id_type> table_ids;
+      auto idx = t.control->chaindb().get_index<generated_transaction_object, by_delay>();
+      for( auto itr = idx.begin(); itr != idx.end(); ++itr ) {
+         table_ids.push_back( itr->trx_id );
+
+         auto e = scheduler.find( itr->trx_id );
+         BOOST_REQUIRE( e );
+         BOOST_CHECK( e->delay_until == itr->delay_until );
+         BOOST_CHECK( e->trx->id == itr->trx_id );
+         BOOST_CHECK( scheduler.is_scheduled( itr->trx_id ) );
+      }
+
+      vector<transaction_id_type> scheduled_ids;
+      for( const auto& e: scheduler.get_ready( time_point::maximum() ) ) {
+         if( scheduler.is_scheduled( e->trx_id ) ) scheduled_ids.push_back( e->trx_id );
+      }
+      BOOST_CHECK( table_ids == scheduled_ids );
+   }
+
+   bool is_ready( tester& t, const transaction_id_type& id, time_point time ) {
+      for( const auto& e: t.control->get_mutable_deferred_scheduler().get_ready( time ) ) {
+         if( e->trx_id == id ) return true;
+      }
+      return false;
+   }
+
+   signed_transaction make_delayed_trx( tester& t, const char* permission, uint32_t delay_sec ) {
+      signed_transaction trx;
+      trx.actions.push_back( t.get_action( config::system_account_name, N(updateauth), {{N(alice), config::active_name}},
+         fc::mutable_variant_object()
+            ("account", "alice")
+            ("permission", permission)
+            ("parent", "active")
+            ("auth", authority( tester::get_public_key( N(alice), permission ) ))
+      ));
+      t.set_transaction_headers( trx, base_tester::DEFAULT_EXPIRATION_DELTA, delay_sec );
+      trx.sign( tester::get_private_key( N(alice), "active" ), t.control->get_chain_id() );
+      return trx;
+   }
+
+   void push_blocks( tester& from, tester& to ) {
+      while( to.control->fork_db_head_block_num() < from.control->fork_db_head_block_num() ) {
+         to.push_block( from.control->fetch_block_by_number( to.control->fork_db_head_block_num() + 1 ) );
+      }
+   }
+
+   struct scheduler_tester : tester {
+      scheduler_tester() {
+         create_accounts( {N(alice)} );
+         produce_block();
+      }
+
+      void cancel( const transaction_id_type& id ) {
+         signed_transaction trx;
+         trx.actions.emplace_back( vector<permission_level>{{N(alice), config::active_name}},
+                                   canceldelay{{N(alice), config::active_name}, id} );
+         set_transaction_headers( trx );
+         trx.sign( get_private_key( N(alice), "active" ), control->get_chain_id() );
+         push_transaction( trx );
+      }
+   };
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(deferred_scheduler_tests)
+
+BOOST_FIXTURE_TEST_CASE( schedule, scheduler_tester ) try {
+   auto& scheduler = control->get_mutable_deferred_scheduler();
+
+   auto trx1 = make_delayed_trx( *this, "first", 9 );
+   auto trx2 = make_delayed_trx( *this, "second", 3 );
+   push_transaction( trx1 );
+   push_transaction( trx2 );
+
+   // the rows of the pending block are scheduled at once
+   BOOST_CHECK( scheduler.find( trx1.id() ) );
+   BOOST_CHECK( scheduler.is_scheduled( trx1.id() ) );
+   BOOST_CHECK( !is_ready( *this, trx1.id(), control->pending_block_time() ) );
+   check_schedule( *this );
+
+   produce_block();
+   check_schedule( *this );
+   BOOST_CHECK_EQUAL( 2u, scheduler.size() );
+
+   const auto delay2 = scheduler.find( trx2.id() )->delay_until;
+   BOOST_CHECK( is_ready( *this, trx2.id(), delay2 ) );
+   BOOST_CHECK( !is_ready( *this, trx1.id(), delay2 ) );
+
+   // the second transaction is executed first
+   produce_block();
+   BOOST_CHECK( !scheduler.find( trx2.id() ) );
+   BOOST_CHECK( scheduler.find( trx1.id() ) );
+   check_schedule( *this );
+
+   produce_block( fc::seconds( 6 ) );
+   BOOST_CHECK_EQUAL( 0u, scheduler.size() );
+   check_schedule( *this );
+
+   // the schedule is rebuilt from the table
+   push_transaction( make_delayed_trx( *this, "third", 3 ) );
+   produce_block();
+   scheduler.reset();
+   BOOST_CHECK_EQUAL( 0u, scheduler.size() );
+   check_schedule( *this );
+   BOOST_CHECK_EQUAL( 1u, scheduler.size() );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( cancel, scheduler_tester ) try {
+   auto& scheduler = control->get_mutable_deferred_scheduler();
+
+   auto trx = make_delayed_trx( *this, "first", 9 );
+   push_transaction( trx );
+   produce_block();
+   check_schedule( *this );
+
+   // the removed row stays in the schedule until the end of the block, but it isn't scheduled
+   scheduler_tester::cancel( trx.id() );
+   BOOST_CHECK( !scheduler.is_scheduled( trx.id() ) );
+   BOOST_CHECK( is_ready( *this, trx.id(), time_point::maximum() ) );
+   check_schedule( *this );
+
+   produce_block();
+   BOOST_CHECK( !scheduler.find( trx.id() ) );
+   BOOST_CHECK_EQUAL( 0u, scheduler.size() );
+   check_schedule( *this );
+
+   // nothing is scheduled after the time of the canceled transaction
+   produce_block( fc::seconds( 9 ) );
+   BOOST_CHECK_EQUAL( 0u, scheduler.size() );
+   check_schedule( *this );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( undo, scheduler_tester ) try {
+   auto& scheduler = control->get_mutable_deferred_scheduler();
+
+   // the row of the aborted block is undone
+   auto trx = make_delayed_trx( *this, "first", 9 );
+   push_transaction( trx );
+   BOOST_CHECK( scheduler.is_scheduled( trx.id() ) );
+   control->abort_block();
+   BOOST_CHECK( !scheduler.find( trx.id() ) );
+   check_schedule( *this );
+
+   // the aborted transaction is applied again in the next block
+   produce_block();
+   BOOST_REQUIRE( scheduler.find( trx.id() ) );
+   check_schedule( *this );
+
+   // the canceling of the aborted block is undone
+   scheduler_tester::cancel( trx.id() );
+   control->abort_block();
+   BOOST_CHECK( scheduler.find( trx.id() ) );
+   BOOST_CHECK( scheduler.is_scheduled( trx.id() ) );
+   check_schedule( *this );
+
+   // the popped block takes its row with it
+   control->pop_block();
+   BOOST_CHECK( !scheduler.find( trx.id() ) );
+   check_schedule( *this );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( fork_switch ) try {
+   tester a( tester::default_config( "_A_" ) );
+   tester b( tester::default_config( "_B_" ) );
+   a.create_accounts( {N(alice)} );
+   a.produce_block();
+   push_blocks( a, b );
+   BOOST_REQUIRE( a.control->head_block_id() == b.control->head_block_id() );
+   const auto fork_num = a.control->head_block_num();
+
+   // a has the transaction in a block, b builds a longer fork without it
+   auto trx = make_delayed_trx( a, "first", 6 );
+   a.push_transaction( trx );
+   a.produce_block();
+   BOOST_CHECK( a.control->get_mutable_deferred_scheduler().find( trx.id() ) );
+
+   b.produce_blocks( 2 );
+   for( auto num = fork_num + 1; num <= b.control->head_block_num(); ++num ) {
+      a.push_block( b.control->fetch_block_by_number( num ) );
+   }
+   BOOST_REQUIRE( a.control->head_block_id() == b.control->head_block_id() );
+
+   BOOST_CHECK( !a.control->get_mutable_deferred_scheduler().find( trx.id() ) );
+   check_schedule( a );
+
+   // the transaction of the dropped block is applied again
+   a.produce_block();
+   BOOST_CHECK( a.control->get_mutable_deferred_scheduler().find( trx.id() ) );
+   check_schedule( a );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -388,4 +388,46 @@ BOOST_AUTO_TEST_CASE( read_modes ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( fork_db_log ) try {
+   tester c;
+   vector<block_state_ptr> blocks;
+   for( int i = 0; i < 3; ++i ) {
+      c.produce_block();
+      blocks.push_back( c.control->head_block_state() );
+   }
+
+   fc::temp_directory dir, crash_dir;
+   {
+      fork_database db( dir.path() );
+      db.set( blocks[0] );
+      db.set( blocks[1] );
+      db.flush();
+
+      db.set( blocks[2] );
+      // a copy of the log made before close() is what is left after an unclean shutdown
+      fc::copy( dir.path() / config::forkdb_log_filename, crash_dir.path() / config::forkdb_log_filename );
+   }
+
+   fork_database restored( crash_dir.path() );
+   BOOST_REQUIRE( restored.get_block( blocks[0]->id ) );
+   BOOST_REQUIRE( restored.get_block( blocks[1]->id ) );
+   BOOST_REQUIRE( !restored.get_block( blocks[2]->id ) );
+   BOOST_REQUIRE_EQUAL( restored.head()->id, blocks[1]->id );
+   BOOST_REQUIRE_EQUAL( restored.get_block( blocks[1]->id )->in_current_chain, blocks[1]->in_current_chain );
+
+   // close() writes the whole content
+   fork_database closed( dir.path() );
+   BOOST_REQUIRE( closed.get_block( blocks[2]->id ) );
+   BOOST_REQUIRE_EQUAL( closed.head()->id, blocks[2]->id );
+
+   // the log isn't created while there is nothing to write
+   fc::temp_directory empty_dir;
+   {
+      fork_database db( empty_dir.path() );
+      db.flush();
+   }
+   BOOST_REQUIRE( !fc::exists( empty_dir.path() / config::forkdb_log_filename ) );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,379 @@
+#ifdef CYBERWAY_CHAINDB
+
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/permission_object.hpp>
+
+#include <cyberway/chaindb/controller.hpp>
+#include <cyberway/chaindb/driver_interface.hpp>
+#include <cyberway/chaindb/mongo_resident_table.hpp>
+
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <bsoncxx/decimal128.hpp>
+#include <bsoncxx/types.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <cmath>
+#include <limits>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+using cyberway::chaindb::compare_bson_values;
+using cyberway::chaindb::mongo_resident_table;
+using bsoncxx::builder::basic::kvp;
+using bsoncxx::builder::basic::make_document;
+
+namespace {
+
+   /// compares the values of the field "v" of the documents
+   template <typename L, typename R>
+   int compare_values(const L& l, const R& r) {
+      auto ldoc = make_document(kvp("v", l));
+      auto rdoc = make_document(kvp("v", r));
+      auto res  = compare_bson_values(ldoc.view()["v"], rdoc.view()["v"]);
+
+      // the comparison is antisymmetric
+      BOOST_CHECK_EQUAL(-res, compare_bson_values(rdoc.view()["v"], ldoc.view()["v"]));
+      return res;
+   }
+
+   bsoncxx::types::b_decimal128 decimal(const char* value) {
+      return bsoncxx::types::b_decimal128{bsoncxx::decimal128(value)};
+   }
+
+   struct resident_fixture {
+      std::shared_ptr<mongo_resident_table> table = std::make_shared<mongo_resident_table>(N(test), N(table));
+      const mongo_resident_table::key_pattern pattern = {{"v", 1}};
+
+      void insert(primary_key_t pk, int64_t value, scope_name_t scope = 0) {
+         table->insert(scope, pk, make_document(kvp("pk", int64_t(pk)), kvp("v", value)));
+      }
+
+      mongo_resident_table::cursor open(bool forward, int64_t bound) const {
+         return mongo_resident_table::open(table, pattern, forward, make_document(kvp("v", bound)).view());
+      }
+
+      mongo_resident_table::cursor open_end(bool forward) const {
+         return mongo_resident_table::open(table, pattern, forward, make_document(kvp("v", bsoncxx::types::b_maxkey{})).view());
+      }
+
+      static int64_t value(const mongo_resident_table::cursor& cursor) {
+         return cursor.current()["v"].get_int64().value;
+      }
+
+      static vector<int64_t> read(mongo_resident_table::cursor cursor) {
+         vector<int64_t> values;
+         for (; !cursor.is_end(); cursor.next()) {
+            values.push_back(value(cursor));
+         }
+         return values;
+      }
+   };
+
+   using permission_row = std::tuple<uint64_t /* id */, uint64_t /* parent */, uint64_t /* owner */, uint64_t /* name */>;
+
+   permission_row make_row(const permission_object& obj) {
+      return permission_row(obj.id._id, obj.parent._id, obj.owner.value, obj.name.value);
+   }
+
+   /// rows of the index in the forward and in the backward order
+   template <typename Tag>
+   vector<permission_row> read_permissions(tester& t) {
+      auto idx = t.control->chaindb().get_index<permission_object, Tag>();
+
+      vector<permission_row> rows;
+      for (auto itr = idx.begin(); itr != idx.end(); ++itr) {
+         rows.push_back(make_row(*itr));
+      }
+
+      auto size = rows.size();
+      auto itr  = idx.end();
+      for (size_t i = 0; i < size; ++i) {
+         --itr;
+         rows.push_back(make_row(*itr));
+      }
+      return rows;
+   }
+
+   /// first rows from the lower bounds of owners
+   vector<permission_row> read_owners(tester& t, const vector<account_name>& owners) {
+      auto idx = t.control->chaindb().get_index<permission_object, by_owner>();
+
+      vector<permission_row> rows;
+      for (auto& owner: owners) {
+         auto itr = idx.lower_bound(boost::make_tuple(owner, permission_name()));
+         for (int i = 0; i < 3 && itr != idx.end(); ++i, ++itr) {
+            rows.push_back(make_row(*itr));
+         }
+         itr = idx.upper_bound(boost::make_tuple(owner, permission_name(config::owner_name)));
+         if (itr != idx.end()) {
+            rows.push_back(make_row(*itr));
+         }
+      }
+      return rows;
+   }
+
+   void check_same_permissions(tester& a, tester& b, const vector<account_name>& owners) {
+      BOOST_CHECK(read_permissions<by_id>(a) == read_permissions<by_id>(b));
+      BOOST_CHECK(read_permissions<by_parent>(a) == read_permissions<by_parent>(b));
+      BOOST_CHECK(read_permissions<by_owner>(a) == read_permissions<by_owner>(b));
+      BOOST_CHECK(read_permissions<by_name>(a) == read_permissions<by_name>(b));
+      BOOST_CHECK(read_owners(a, owners) == read_owners(b, owners));
+   }
+
+   void push_blocks(tester& from, tester& to) {
+      while (to.control->head_block_num() < from.control->head_block_num()) {
+         to.push_block(from.control->fetch_block_by_number(to.control->head_block_num() + 1));
+      }
+   }
+
+   void update_auth(tester& t, account_name account, permission_name perm, permission_name parent) {
+      t.push_action(config::system_account_name, N(updateauth), account, fc::mutable_variant_object()
+         ("account",    account)
+         ("permission", perm)
+         ("parent",     parent)
+         ("auth",       authority(tester::get_public_key(account, perm.to_string())))
+      );
+   }
+
+   void delete_auth(tester& t, account_name account, permission_name perm) {
+      t.push_action(config::system_account_name, N(deleteauth), account, fc::mutable_variant_object()
+         ("account",    account)
+         ("permission", perm)
+      );
+   }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(resident_table_tests)
+
+BOOST_AUTO_TEST_CASE( compare_numbers ) try {
+   // values of different numeric types are compared by their values
+   BOOST_CHECK_EQUAL(compare_values(int32_t(1), int64_t(1)), 0);
+   BOOST_CHECK_EQUAL(compare_values(int64_t(1), 1.0), 0);
+   BOOST_CHECK_EQUAL(compare_values(int32_t(1), decimal("1")), 0);
+   BOOST_CHECK_EQUAL(compare_values(1.5, decimal("1.5")), 0);
+   BOOST_CHECK_EQUAL(compare_values(int64_t(100), decimal("1E+2")), 0);
+   BOOST_CHECK_EQUAL(compare_values(decimal("100"), decimal("1E+2")), 0);
+
+   BOOST_CHECK_EQUAL(compare_values(int32_t(-1), int64_t(0)), -1);
+   BOOST_CHECK_EQUAL(compare_values(int64_t(2), 1.5), 1);
+   BOOST_CHECK_EQUAL(compare_values(decimal("-2.5"), int32_t(-2)), -1);
+   BOOST_CHECK_EQUAL(compare_values(decimal("0.1"), decimal("1E-2")), 1);
+   BOOST_CHECK_EQUAL(compare_values(std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max() - 1), 1);
+   BOOST_CHECK_EQUAL(compare_values(std::numeric_limits<int64_t>::min(), -1.0), -1);
+
+   // integers above 2^53 aren't rounded to doubles
+   BOOST_CHECK_EQUAL(compare_values(int64_t(1) << 53, double(int64_t(1) << 53)), 0);
+   BOOST_CHECK_EQUAL(compare_values((int64_t(1) << 53) + 1, double(int64_t(1) << 53)), 1);
+
+   // NaN is less than any other number, infinities are the outermost numbers
+   const auto nan = std::numeric_limits<double>::quiet_NaN();
+   const auto inf = std::numeric_limits<double>::infinity();
+   BOOST_CHECK_EQUAL(compare_values(nan, -inf), -1);
+   BOOST_CHECK_EQUAL(compare_values(nan, decimal("NaN")), 0);
+   BOOST_CHECK_EQUAL(compare_values(decimal("NaN"), std::numeric_limits<int64_t>::min()), -1);
+   BOOST_CHECK_EQUAL(compare_values(-inf, std::numeric_limits<int64_t>::min()), -1);
+   BOOST_CHECK_EQUAL(compare_values(decimal("Infinity"), std::numeric_limits<int64_t>::max()), 1);
+   BOOST_CHECK_EQUAL(compare_values(decimal("-Infinity"), -inf), 0);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( compare_types ) try {
+   // strings are compared by bytes
+   BOOST_CHECK_EQUAL(compare_values("a", "b"), -1);
+   BOOST_CHECK_EQUAL(compare_values("ab", "a"), 1);
+   BOOST_CHECK_EQUAL(compare_values("B", "a"), -1);
+   BOOST_CHECK_EQUAL(compare_values("", "a"), -1);
+   BOOST_CHECK_EQUAL(compare_values("abc", "abc"), 0);
+
+   BOOST_CHECK_EQUAL(compare_values(false, true), -1);
+   BOOST_CHECK_EQUAL(compare_values(true, true), 0);
+
+   // values of different types are ordered by the canonical types of MongoDB:
+   //   MinKey < null < numbers < strings < documents < booleans < MaxKey
+   BOOST_CHECK_EQUAL(compare_values(bsoncxx::types::b_minkey{}, bsoncxx::types::b_null{}), -1);
+   BOOST_CHECK_EQUAL(compare_values(bsoncxx::types::b_null{}, std::numeric_limits<int64_t>::min()), -1);
+   BOOST_CHECK_EQUAL(compare_values(decimal("1E+100"), ""), -1);
+   BOOST_CHECK_EQUAL(compare_values("z", make_document()), -1);
+   BOOST_CHECK_EQUAL(compare_values(make_document(kvp("a", 1)), false), -1);
+   BOOST_CHECK_EQUAL(compare_values("true", false), -1);
+   BOOST_CHECK_EQUAL(compare_values(true, bsoncxx::types::b_maxkey{}), -1);
+
+   // the missing field is indexed as null
+   auto doc = make_document(kvp("v", bsoncxx::types::b_null{}));
+   BOOST_CHECK_EQUAL(compare_bson_values(doc.view()["missing"], doc.view()["v"]), 0);
+   BOOST_CHECK_EQUAL(compare_bson_values(doc.view()["missing"], make_document(kvp("v", 0)).view()["v"]), -1);
+
+   // documents are compared by fields
+   BOOST_CHECK_EQUAL(compare_values(make_document(kvp("a", 1)), make_document(kvp("a", 1.0))), 0);
+   BOOST_CHECK_EQUAL(compare_values(make_document(kvp("a", 1)), make_document(kvp("a", 1), kvp("b", 0))), -1);
+   BOOST_CHECK_EQUAL(compare_values(make_document(kvp("a", 2)), make_document(kvp("b", 1))), -1);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( index_order, resident_fixture ) try {
+   // the descending field reverses the order, the non-unique keys are ordered by rows;
+   //   MaxKey is the first value for the descending field
+   const mongo_resident_table::key_pattern desc = {{"g", -1}, {"pk", 1}};
+   for (int64_t pk = 1; pk <= 6; ++pk) {
+      table->insert(0, pk, make_document(kvp("pk", pk), kvp("g", pk % 3)));
+   }
+
+   auto cursor = mongo_resident_table::open(table, desc, true, make_document(kvp("g", bsoncxx::types::b_maxkey{})).view());
+   vector<int64_t> pks;
+   for (; !cursor.is_end(); cursor.next()) {
+      pks.push_back(cursor.current()["pk"].get_int64().value);
+   }
+   BOOST_CHECK(pks == vector<int64_t>({2, 5, 1, 4, 3, 6}));
+   BOOST_CHECK_EQUAL(table->last(desc)->view()["pk"].get_int64().value, 6);
+   BOOST_CHECK_EQUAL(table->last({{"pk", 1}})->view()["pk"].get_int64().value, 6);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( cursor_bounds, resident_fixture ) try {
+   for (int64_t pk = 1; pk <= 10; ++pk) {
+      insert(pk, pk * 10);
+   }
+
+   // forward cursor starts from the first key >= bound, backward one - from the last key < bound
+   BOOST_CHECK(read(open(true, 35)) == vector<int64_t>({40, 50, 60, 70, 80, 90, 100}));
+   BOOST_CHECK(read(open(true, 40)) == vector<int64_t>({40, 50, 60, 70, 80, 90, 100}));
+   BOOST_CHECK(read(open(false, 35)) == vector<int64_t>({30, 20, 10}));
+   BOOST_CHECK(read(open(false, 30)) == vector<int64_t>({20, 10}));
+
+   BOOST_CHECK(open(true, 101).is_end());
+   BOOST_CHECK(open(false, 10).is_end());
+   BOOST_CHECK(open_end(true).is_end());
+   BOOST_CHECK_EQUAL(read(open_end(false)).size(), 10u);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( forward_cursor_changes, resident_fixture ) try {
+   for (int64_t pk = 1; pk <= 10; ++pk) {
+      insert(pk, pk * 10);
+   }
+
+   auto cursor = open(true, 40);
+   BOOST_CHECK_EQUAL(value(cursor), 40);
+
+   // the inserted row after the current one is visited
+   insert(11, 45);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 45);
+
+   // the inserted row before the current one isn't visited
+   insert(12, 42);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 50);
+
+   // the erased row isn't visited
+   BOOST_CHECK(table->erase(0, 6));
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 70);
+
+   // the current row is kept by the cursor after erasing
+   BOOST_CHECK(table->erase(0, 7));
+   BOOST_CHECK_EQUAL(value(cursor), 70);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 80);
+
+   // the updated row is visited at its new position
+   insert(9, 85);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 85);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 100);
+
+   BOOST_CHECK(table->erase(0, 10));
+   cursor.next();
+   BOOST_CHECK(cursor.is_end());
+   cursor.next();
+   BOOST_CHECK(cursor.is_end());
+
+   BOOST_CHECK(!table->erase(0, 10));
+   BOOST_CHECK(read(open(true, 0)) == vector<int64_t>({10, 20, 30, 40, 42, 45, 50, 80, 85}));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( backward_cursor_changes, resident_fixture ) try {
+   for (int64_t pk = 1; pk <= 10; ++pk) {
+      insert(pk, pk * 10);
+   }
+
+   auto cursor = open(false, 65);
+   BOOST_CHECK_EQUAL(value(cursor), 60);
+
+   // the inserted row before the current one is visited
+   insert(11, 55);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 55);
+
+   // the inserted row after the current one isn't visited
+   insert(12, 57);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 50);
+
+   // the erased row isn't visited, the current row is kept after erasing
+   BOOST_CHECK(table->erase(0, 4));
+   BOOST_CHECK(table->erase(0, 5));
+   BOOST_CHECK_EQUAL(value(cursor), 50);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 30);
+
+   // the row of another scope is a different row
+   insert(2, 25, 1);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 25);
+   cursor.next();
+   BOOST_CHECK_EQUAL(value(cursor), 20);
+
+   BOOST_CHECK(table->erase(0, 1));
+   cursor.next();
+   BOOST_CHECK(cursor.is_end());
+
+   BOOST_CHECK_EQUAL(table->size(), 10u);
+   BOOST_CHECK(table->find(1, 2));
+   BOOST_CHECK(!table->find(0, 1));
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE( resident_chaindb ) try {
+   // the same chain in the database (a) and with the resident table of permissions (b)
+   tester a(tester::default_config("_A_"));
+   tester b(tester::default_config("_B_"));
+   b.control->chaindb().get_driver().set_resident_tables({{0, N(permission)}});
+
+   const vector<account_name> owners = {N(alice), N(bob), N(carol), N(dan)};
+   a.create_accounts(owners);
+   a.produce_block();
+   push_blocks(a, b);
+   check_same_permissions(a, b, owners);
+
+   // changed rows are moved in indexes
+   for (auto& owner: owners) {
+      update_auth(a, owner, N(first), config::active_name);
+      update_auth(a, owner, N(second), N(first));
+   }
+   a.produce_block();
+   delete_auth(a, N(bob), N(second));
+   delete_auth(a, N(bob), N(first));
+   update_auth(a, N(carol), N(second), config::active_name);
+   a.produce_block();
+   push_blocks(a, b);
+   check_same_permissions(a, b, owners);
+
+   // changes of the aborted block are undone in the resident table
+   for (auto* t: {&a, &b}) {
+      update_auth(*t, N(bob), N(third), config::active_name);
+      delete_auth(*t, N(alice), N(second));
+   }
+   check_same_permissions(a, b, owners);
+   a.control->abort_block();
+   b.control->abort_block();
+   check_same_permissions(a, b, owners);
+
+   a.produce_blocks(2);
+   push_blocks(a, b);
+   check_same_permissions(a, b, owners);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // CYBERWAY_CHAINDB
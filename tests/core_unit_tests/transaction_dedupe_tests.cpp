@@ -0,0 +1,131 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/transaction_object.hpp>
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+BOOST_AUTO_TEST_SUITE(transaction_dedupe_tests)
+
+BOOST_AUTO_TEST_CASE( dedupe_index ) try {
+   transaction_dedupe_index index;
+
+   const auto id1 = transaction_id_type::hash(std::string("trx1"));
+   const auto id2 = transaction_id_type::hash(std::string("trx2"));
+   const auto id3 = transaction_id_type::hash(std::string("trx3"));
+   const fc::time_point_sec time(1000);
+
+   index.add(id1, time);
+   index.add(id2, time + 10);
+   BOOST_CHECK(index.may_contain(id1));
+   BOOST_CHECK(index.may_contain(id2));
+   BOOST_CHECK(!index.may_contain(id3));
+   BOOST_CHECK_EQUAL(index.size(), 2u);
+
+   // a duplicate is kept in the bucket of its first expiration
+   index.add(id1, time + 20);
+   BOOST_CHECK_EQUAL(index.size(), 2u);
+
+   // transactions which expire at the given time are still kept
+   index.remove_expired(time);
+   BOOST_CHECK(index.may_contain(id1));
+   BOOST_CHECK_EQUAL(index.size(), 2u);
+
+   index.remove_expired(time + 1);
+   BOOST_CHECK(!index.may_contain(id1));
+   BOOST_CHECK(index.may_contain(id2));
+   BOOST_CHECK_EQUAL(index.size(), 1u);
+
+   // a released id can be added again
+   index.add(id1, time + 30);
+   index.remove_expired(time + 11);
+   BOOST_CHECK(index.may_contain(id1));
+   BOOST_CHECK(!index.may_contain(id2));
+
+   index.clear();
+   BOOST_CHECK(!index.may_contain(id1));
+   BOOST_CHECK_EQUAL(index.size(), 0u);
+} FC_LOG_AND_RETHROW()
+
+struct dedupe_tester : tester {
+   dedupe_tester() {
+      create_accounts({N(alice)});
+      produce_block();
+   }
+
+   signed_transaction make_trx(const char* permission) {
+      signed_transaction trx;
+      trx.actions.push_back(get_action(config::system_account_name, N(updateauth), {{N(alice), config::active_name}},
+         fc::mutable_variant_object()
+            ("account", "alice")
+            ("permission", permission)
+            ("parent", "active")
+            ("auth", authority(get_public_key(N(alice), permission)))
+      ));
+      set_transaction_headers(trx);
+      trx.sign(get_private_key(N(alice), "active"), control->get_chain_id());
+      return trx;
+   }
+};
+
+BOOST_FIXTURE_TEST_CASE( duplicates, dedupe_tester ) try {
+   auto trx = make_trx("first");
+   BOOST_CHECK(!control->is_known_unexpired_transaction(trx.id()));
+
+   push_transaction(trx);
+   BOOST_CHECK(control->is_known_unexpired_transaction(trx.id()));
+   BOOST_CHECK_THROW(push_transaction(trx), tx_duplicate);
+
+   produce_block();
+   BOOST_CHECK(chain_has_transaction(trx.id()));
+   BOOST_CHECK_THROW(push_transaction(trx), tx_duplicate);
+
+   // another transaction isn't affected
+   auto trx2 = make_trx("second");
+   BOOST_CHECK(!control->is_known_unexpired_transaction(trx2.id()));
+   push_transaction(trx2);
+   produce_block();
+   BOOST_CHECK(chain_has_transaction(trx2.id()));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( duplicates_after_undo, dedupe_tester ) try {
+   auto trx = make_trx("first");
+
+   // the row is undone with the pending block, the index still has the id
+   push_transaction(trx);
+   control->abort_block();
+   BOOST_CHECK(!control->is_known_unexpired_transaction(trx.id()));
+
+   push_transaction(trx);
+   BOOST_CHECK_THROW(push_transaction(trx), tx_duplicate);
+   produce_block();
+   BOOST_CHECK(chain_has_transaction(trx.id()));
+
+   // the block with the transaction is popped, it goes back to the unapplied transactions
+   control->abort_block();
+   control->pop_block();
+   BOOST_CHECK(!control->is_known_unexpired_transaction(trx.id()));
+
+   // and it is applied once more in the next block, which takes another slot to differ from the popped one
+   produce_block(fc::milliseconds(2 * config::block_interval_ms));
+   BOOST_CHECK(chain_has_transaction(trx.id()));
+   BOOST_CHECK(control->is_known_unexpired_transaction(trx.id()));
+   BOOST_CHECK_THROW(push_transaction(trx), tx_duplicate);
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( expired_transactions, dedupe_tester ) try {
+   auto trx = make_trx("first");
+   push_transaction(trx);
+   produce_block();
+   BOOST_CHECK(control->is_known_unexpired_transaction(trx.id()));
+
+   // once the transaction expires its row is removed, and it can't be pushed anymore
+   produce_block(fc::seconds(DEFAULT_EXPIRATION_DELTA + 1));
+   produce_blocks(3);
+   BOOST_CHECK(!control->is_known_unexpired_transaction(trx.id()));
+   BOOST_CHECK_THROW(push_transaction(trx), expired_tx_exception);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
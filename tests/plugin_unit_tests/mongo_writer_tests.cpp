@@ -0,0 +1,159 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <eosio/mongo_db_plugin/mongo_writer.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+
+namespace eosio {
+
+using bsoncxx::builder::basic::kvp;
+using bsoncxx::builder::basic::make_document;
+
+/// Executor which records the executed operations and can be held before executing them
+struct recording_executor {
+   std::mutex              mtx;
+   std::condition_variable condition;
+   bool                    held = false;
+   bool                    entered = false;
+   std::vector<int32_t>    numbers;
+   std::vector<int32_t>    filter_numbers;
+   std::vector<mongo_writer::op_kind> kinds;
+
+   mongo_writer::executor make() {
+      return [this]( std::deque<mongo_writer::operation>& ops ) {
+         std::unique_lock<std::mutex> lock( mtx );
+         entered = true;
+         condition.notify_all();
+         condition.wait( lock, [&] { return !held; } );
+         for( const auto& op : ops ) {
+            numbers.push_back( op.doc.view()["n"].get_int32().value );
+            filter_numbers.push_back( op.filter.view()["n"].get_int32().value );
+            kinds.push_back( op.kind );
+         }
+      };
+   }
+
+   void wait_entered() {
+      std::unique_lock<std::mutex> lock( mtx );
+      condition.wait( lock, [&] { return entered; } );
+   }
+
+   void hold( bool h ) {
+      {
+         std::unique_lock<std::mutex> lock( mtx );
+         held = h;
+      }
+      condition.notify_all();
+   }
+};
+
+mongo_writer::operation make_op( int32_t n, size_t payload = 16 ) {
+   return mongo_writer::update_op( mongo_collection::blocks, make_document( kvp( "n", n ) ),
+                                   make_document( kvp( "n", n ), kvp( "payload", std::string( payload, 'x' ) ) ), n % 2 );
+}
+
+BOOST_AUTO_TEST_SUITE(mongo_writer_tests)
+
+/// Test that operations are executed in order of pushing, when they are spilled to the ring file and read back
+BOOST_AUTO_TEST_CASE(spill_ring_order)
+{ try {
+   fc::temp_directory dir;
+   recording_executor recorder;
+   mongo_writer writer( "test" );
+
+   // the ring fits 3 operations with the default payload
+   const auto op_size = 2 + make_op( 0 ).filter.view().length() + make_op( 0 ).doc.view().length();
+   const auto max_spill_size = 3 * op_size;
+
+   recorder.hold( true );
+   writer.start( [&] { return recorder.make(); }, 2, dir.path(), max_spill_size );
+
+   // the first operation is taken by the held executor, then 2 stay in memory and 3 are spilled
+   int32_t n = 0;
+   BOOST_CHECK_EQUAL( 1u, writer.push( make_op( n++ ) ) );
+   recorder.wait_entered();
+   for( ; n < 6; ++n ) {
+      BOOST_CHECK_EQUAL( uint64_t( n + 1 ), writer.push( make_op( n ) ) );
+   }
+   BOOST_CHECK_EQUAL( 0u, writer.executed_ops() );
+   recorder.hold( false );
+
+   // different sizes make records wrap around the end of the ring at different offsets
+   for( ; n < 300; ++n ) {
+      writer.push( make_op( n, n % 20 ) );
+   }
+   // doesn't fit the ring, it is kept in memory after the spilled operations
+   writer.push( make_op( n++, 4 * max_spill_size ) );
+   for( ; n < 400; ++n ) {
+      writer.push( make_op( n, n % 7 ) );
+   }
+
+   writer.wait_idle();
+   BOOST_CHECK_EQUAL( uint64_t( n ), writer.executed_ops() );
+   writer.stop();
+
+   BOOST_REQUIRE_EQUAL( size_t( n ), recorder.numbers.size() );
+   for( int32_t i = 0; i < n; ++i ) {
+      BOOST_CHECK_EQUAL( i, recorder.numbers[i] );
+      BOOST_CHECK_EQUAL( i, recorder.filter_numbers[i] );
+      BOOST_CHECK( recorder.kinds[i] == (i % 2 ? mongo_writer::op_kind::upsert : mongo_writer::op_kind::update) );
+   }
+   BOOST_CHECK( !fc::exists( dir.path() / "test.spill" ) );
+} FC_LOG_AND_RETHROW() }
+
+/// Test that stop() executes all pushed operations, and nothing can be pushed after it
+BOOST_AUTO_TEST_CASE(stop_executes_all)
+{ try {
+   fc::temp_directory dir;
+   recording_executor recorder;
+   mongo_writer writer( "test" );
+
+   recorder.hold( true );
+   writer.start( [&] { return recorder.make(); }, 4, dir.path(), 1024 * 1024 );
+   for( int32_t n = 0; n < 50; ++n ) {
+      writer.push( make_op( n ) );
+   }
+   recorder.hold( false );
+   writer.stop();
+
+   BOOST_CHECK_EQUAL( 50u, writer.executed_ops() );
+   BOOST_CHECK_EQUAL( 50u, recorder.numbers.size() );
+   BOOST_CHECK_THROW( writer.push( make_op( 50 ) ), chain::mongo_db_exception );
+} FC_LOG_AND_RETHROW() }
+
+/// Test that a failure of the executor stops the writer and is reported to the pushing thread
+BOOST_AUTO_TEST_CASE(executor_failure)
+{ try {
+   fc::temp_directory dir;
+   mongo_writer writer( "test" );
+
+   writer.start( [] {
+      return mongo_writer::executor( []( std::deque<mongo_writer::operation>& ) {
+         FC_THROW( "execution failed" );
+      } );
+   }, 4, dir.path(), 1024 );
+
+   writer.push( make_op( 0 ) );
+   BOOST_CHECK_THROW( writer.wait_idle(), chain::mongo_db_exception );
+   BOOST_CHECK_THROW( writer.push( make_op( 1 ) ), chain::mongo_db_exception );
+   BOOST_CHECK_EQUAL( 0u, writer.executed_ops() );
+   writer.stop();
+
+   // an executor which can't be made stops the writer too
+   mongo_writer no_executor( "test2" );
+   no_executor.start( []() -> mongo_writer::executor { FC_THROW( "no connection" ); }, 4, dir.path(), 1024 );
+   BOOST_CHECK_THROW( no_executor.wait_idle(), chain::mongo_db_exception );
+   BOOST_CHECK_THROW( no_executor.push( make_op( 0 ) ), chain::mongo_db_exception );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace eosio
@@ -216,6 +216,139 @@ BOOST_AUTO_TEST_CASE(wallet_manager_test)
 
 } FC_LOG_AND_RETHROW() }
 
+/// Test that the key index follows wallet changes and that a batch is signed all or nothing
+BOOST_AUTO_TEST_CASE(wallet_manager_sign_batch_test)
+{ try {
+   using namespace eosio::wallet;
+
+   if (fc::exists("test.wallet")) fc::remove("test.wallet");
+
+   constexpr auto key1 = "5JktVNHnRX48BUdtewU7N1CyL4Z886c42x7wYW7XhNWkDQRhdcS";
+   constexpr auto key2 = "5Ju5RTcVDo35ndtzHioPMgebvBM6LkJ6tvuU6LTNQv8yaz3ggZr";
+   constexpr auto key3 = "5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3";
+
+   const public_key_type pub1 = private_key_type(std::string(key1)).get_public_key();
+   const public_key_type pub2 = private_key_type(std::string(key2)).get_public_key();
+   const public_key_type pub3 = private_key_type(std::string(key3)).get_public_key();
+
+   const auto chain_id = genesis_state().compute_chain_id();
+   const chain::signed_transaction trx;
+
+   auto signed_by = [&](const chain::signed_transaction& stxn) {
+      flat_set<public_key_type> pks;
+      stxn.get_signature_keys(chain_id, fc::time_point::maximum(), pks);
+      return pks;
+   };
+
+   wallet_manager wm;
+   auto pw = wm.create("test");
+   wm.import_key("test", key1);
+
+   // fills the key index
+   BOOST_CHECK_EQUAL(1u, signed_by(wm.sign_transaction(trx, {pub1}, chain_id)).count(pub1));
+
+   wm.lock("test");
+   BOOST_CHECK_THROW(wm.sign_transaction(trx, {pub1}, chain_id), chain::wallet_missing_pub_key_exception);
+   wm.unlock("test", pw);
+   BOOST_CHECK_EQUAL(1u, signed_by(wm.sign_transaction(trx, {pub1}, chain_id)).count(pub1));
+
+   BOOST_CHECK_THROW(wm.sign_transaction(trx, {pub2}, chain_id), chain::wallet_missing_pub_key_exception);
+   wm.import_key("test", key2);
+   BOOST_CHECK_EQUAL(1u, signed_by(wm.sign_transaction(trx, {pub2}, chain_id)).count(pub2));
+
+   wm.remove_key("test", pw, string(pub2));
+   BOOST_CHECK_THROW(wm.sign_transaction(trx, {pub2}, chain_id), chain::wallet_missing_pub_key_exception);
+
+   public_key_type created(wm.create_key("test", "K1"));
+   BOOST_CHECK_EQUAL(1u, signed_by(wm.sign_transaction(trx, {created}, chain_id)).count(created));
+
+   // transactions are signed in parallel
+   wm.set_signing_threads(2);
+
+   std::vector<wallet_manager::signing_request> batch;
+   for (int i = 0; i < 4; ++i) {
+      chain::signed_transaction t;
+      t.ref_block_num = i;
+      batch.emplace_back(t, flat_set<public_key_type>{pub1, created});
+   }
+
+   auto signed_batch = wm.sign_transactions(batch, chain_id);
+   BOOST_REQUIRE_EQUAL(batch.size(), signed_batch.size());
+   for (size_t i = 0; i < batch.size(); ++i) {
+      BOOST_CHECK_EQUAL(batch[i].first.ref_block_num, signed_batch[i].ref_block_num);
+      BOOST_CHECK(signed_by(signed_batch[i]) == (flat_set<public_key_type>{pub1, created}));
+   }
+
+   // key3 isn't in the wallet, so no transaction of the batch is signed
+   batch[2].second.insert(pub3);
+   signed_batch.clear();
+   BOOST_CHECK_THROW(signed_batch = wm.sign_transactions(batch, chain_id), chain::wallet_missing_pub_key_exception);
+   BOOST_CHECK(signed_batch.empty());
+   for (const auto& r : batch) {
+      BOOST_CHECK(r.first.signatures.empty());
+   }
+
+   wm.lock("test");
+   batch[2].second.erase(pub3);
+   BOOST_CHECK_THROW(wm.sign_transactions(batch, chain_id), chain::wallet_missing_pub_key_exception);
+
+   fc::remove("test.wallet");
+
+} FC_LOG_AND_RETHROW() }
+
+/// Wallet which lists the keys it is given, but never signs with them
+struct refusing_wallet : eosio::wallet::wallet_api {
+   explicit refusing_wallet(flat_set<public_key_type> keys) : keys(std::move(keys)) {}
+
+   private_key_type get_private_key(public_key_type) const override { FC_THROW("not supported"); }
+   bool is_locked() const override { return false; }
+   void lock() override {}
+   void unlock(string) override {}
+   void check_password(string) override {}
+   void set_password(string) override {}
+   map<public_key_type, private_key_type> list_keys() override { return {}; }
+   flat_set<public_key_type> list_public_keys() override { return keys; }
+   bool import_key(string) override { return false; }
+   bool remove_key(string) override { return false; }
+   string create_key(string) override { return {}; }
+   fc::optional<signature_type> try_sign_digest(const digest_type, const public_key_type) override { return {}; }
+
+   flat_set<public_key_type> keys;
+};
+
+/// Test that signing falls back to other unlocked wallets when the indexed wallet doesn't sign
+BOOST_AUTO_TEST_CASE(wallet_manager_sign_fallback_test)
+{ try {
+   using namespace eosio::wallet;
+
+   if (fc::exists("test.wallet")) fc::remove("test.wallet");
+
+   constexpr auto key1 = "5JktVNHnRX48BUdtewU7N1CyL4Z886c42x7wYW7XhNWkDQRhdcS";
+   const public_key_type pub1 = private_key_type(std::string(key1)).get_public_key();
+   const auto chain_id = genesis_state().compute_chain_id();
+   const chain::signed_transaction trx;
+
+   wallet_manager wm;
+   wm.create("test");
+   wm.import_key("test", key1);
+   // the first wallet in order of names gets the key in the index
+   wm.own_and_use_wallet("a_refusing", std::make_unique<refusing_wallet>(flat_set<public_key_type>{pub1}));
+
+   flat_set<public_key_type> pks;
+   wm.sign_transaction(trx, {pub1}, chain_id).get_signature_keys(chain_id, fc::time_point::maximum(), pks);
+   BOOST_CHECK_EQUAL(1u, pks.count(pub1));
+
+   const auto digest = trx.sig_digest(chain_id, trx.context_free_data);
+   BOOST_CHECK(public_key_type(wm.sign_digest(digest, pub1), digest) == pub1);
+
+   wm.lock("test");
+   BOOST_CHECK_THROW(wm.sign_transaction(trx, {pub1}, chain_id), chain::wallet_missing_pub_key_exception);
+   BOOST_CHECK_THROW(wm.sign_digest(digest, pub1), chain::wallet_missing_pub_key_exception);
+
+   fc::remove("test.wallet");
+
+} FC_LOG_AND_RETHROW() }
+
 /// Test wallet manager
 BOOST_AUTO_TEST_CASE(wallet_manager_create_test) {
    try {
@@ -1115,6 +1115,12 @@ class Node(object):
                 Utils.Print("ERROR: Exception during push message.  cmd Duration=%.3f sec.  %s" % (end - start, msg))
             return (False, msg)
 
+    # pushes signed transactions in one request, returns the result of each transaction in the same order
+    def pushTransactions(self, trxs, silentErrors=False, exitOnError=False):
+        cmd="curl %s/v1/chain/push_transactions -d '%s' -X POST -H \"Content-Type: application/json\"" % \
+            (self.endpointHttp, json.dumps(trxs))
+        return self.sendCurlCmd(cmd, silentErrors=silentErrors, exitOnError=exitOnError, exitMsg="push transactions")
+
     def setPermission(self, account, code, pType, requirement, waitForTransBlock=False, exitOnError=False):
         cmdDesc="set action permission"
         cmd="%s -j %s %s %s %s" % (cmdDesc, account, code, pType, requirement)
@@ -428,6 +428,32 @@ try:
     if not dupRejected:
         errorExit("Failed to reject duplicate message for currency1111 contract")
 
+    Print("push a batch of transfers to currency1111 contract with an expired transaction in the middle")
+    batch=[]
+    batchAmounts=[1, 2, 3]
+    for amount in batchAmounts:
+        data="{\"from\":\"currency1111\",\"to\":\"defproducera\",\"quantity\":"
+        data +="\"0.000%s CUR\",\"memo\":\"batch\"}" % (amount)
+        opts="--permission currency1111@active --dont-broadcast"
+        trans=node.pushMessage(contract, action, data, opts)
+        if trans is None or not trans[0]:
+            cmdError("%s push message currency1111 transfer" % (ClientName))
+            errorExit("Failed to sign transfer for currency1111 contract")
+        batch.append(trans[1])
+    batch[1]["expiration"]="2000-01-01T00:00:00"
+    totalTransfer+=batchAmounts[0]+batchAmounts[2]
+
+    results=node.pushTransactions(batch, exitOnError=True)
+    if results is None or len(results) != len(batch):
+        errorExit("Failed to push batch of transfers, results: %s" % (results))
+    for idx, res in enumerate(results):
+        error=res["processed"].get("error") if isinstance(res["processed"], dict) else None
+        if (idx == 1) != (error is not None):
+            errorExit("Unexpected result of transaction %d in batch: %s" % (idx, res))
+    if "expired" not in results[1]["processed"]["error"]:
+        errorExit("Expired transaction in batch failed with unexpected error: %s" % (results[1]))
+    transId=results[2]["transaction_id"]
+
     Print("verify transaction exists")
     if not node.waitForTransInBlock(transId):
         cmdError("%s get transaction trans_id" % (ClientName))